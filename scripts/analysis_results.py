@@ -5,12 +5,21 @@ import matplotlib.pyplot as plt
 # --- Conexión a la base de datos SQLite ---
 conn = sqlite3.connect("resultados.db")
 
-# --- Leer la tabla de resultados ---
-df = pd.read_sql_query("SELECT id, fecha, accuracy, f1_macro, kappa, modelo FROM resultados", conn)
+# --- Folds de la última corrida con folds en resultados_fold (indexada por run_id) ---
+# Las corridas multi-semilla solo escriben resultados_semillas: se saltean
+df = pd.read_sql_query(
+    "SELECT f.id, f.fecha, f.repeticion, f.fold, f.accuracy, f.f1_macro, f.kappa, f.modelo_hash "
+    "FROM resultados_fold f "
+    "WHERE f.tipo = 'fold' AND f.run_id = (SELECT c.run_id FROM corridas c WHERE EXISTS "
+    "(SELECT 1 FROM resultados_fold r WHERE r.run_id = c.run_id AND r.tipo = 'fold') "
+    "ORDER BY c.fecha_inicio DESC LIMIT 1) "
+    "ORDER BY f.repeticion, f.fold", conn)
 conn.close()
-
-# --- Asegurar orden por ID (folds) ---
-df = df.sort_values("id").reset_index(drop=True)
+if df.empty:
+    print("No hay resultados por fold en la base de datos.")
+    exit()
+df = df.reset_index(drop=True)
+etiquetas = [f"r{r}_f{f}" if r > 0 else str(f) for r, f in zip(df["repeticion"], df["fold"])]
 
 # --- Mostrar resumen tabular ---
 print("\nResumen de resultados por fold:")
@@ -28,7 +37,7 @@ plt.bar([i + bar_width for i in x], df["kappa"], width=bar_width, label="Kappa")
 plt.xlabel("Fold")
 plt.ylabel("Score")
 plt.title("Accuracy, F1 Macro y Kappa por Fold")
-plt.xticks(ticks=x, labels=df["id"])
+plt.xticks(ticks=x, labels=etiquetas)
 plt.legend()
 plt.tight_layout()
 plt.savefig("metricas_por_fold.png")
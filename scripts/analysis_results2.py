@@ -6,9 +6,16 @@ import seaborn as sns
 # Conexión a SQLite
 conn = sqlite3.connect("resultados.db")
 
-# Leer tabla resultados
-df = pd.read_sql_query("SELECT * FROM resultados ORDER BY id ASC", conn)
+# Una fila por corrida desde la vista leaderboard (agregados mantenidos al insertar),
+# limitada a las últimas corridas para no recorrer todo el historial
+MAX_CORRIDAS = 200
+df = pd.read_sql_query(
+    "SELECT * FROM (SELECT run_id, experimento, fecha_inicio, folds, media_accuracy AS accuracy, "
+    "media_f1 AS f1_macro, media_kappa AS kappa, var_kappa, holdout_kappa FROM leaderboard "
+    "ORDER BY fecha_inicio DESC LIMIT ?) ORDER BY fecha_inicio ASC", conn, params=(MAX_CORRIDAS,))
 conn.close()
+df["std_kappa"] = df["var_kappa"].clip(lower=0) ** 0.5
+df = df.drop(columns=["var_kappa"]).reset_index(drop=True)
 
 if df.empty:
     print("No hay resultados en la base de datos.")
@@ -16,16 +23,16 @@ if df.empty:
 
 # Mostrar tabla
 print("\n=== Resultados disponibles ===")
-print(df[["id", "fecha", "accuracy", "f1_macro", "kappa", "modelo", "config"]])
+print(df[["run_id", "experimento", "fecha_inicio", "folds", "accuracy", "f1_macro", "kappa", "std_kappa", "holdout_kappa"]])
 
 # --- Gráfico de evolución temporal ---
 plt.figure(figsize=(10, 5))
-plt.plot(df["id"], df["accuracy"], marker='o', label="Accuracy")
-plt.plot(df["id"], df["f1_macro"], marker='s', label="F1 Macro")
-plt.plot(df["id"], df["kappa"], marker='^', label="Kappa")
-plt.xlabel("ID de Experimento")
+plt.plot(df.index, df["accuracy"], marker='o', label="Accuracy")
+plt.plot(df.index, df["f1_macro"], marker='s', label="F1 Macro")
+plt.plot(df.index, df["kappa"], marker='^', label="Kappa")
+plt.xlabel("Corrida (orden cronológico)")
 plt.ylabel("Métrica")
-plt.title("Evolución de Accuracy, F1 Macro y Kappa")
+plt.title("Evolución de Accuracy, F1 Macro y Kappa (media de folds)")
 plt.legend()
 plt.grid(True)
 plt.tight_layout()
@@ -33,22 +40,22 @@ plt.savefig("evolucion_metricas.png")
 plt.close()
 
 # --- Ranking por Kappa (además del anterior por F1) ---
-df_sorted_kappa = df.sort_values(by="kappa", ascending=False)
+df_sorted_kappa = df.sort_values(by="kappa", ascending=False).head(20)
 plt.figure(figsize=(10, 6))
-sns.barplot(data=df_sorted_kappa, x="kappa", y="modelo", palette="magma")
+sns.barplot(data=df_sorted_kappa, x="kappa", y="run_id", palette="magma")
 plt.xlabel("Kappa")
-plt.ylabel("Modelo")
+plt.ylabel("Corrida")
 plt.title("Ranking de Experimentos por Kappa")
 plt.tight_layout()
 plt.savefig("ranking_kappa.png")
 plt.close()
 
 # --- Ranking por F1 Macro (original) ---
-df_sorted_f1 = df.sort_values(by="f1_macro", ascending=False)
+df_sorted_f1 = df.sort_values(by="f1_macro", ascending=False).head(20)
 plt.figure(figsize=(10, 6))
-sns.barplot(data=df_sorted_f1, x="f1_macro", y="modelo", palette="viridis")
+sns.barplot(data=df_sorted_f1, x="f1_macro", y="run_id", palette="viridis")
 plt.xlabel("F1 Macro")
-plt.ylabel("Modelo")
+plt.ylabel("Corrida")
 plt.title("Ranking de Experimentos por F1 Macro")
 plt.tight_layout()
 plt.savefig("ranking_f1_macro.png")
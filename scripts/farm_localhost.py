@@ -0,0 +1,43 @@
+# farm_localhost.py
+# Prueba de humo del modo coordinador/worker en una sola máquina: lanza workers
+# y un coordinador sobre una cola nueva y verifica que todos los procesos
+# terminen bien y que cada trabajo de la cola quede completo.
+# Uso (desde el directorio del ejecutable): python farm_localhost.py <PetFinderLGBM> [workers]
+import os
+import sqlite3
+import subprocess
+import sys
+import tempfile
+
+exe = os.path.abspath(sys.argv[1])
+num_workers = int(sys.argv[2]) if len(sys.argv) > 2 else 2
+
+queue_db = os.path.join(tempfile.mkdtemp(prefix="petfinder_farm_"), "cola_trabajos.db")
+common = [f"queue_db={queue_db}", "lease_seconds=15"]
+
+workers = [subprocess.Popen([exe, "--worker", "worker_idle_exit=30", *common]) for _ in range(num_workers)]
+coordinator = subprocess.run([exe, "--coordinator", "final_model=no", "stage_cache=0", "farm_wait_timeout=120", *common])
+worker_codes = [w.wait(timeout=600) for w in workers]
+
+con = sqlite3.connect(queue_db)
+jobs = con.execute("SELECT nombre, estado, worker FROM cola_trabajos ORDER BY id").fetchall()
+con.close()
+
+errors = []
+if coordinator.returncode != 0:
+    errors.append(f"el coordinador termino con codigo {coordinator.returncode}")
+for i, code in enumerate(worker_codes):
+    if code != 0:
+        errors.append(f"el worker {i} termino con codigo {code}")
+if not jobs:
+    errors.append("el coordinador no publico trabajos")
+for name, estado, worker in jobs:
+    if estado != "completo":
+        errors.append(f"{name}: {estado}")
+
+print(f"[FARM] {len(jobs)} trabajos | workers usados: {len({w for _, _, w in jobs if w})}")
+if errors:
+    for e in errors:
+        print(f"[ERROR] {e}")
+    sys.exit(1)
+print("[OK] coordinador y workers terminaron bien")
@@ -1,9 +1,15 @@
 ﻿#include "database.hpp"
+#include "trace.hpp"
+#include "model_registry.hpp"
+#include <algorithm>
 #include <iostream>
+#include <cstdio>
 #include <fstream>
 #include <ctime>
 #include <sqlite3.h>
 #include <filesystem>
+#include <functional>
+#include <initializer_list>
 
 // Códigos ANSI para color
 #define RESET   "\033[0m"
@@ -18,176 +24,223 @@
 using namespace std;
 namespace fs = std::filesystem;
 
-// Insertar resultados en la base de datos SQLite
-int insert_result_sqlite(double acc, double f1, double kappa, const string& model_path, const string& conf_path, const string& config_str) {
-	sqlite3* db;
-	char* errMsg = nullptr;
-	int rc = sqlite3_open("resultados.db", &db);
-	if (rc) {
-		cerr << "No se puede abrir la base de datos: " << sqlite3_errmsg(db) << endl;
-		return -1;
+namespace {
+	const char* const RESULTS_DB = "resultados.db";
+
+	string now_text() {
+		time_t now = time(0);
+		string fecha = string(ctime(&now));
+		fecha.pop_back(); // quitar salto de línea
+		return fecha;
 	}
 
-	const char* create_sql = "CREATE TABLE IF NOT EXISTS resultados ("
-		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
-		"fecha TEXT, "
-		"accuracy REAL, "
-		"f1_macro REAL, "
-		"kappa REAL, "
-		"modelo TEXT, "
-		"config TEXT, "
-		"config_text TEXT);";
-	sqlite3_exec(db, create_sql, 0, 0, &errMsg);
+	// Conexión a la base con espera ante locks de otros procesos y el esquema ya creado
+	class SqliteConnection {
+	public:
+		explicit SqliteConnection(const char* schema_sql, const string& path = RESULTS_DB,
+			int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE) {
+			if (sqlite3_open_v2(path.c_str(), &db_, flags, nullptr) != SQLITE_OK) {
+				cerr << "No se puede abrir la base de datos: " << sqlite3_errmsg(db_) << endl;
+				sqlite3_close(db_);
+				db_ = nullptr;
+				return;
+			}
+			sqlite3_busy_timeout(db_, 5000);
+			char* err = nullptr;
+			if (schema_sql && sqlite3_exec(db_, schema_sql, nullptr, nullptr, &err) != SQLITE_OK) {
+				cerr << "Error al crear las tablas: " << (err ? err : sqlite3_errmsg(db_)) << endl;
+			}
+			sqlite3_free(err);
+		}
+		~SqliteConnection() { sqlite3_close(db_); }
+		SqliteConnection(const SqliteConnection&) = delete;
+		SqliteConnection& operator=(const SqliteConnection&) = delete;
 
-	time_t now = time(0);
-	string fecha = string(ctime(&now));
-	fecha.pop_back(); // quitar salto de línea
+		explicit operator bool() const { return db_ != nullptr; }
+		operator sqlite3*() const { return db_; }
 
-	string sql = "INSERT INTO resultados (fecha, accuracy, f1_macro, kappa, modelo, config, config_text) VALUES (?, ?, ?, ?, ?, ?, ?);";
-	sqlite3_stmt* stmt;
-	sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-	sqlite3_bind_text(stmt, 1, fecha.c_str(), -1, SQLITE_STATIC);
-	sqlite3_bind_double(stmt, 2, acc);
-	sqlite3_bind_double(stmt, 3, f1);
-	sqlite3_bind_double(stmt, 4, kappa);
-	sqlite3_bind_text(stmt, 5, model_path.c_str(), -1, SQLITE_STATIC);
-	sqlite3_bind_text(stmt, 6, conf_path.c_str(), -1, SQLITE_STATIC);
-	sqlite3_bind_text(stmt, 7, config_str.c_str(), -1, SQLITE_STATIC);
+	private:
+		sqlite3* db_ = nullptr;
+	};
 
-	int id_resultado = -1;
-	rc = sqlite3_step(stmt);
-	if (rc == SQLITE_DONE) {
-		id_resultado = static_cast<int>(sqlite3_last_insert_rowid(db));
+	// Sentencia preparada que se finaliza sola al salir del bloque
+	class Statement {
+	public:
+		Statement(sqlite3* db, const char* sql) {
+			if (sqlite3_prepare_v2(db, sql, -1, &stmt_, nullptr) != SQLITE_OK) {
+				cerr << "Error al preparar la consulta: " << sqlite3_errmsg(db) << endl;
+				stmt_ = nullptr;
+			}
+		}
+		~Statement() { sqlite3_finalize(stmt_); }
+		Statement(const Statement&) = delete;
+		Statement& operator=(const Statement&) = delete;
+
+		explicit operator bool() const { return stmt_ != nullptr; }
+		operator sqlite3_stmt*() const { return stmt_; }
+
+	private:
+		sqlite3_stmt* stmt_ = nullptr;
+	};
+
+	// Ejecuta la sentencia ya enlazada y la deja lista para la próxima fila
+	bool step_row(sqlite3* db, sqlite3_stmt* stmt, const char* what) {
+		bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+		if (!ok) cerr << "Error al insertar " << what << ": " << sqlite3_errmsg(db) << endl;
+		sqlite3_reset(stmt);
+		return ok;
 	}
-	else {
-		cerr << "Error al insertar resultado: " << sqlite3_errmsg(db) << endl;
+
+	// Reemplaza las filas de la corrida en una transacción: al reanudarla se borran las de la
+	// ejecución interrumpida y las nuevas quedan todas o ninguna. Cada DELETE recibe run_id
+	// en ?1 y, si lo usa, scope en ?2.
+	bool replace_run_rows(sqlite3* db, initializer_list<const char*> delete_sql, const string& run_id,
+		const function<bool()>& insert, const string& scope = string()) {
+		if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+			cerr << "No se pudo iniciar la transacción: " << sqlite3_errmsg(db) << endl;
+			return false;
+		}
+		bool ok = true;
+		for (const char* sql : delete_sql) {
+			Statement del(db, sql);
+			if (!del) { ok = false; break; }
+			sqlite3_bind_text(del, 1, run_id.c_str(), -1, SQLITE_STATIC);
+			if (sqlite3_bind_parameter_count(del) > 1) sqlite3_bind_text(del, 2, scope.c_str(), -1, SQLITE_STATIC);
+			if (!step_row(db, del, "(borrado previo)")) { ok = false; break; }
+		}
+		ok = ok && insert();
+		sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+		return ok;
 	}
-	sqlite3_finalize(stmt);
-	sqlite3_close(db);
-	return id_resultado;
 }
 
-// Insertar predicciones en la base de datos SQLite
-void insert_predictions_sqlite(const vector<int>& y_true, const vector<int>& y_pred, int result_id) {
-	sqlite3* db;
-	sqlite3_open("resultados.db", &db);
-
-	const char* create_sql = "CREATE TABLE IF NOT EXISTS predicciones ("
+// Insertar resultados y sus predicciones en la base de datos SQLite, en una sola transacción
+int insert_result_sqlite(double acc, double f1, double kappa, const string& model_path, const string& conf_path, const string& config_str,
+	const vector<int>& y_true, const vector<int>& y_pred, const string& run_id) {
+	TraceSpan span("sqlite_insertar_resultado", "sqlite");
+	SqliteConnection db("CREATE TABLE IF NOT EXISTS resultados ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"fecha TEXT, "
+		"accuracy REAL, "
+		"f1_macro REAL, "
+		"kappa REAL, "
+		"modelo TEXT, "
+		"config TEXT, "
+		"config_text TEXT, "
+		"run_id TEXT);"
+		"CREATE TABLE IF NOT EXISTS predicciones ("
 		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
 		"id_resultado INTEGER, "
 		"indice INTEGER, "
 		"y_true INTEGER, "
-		"y_pred INTEGER);";
-	sqlite3_exec(db, create_sql, 0, 0, nullptr);
+		"y_pred INTEGER);");
+	if (!db) return -1;
+	ensure_column(db, "resultados", "run_id", "TEXT");
+	ensure_results_indexes(db);
 
-	const char* insert_sql = "INSERT INTO predicciones (id_resultado, indice, y_true, y_pred) VALUES (?, ?, ?, ?);";
-	sqlite3_stmt* stmt;
-	sqlite3_prepare_v2(db, insert_sql, -1, &stmt, nullptr);
+	string fecha = now_text();
+	int id_resultado = -1;
+	// Una evaluación que se repite al reanudar la corrida reemplaza a la parcial anterior
+	bool ok = replace_run_rows(db, {
+			"DELETE FROM predicciones WHERE id_resultado IN (SELECT id FROM resultados WHERE run_id = ?1 AND modelo = ?2);",
+			"DELETE FROM resultados WHERE run_id = ?1 AND modelo = ?2;" },
+		run_id, [&] {
+			Statement stmt(db, "INSERT INTO resultados (fecha, accuracy, f1_macro, kappa, modelo, config, config_text, run_id) "
+				"VALUES (?, ?, ?, ?, ?, ?, ?, ?);");
+			if (!stmt) return false;
+			sqlite3_bind_text(stmt, 1, fecha.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_double(stmt, 2, acc);
+			sqlite3_bind_double(stmt, 3, f1);
+			sqlite3_bind_double(stmt, 4, kappa);
+			sqlite3_bind_text(stmt, 5, model_path.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 6, conf_path.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 7, config_str.c_str(), -1, SQLITE_STATIC);
+			if (run_id.empty()) sqlite3_bind_null(stmt, 8);
+			else sqlite3_bind_text(stmt, 8, run_id.c_str(), -1, SQLITE_STATIC);
+			if (!step_row(db, stmt, "resultado")) return false;
+			id_resultado = static_cast<int>(sqlite3_last_insert_rowid(db));
 
-	for (size_t i = 0; i < y_true.size(); ++i) {
-		sqlite3_bind_int(stmt, 1, result_id);
-		sqlite3_bind_int(stmt, 2, static_cast<int>(i));
-		sqlite3_bind_int(stmt, 3, y_true[i]);
-		sqlite3_bind_int(stmt, 4, y_pred[i]);
+			Statement pred(db, "INSERT INTO predicciones (id_resultado, indice, y_true, y_pred) VALUES (?, ?, ?, ?);");
+			if (!pred) return false;
+			for (size_t i = 0; i < y_true.size(); ++i) {
+				sqlite3_bind_int(pred, 1, id_resultado);
+				sqlite3_bind_int(pred, 2, static_cast<int>(i));
+				sqlite3_bind_int(pred, 3, y_true[i]);
+				sqlite3_bind_int(pred, 4, y_pred[i]);
+				if (!step_row(db, pred, "prediccion")) return false;
+			}
+			return true;
+		}, model_path);
+	return ok ? id_resultado : -1;
+}
 
-		if (sqlite3_step(stmt) != SQLITE_DONE) {
-			cerr << "Error insertando prediccion: " << sqlite3_errmsg(db) << endl;
+// Promueve al alias el resultado con mayor valor de la métrica (order_column de resultados)
+static void promote_best_result(const string& db_path, const char* order_column, const string& alias) {
+	ModelLineage lineage;
+	string model_path, hash;
+	bool found = false;
+	{
+		SqliteConnection db(nullptr, db_path);
+		if (!db) return;
+		ensure_column(db, "resultados", "modelo_hash", "TEXT");
+		ensure_column(db, "resultados", "run_id", "TEXT");
+
+		string sql = string("SELECT id, modelo, config, run_id, accuracy, f1_macro, kappa, modelo_hash FROM resultados "
+			"ORDER BY ") + order_column + " DESC LIMIT 1;";
+		Statement stmt(db, sql.c_str());
+		if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+			auto text = [&](int col) {
+				const unsigned char* value = sqlite3_column_text(stmt, col);
+				return value ? string(reinterpret_cast<const char*>(value)) : string();
+			};
+			lineage.id_resultado = sqlite3_column_int(stmt, 0);
+			model_path = text(1);
+			lineage.config_path = text(2);
+			lineage.run_id = text(3);
+			lineage.accuracy = sqlite3_column_double(stmt, 4);
+			lineage.f1_macro = sqlite3_column_double(stmt, 5);
+			lineage.kappa = sqlite3_column_double(stmt, 6);
+			hash = text(7);
+			found = true;
 		}
-		sqlite3_reset(stmt);
 	}
 
-	sqlite3_finalize(stmt);
-	sqlite3_close(db);
+	if (!found) {
+		cerr << "Error al seleccionar mejor modelo (" << alias << ")." << endl;
+		return;
+	}
+	// Filas anteriores al registro no tienen hash: se registra el archivo tal como está hoy
+	if (hash.empty() || !fs::exists(registry_object_path(hash))) {
+		hash = registry_store_model(model_path, lineage, db_path);
+	}
+	registry_promote(alias, hash, lineage, db_path);
 }
 
 // Guardar el mejor modelo basado en F1 macro
 void save_best_model(const std::string& db_path) {
-	sqlite3* db;
-	sqlite3_open("resultados.db", &db);
-
-	const char* create_best_sql = "CREATE TABLE IF NOT EXISTS mejor_modelo ("
-		"id INTEGER PRIMARY KEY, modelo TEXT, id_resultado INTEGER, es_final INTEGER DEFAULT 0, configuracion TEXT);";
-	sqlite3_exec(db, create_best_sql, nullptr, nullptr, nullptr);
-
-	const char* best_sql = "SELECT id, modelo FROM resultados ORDER BY f1_macro DESC LIMIT 1;";
-	sqlite3_stmt* stmt;
-	if (sqlite3_prepare_v2(db, best_sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
-		int best_id = sqlite3_column_int(stmt, 0);
-		string best_model = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-		fs::copy_file(best_model, "best_model.txt", fs::copy_options::overwrite_existing);
-		sqlite3_finalize(stmt);
-
-		const char* insert_best_sql = "INSERT OR REPLACE INTO mejor_modelo (id, modelo, id_resultado) VALUES (1, ?, ?);";
-		if (sqlite3_prepare_v2(db, insert_best_sql, -1, &stmt, nullptr) == SQLITE_OK) {
-			sqlite3_bind_text(stmt, 1, best_model.c_str(), -1, SQLITE_STATIC);
-			sqlite3_bind_int(stmt, 2, best_id);
-			sqlite3_step(stmt);
-			sqlite3_finalize(stmt);
-		}
-	}
-	else {
-		cerr << "Error al seleccionar mejor modelo." << endl;
-	}
-	sqlite3_close(db);
+	TraceSpan span("sqlite_mejor_modelo_f1", "sqlite");
+	promote_best_result(db_path, "f1_macro", "best_f1");
 }
 
 // Guardar el mejor modelo basado en Kappa
 void save_best_model_by_kappa() {
-	sqlite3* db;
-	sqlite3_open("resultados.db", &db);
-
-	const char* query = "SELECT id, modelo FROM resultados ORDER BY kappa DESC LIMIT 1;";
-	sqlite3_stmt* stmt;
-	if (sqlite3_prepare_v2(db, query, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
-		string modelo = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-		fs::copy_file(modelo, "mejor_modelo_kappa.txt", fs::copy_options::overwrite_existing);
-	}
-	else {
-		cerr << "Error seleccionando mejor modelo por kappa." << endl;
-	}
-	sqlite3_finalize(stmt);
-	sqlite3_close(db);
+	TraceSpan span("sqlite_mejor_modelo_kappa", "sqlite");
+	promote_best_result(RESULTS_DB, "kappa", "best_kappa");
 }
 
 // Guardar el modelo final en la base de datos
-void save_final_model(const std::string& db_path, const std::string& model_path, const std::string& config_path) {
-	sqlite3* db;
-	if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
-		std::cerr << "No se pudo abrir la base de datos." << std::endl;
+void save_final_model(const std::string& db_path, const std::string& model_path, const std::string& config_path,
+	const std::string& run_id) {
+	TraceSpan span("sqlite_modelo_final", "sqlite");
+	ModelLineage lineage;
+	lineage.run_id = run_id;
+	lineage.config_path = config_path;
+	string hash = registry_store_model(model_path, lineage, db_path);
+	if (hash.empty() || !registry_promote("final", hash, lineage, db_path)) {
+		cerr << "Error al registrar el modelo final." << endl;
 		return;
 	}
-
-	const char* create_table_sql = R"(
-	CREATE TABLE IF NOT EXISTS mejor_modelo (
-		id INTEGER PRIMARY KEY,
-		modelo TEXT NOT NULL,
-		id_resultado INTEGER,
-		es_final INTEGER DEFAULT 0,
-		configuracion TEXT
-	);)";
-	sqlite3_exec(db, create_table_sql, nullptr, nullptr, nullptr);
-
-	// Copiar el modelo final a "modelo_final.txt"
-	std::filesystem::copy_file(model_path, "modelo_final.txt", std::filesystem::copy_options::overwrite_existing);
-
-	// Insertar o reemplazar el modelo final
-	const char* insert_sql = R"(
-	INSERT OR REPLACE INTO mejor_modelo (id, modelo, id_resultado, es_final, configuracion)
-	VALUES (1, ?, NULL, 1, ?);
-	)";
-	sqlite3_stmt* stmt;
-	if (sqlite3_prepare_v2(db, insert_sql, -1, &stmt, nullptr) == SQLITE_OK) {
-		sqlite3_bind_text(stmt, 1, model_path.c_str(), -1, SQLITE_STATIC);
-		sqlite3_bind_text(stmt, 2, config_path.c_str(), -1, SQLITE_STATIC);
-		sqlite3_step(stmt);
-		sqlite3_finalize(stmt);
-	}
-	else {
-		cerr << "Error al preparar el INSERT del modelo final: " << sqlite3_errmsg(db) << endl;
-	}
-
-	sqlite3_close(db);
-	cout << MAGENTA << "📁 Modelo final guardado en: " << db_path << RESET << endl;
+	cout << MAGENTA << "📁 Modelo final registrado: " << registry_alias_path("final").string() << " (" << db_path << ")" << RESET << endl;
 }
 
 // Verificar si una tabla existe en la base de datos SQLite
@@ -218,3 +271,649 @@ bool sqlite_table_exists(const std::string& db_path, const std::string& table_na
 	return exists;
 }
 
+
+// Agrega una columna si la tabla (creada por una versión anterior) no la tiene
+void ensure_column(sqlite3* db, const string& table, const string& column, const string& type) {
+	string pragma = "PRAGMA table_info(" + table + ");";
+	sqlite3_stmt* stmt;
+	bool found = false;
+	if (sqlite3_prepare_v2(db, pragma.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+		while (sqlite3_step(stmt) == SQLITE_ROW) {
+			const unsigned char* name = sqlite3_column_text(stmt, 1);
+			if (name && column == reinterpret_cast<const char*>(name)) found = true;
+		}
+		sqlite3_finalize(stmt);
+	}
+	if (!found) {
+		string alter = "ALTER TABLE " + table + " ADD COLUMN " + column + " " + type + ";";
+		sqlite3_exec(db, alter.c_str(), nullptr, nullptr, nullptr);
+	}
+}
+
+// Índices de resultados y predicciones: mejor modelo por métrica, reemplazo al reanudar
+// y predicciones de un resultado. Requiere la columna run_id (ensure_column).
+void ensure_results_indexes(sqlite3* db) {
+	sqlite3_exec(db,
+		"CREATE INDEX IF NOT EXISTS idx_resultados_f1 ON resultados (f1_macro DESC);"
+		"CREATE INDEX IF NOT EXISTS idx_resultados_kappa ON resultados (kappa DESC);"
+		"CREATE INDEX IF NOT EXISTS idx_resultados_run ON resultados (run_id, modelo);"
+		"CREATE INDEX IF NOT EXISTS idx_predicciones_resultado ON predicciones (id_resultado);",
+		nullptr, nullptr, nullptr);
+}
+
+// Registrar recursos de un proceso hijo (LightGBM / Python)
+void insert_process_stats_sqlite(const string& run_id, int fold, const string& phase,
+	const string& command, const ProcessStats& stats, uint64_t data_bytes, int repeat, int seed) {
+	TraceSpan span("sqlite_insertar_recursos", "sqlite");
+	SqliteConnection db("CREATE TABLE IF NOT EXISTS recursos_procesos ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"fecha TEXT, "
+		"fold INTEGER, "
+		"fase TEXT, "
+		"comando TEXT, "
+		"exit_code INTEGER, "
+		"wall_ms REAL, "
+		"user_ms REAL, "
+		"sys_ms REAL, "
+		"peak_rss_mb REAL, "
+		"io_read_bytes INTEGER, "
+		"io_write_bytes INTEGER, "
+		"data_bytes INTEGER, "
+		"repeticion INTEGER, "
+		"semilla INTEGER);");
+	if (!db) return;
+	ensure_column(db, "recursos_procesos", "data_bytes", "INTEGER");
+	ensure_column(db, "recursos_procesos", "repeticion", "INTEGER");
+	ensure_column(db, "recursos_procesos", "semilla", "INTEGER");
+
+	string fecha = now_text();
+	Statement stmt(db, "INSERT INTO recursos_procesos (run_id, fecha, fold, fase, comando, exit_code, "
+		"wall_ms, user_ms, sys_ms, peak_rss_mb, io_read_bytes, io_write_bytes, data_bytes, repeticion, semilla) "
+		"VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+	if (!stmt) return;
+	sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+	if (fold >= 0) sqlite3_bind_int(stmt, 3, fold);
+	else sqlite3_bind_null(stmt, 3);
+	sqlite3_bind_text(stmt, 4, phase.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 5, command.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_int(stmt, 6, stats.exit_code);
+	sqlite3_bind_double(stmt, 7, stats.wall_ms);
+	sqlite3_bind_double(stmt, 8, stats.user_ms);
+	sqlite3_bind_double(stmt, 9, stats.sys_ms);
+	sqlite3_bind_double(stmt, 10, stats.peak_rss_bytes / (1024.0 * 1024.0));
+	sqlite3_bind_int64(stmt, 11, static_cast<sqlite3_int64>(stats.io_read_bytes));
+	sqlite3_bind_int64(stmt, 12, static_cast<sqlite3_int64>(stats.io_write_bytes));
+	sqlite3_bind_int64(stmt, 13, static_cast<sqlite3_int64>(data_bytes));
+	sqlite3_bind_int(stmt, 14, repeat);
+	if (seed >= 0) sqlite3_bind_int(stmt, 15, seed);
+	else sqlite3_bind_null(stmt, 15);
+	step_row(db, stmt, "recursos");
+}
+
+// Guarda la evaluación del meta-modelo de stacking junto a la del modelo base
+void insert_stacking_result_sqlite(const StackingRecord& r) {
+	TraceSpan span("sqlite_insertar_stacking", "sqlite");
+	SqliteConnection db("CREATE TABLE IF NOT EXISTS resultados_stacking ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"fecha TEXT, "
+		"modelo TEXT, "
+		"filas_oof INTEGER, "
+		"clases INTEGER, "
+		"l2 REAL, "
+		"iteraciones INTEGER, "
+		"logloss_oof REAL, "
+		"logloss_meta REAL, "
+		"accuracy_base REAL, "
+		"f1_base REAL, "
+		"kappa_base REAL, "
+		"accuracy_meta REAL, "
+		"f1_meta REAL, "
+		"kappa_meta REAL);");
+	if (!db) return;
+
+	string fecha = now_text();
+	replace_run_rows(db, { "DELETE FROM resultados_stacking WHERE run_id = ?1;" }, r.run_id, [&] {
+		Statement stmt(db, "INSERT INTO resultados_stacking (run_id, fecha, modelo, filas_oof, clases, l2, "
+			"iteraciones, logloss_oof, logloss_meta, accuracy_base, f1_base, kappa_base, accuracy_meta, f1_meta, kappa_meta) "
+			"VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+		if (!stmt) return false;
+		sqlite3_bind_text(stmt, 1, r.run_id.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 3, r.model_path.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int64(stmt, 4, static_cast<sqlite3_int64>(r.oof_rows));
+		sqlite3_bind_int(stmt, 5, r.num_classes);
+		sqlite3_bind_double(stmt, 6, r.l2);
+		sqlite3_bind_int(stmt, 7, r.iterations);
+		sqlite3_bind_double(stmt, 8, r.oof_logloss);
+		sqlite3_bind_double(stmt, 9, r.meta_logloss);
+		sqlite3_bind_double(stmt, 10, r.base_acc);
+		sqlite3_bind_double(stmt, 11, r.base_f1);
+		sqlite3_bind_double(stmt, 12, r.base_kappa);
+		sqlite3_bind_double(stmt, 13, r.meta_acc);
+		sqlite3_bind_double(stmt, 14, r.meta_f1);
+		sqlite3_bind_double(stmt, 15, r.meta_kappa);
+		return step_row(db, stmt, "resultado de stacking");
+	});
+}
+
+// Caída de Kappa por feature al permutarla en holdout, en una sola transacción
+void insert_permutation_importance_sqlite(const string& run_id, const string& model_hash, const PermutationResult& result) {
+	TraceSpan span("sqlite_insertar_importancia", "sqlite");
+	SqliteConnection db("CREATE TABLE IF NOT EXISTS importancia_permutacion ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"fecha TEXT, "
+		"modelo_hash TEXT, "
+		"feature INTEGER, "
+		"nombre TEXT, "
+		"kappa_base REAL, "
+		"caida_media REAL, "
+		"caida_std REAL, "
+		"repeticiones INTEGER, "
+		"filas INTEGER);"
+		"CREATE INDEX IF NOT EXISTS idx_importancia_run ON importancia_permutacion (run_id);");
+	if (!db) return;
+
+	string fecha = now_text();
+	replace_run_rows(db, { "DELETE FROM importancia_permutacion WHERE run_id = ?1;" }, run_id, [&] {
+		Statement stmt(db, "INSERT INTO importancia_permutacion (run_id, fecha, modelo_hash, feature, nombre, "
+			"kappa_base, caida_media, caida_std, repeticiones, filas) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+		if (!stmt) return false;
+		for (const FeatureImportance& fi : result.features) {
+			sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, model_hash.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int(stmt, 4, fi.feature);
+			sqlite3_bind_text(stmt, 5, fi.name.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_double(stmt, 6, result.baseline_kappa);
+			sqlite3_bind_double(stmt, 7, fi.mean_drop);
+			sqlite3_bind_double(stmt, 8, fi.std_drop);
+			sqlite3_bind_int(stmt, 9, result.repeats);
+			sqlite3_bind_int64(stmt, 10, static_cast<sqlite3_int64>(result.rows));
+			if (!step_row(db, stmt, "importancia por permutación")) return false;
+		}
+		return true;
+	});
+}
+
+// Resumen de una corrida de SHAP y su importancia global (media de |SHAP|)
+void insert_shap_summary_sqlite(const string& run_id, const string& model_hash, const ShapResult& result,
+	const vector<string>& feature_names, double max_diff_lightgbm) {
+	TraceSpan span("sqlite_insertar_shap", "sqlite");
+	SqliteConnection db("CREATE TABLE IF NOT EXISTS shap_corridas ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"fecha TEXT, "
+		"modelo_hash TEXT, "
+		"modo TEXT, "
+		"filas INTEGER, "
+		"filas_fondo INTEGER, "
+		"hilos INTEGER, "
+		"segundos REAL, "
+		"filas_por_segundo REAL, "
+		"error_max_lightgbm REAL);"
+		"CREATE TABLE IF NOT EXISTS shap_importancia ("
+		"id_shap INTEGER, "
+		"feature INTEGER, "
+		"nombre TEXT, "
+		"clase INTEGER, "
+		"media_abs REAL);"
+		"CREATE INDEX IF NOT EXISTS idx_shap_importancia ON shap_importancia (id_shap);");
+	if (!db) return;
+
+	string fecha = now_text();
+	replace_run_rows(db, {
+			"DELETE FROM shap_importancia WHERE id_shap IN (SELECT id FROM shap_corridas WHERE run_id = ?1);",
+			"DELETE FROM shap_corridas WHERE run_id = ?1;" },
+		run_id, [&] {
+			Statement stmt(db, "INSERT INTO shap_corridas (run_id, fecha, modelo_hash, modo, filas, filas_fondo, hilos, "
+				"segundos, filas_por_segundo, error_max_lightgbm) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+			if (!stmt) return false;
+			sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, model_hash.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 4, result.background_rows > 0 ? "interventional" : "path_dependent", -1, SQLITE_STATIC);
+			sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(result.rows));
+			sqlite3_bind_int64(stmt, 6, static_cast<sqlite3_int64>(result.background_rows));
+			sqlite3_bind_int(stmt, 7, result.threads);
+			sqlite3_bind_double(stmt, 8, result.seconds);
+			sqlite3_bind_double(stmt, 9, result.rows_per_second());
+			if (max_diff_lightgbm < 0.0) sqlite3_bind_null(stmt, 10);
+			else sqlite3_bind_double(stmt, 10, max_diff_lightgbm);
+			if (!step_row(db, stmt, "corrida de SHAP")) return false;
+			int64_t id_shap = sqlite3_last_insert_rowid(db);
+
+			Statement imp(db, "INSERT INTO shap_importancia (id_shap, feature, nombre, clase, media_abs) VALUES (?, ?, ?, ?, ?);");
+			if (!imp) return false;
+			vector<double> mean = mean_abs_shap(result);
+			for (int c = 0; c < result.num_classes; ++c) {
+				for (int f = 0; f < result.num_features; ++f) {
+					sqlite3_bind_int64(imp, 1, id_shap);
+					sqlite3_bind_int(imp, 2, f);
+					sqlite3_bind_text(imp, 3, feature_names[f].c_str(), -1, SQLITE_STATIC);
+					sqlite3_bind_int(imp, 4, c);
+					sqlite3_bind_double(imp, 5, mean[static_cast<size_t>(c) * result.num_features + f]);
+					if (!step_row(db, imp, "importancia SHAP")) return false;
+				}
+			}
+			return true;
+		});
+}
+
+// Último proceso exitoso de una fase: base para estimar lo que costaría repetirlo
+double last_successful_wall_ms(const string& phase, uint64_t& data_bytes) {
+	data_bytes = 0;
+	if (!sqlite_table_exists(RESULTS_DB, "recursos_procesos")) return -1.0;
+	SqliteConnection db(nullptr, RESULTS_DB, SQLITE_OPEN_READONLY);
+	if (!db) return -1.0;
+	double wall_ms = -1.0;
+	Statement stmt(db, "SELECT wall_ms, data_bytes FROM recursos_procesos "
+		"WHERE fase = ? AND exit_code = 0 ORDER BY id DESC LIMIT 1;");
+	if (!stmt) return wall_ms;
+	sqlite3_bind_text(stmt, 1, phase.c_str(), -1, SQLITE_STATIC);
+	if (sqlite3_step(stmt) == SQLITE_ROW) {
+		wall_ms = sqlite3_column_double(stmt, 0);
+		data_bytes = static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+	}
+	return wall_ms;
+}
+
+// Guarda el reentrenamiento incremental: tiempos, métricas de ambos modelos y si se promovió
+void insert_incremental_retrain_sqlite(const IncrementalRecord& r) {
+	TraceSpan span("sqlite_insertar_incremental", "sqlite");
+	SqliteConnection db("CREATE TABLE IF NOT EXISTS reentrenamiento_incremental ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"fecha TEXT, "
+		"modelo_base TEXT, "
+		"modelo_nuevo TEXT, "
+		"datos TEXT, "
+		"iteraciones INTEGER, "
+		"segundos REAL, "
+		"segundos_completo_estimado REAL, "
+		"segundos_ahorrados REAL, "
+		"accuracy_base REAL, "
+		"f1_base REAL, "
+		"kappa_base REAL, "
+		"accuracy_nuevo REAL, "
+		"f1_nuevo REAL, "
+		"kappa_nuevo REAL, "
+		"promovido INTEGER);");
+	if (!db) return;
+
+	string fecha = now_text();
+	Statement stmt(db, "INSERT INTO reentrenamiento_incremental (run_id, fecha, modelo_base, modelo_nuevo, datos, "
+		"iteraciones, segundos, segundos_completo_estimado, segundos_ahorrados, accuracy_base, f1_base, kappa_base, "
+		"accuracy_nuevo, f1_nuevo, kappa_nuevo, promovido) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+	if (!stmt) return;
+	sqlite3_bind_text(stmt, 1, r.run_id.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 3, r.base_hash.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 4, r.new_hash.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 5, r.data_path.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_int(stmt, 6, r.iterations);
+	sqlite3_bind_double(stmt, 7, r.seconds);
+	if (r.full_seconds >= 0.0) {
+		sqlite3_bind_double(stmt, 8, r.full_seconds);
+		sqlite3_bind_double(stmt, 9, r.full_seconds - r.seconds);
+	}
+	else {
+		sqlite3_bind_null(stmt, 8);
+		sqlite3_bind_null(stmt, 9);
+	}
+	sqlite3_bind_double(stmt, 10, r.base_acc);
+	sqlite3_bind_double(stmt, 11, r.base_f1);
+	sqlite3_bind_double(stmt, 12, r.base_kappa);
+	sqlite3_bind_double(stmt, 13, r.new_acc);
+	sqlite3_bind_double(stmt, 14, r.new_f1);
+	sqlite3_bind_double(stmt, 15, r.new_kappa);
+	sqlite3_bind_int(stmt, 16, r.promoted ? 1 : 0);
+	step_row(db, stmt, "reentrenamiento incremental");
+}
+
+// Resultados del modo multi-semilla en una sola transacción
+void insert_seed_results_sqlite(const string& run_id, const vector<SeedScore>& scores, const vector<SeedScore>& ensemble) {
+	TraceSpan span("sqlite_insertar_semillas", "sqlite");
+	SqliteConnection db("CREATE TABLE IF NOT EXISTS resultados_semillas ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"fecha TEXT, "
+		"semilla INTEGER, "
+		"repeticion INTEGER, "
+		"fold INTEGER, "
+		"trabajo TEXT, "
+		"accuracy REAL, "
+		"f1_macro REAL, "
+		"kappa REAL);"
+		"CREATE INDEX IF NOT EXISTS idx_semillas_run ON resultados_semillas (run_id);");
+	if (!db) return;
+
+	string fecha = now_text();
+	replace_run_rows(db, { "DELETE FROM resultados_semillas WHERE run_id = ?1;" }, run_id, [&] {
+		Statement stmt(db, "INSERT INTO resultados_semillas (run_id, fecha, semilla, repeticion, fold, trabajo, "
+			"accuracy, f1_macro, kappa) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);");
+		if (!stmt) return false;
+		for (const vector<SeedScore>* rows : { &scores, &ensemble }) {
+			for (const SeedScore& s : *rows) {
+				sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+				sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+				if (rows == &scores) sqlite3_bind_int(stmt, 3, s.seed);
+				else sqlite3_bind_null(stmt, 3);
+				sqlite3_bind_int(stmt, 4, s.repeat);
+				if (s.fold >= 0) sqlite3_bind_int(stmt, 5, s.fold);
+				else sqlite3_bind_null(stmt, 5);
+				sqlite3_bind_text(stmt, 6, s.tag.c_str(), -1, SQLITE_STATIC);
+				sqlite3_bind_double(stmt, 7, s.accuracy);
+				sqlite3_bind_double(stmt, 8, s.f1_macro);
+				sqlite3_bind_double(stmt, 9, s.kappa);
+				if (!step_row(db, stmt, "resultado por semilla")) return false;
+			}
+		}
+		return true;
+	});
+}
+
+// Resultado del monitor de drift en una sola transacción
+void insert_drift_report_sqlite(const string& run_id, const DatasetProfile& train, const DatasetProfile& test,
+	const vector<FeatureDrift>& drift, double psi_max, double ks_max, bool passed) {
+	TraceSpan span("sqlite_insertar_drift", "sqlite");
+	SqliteConnection db("CREATE TABLE IF NOT EXISTS drift_corridas ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"fecha TEXT, "
+		"train TEXT, "
+		"test TEXT, "
+		"filas_train INTEGER, "
+		"filas_test INTEGER, "
+		"bytes_train INTEGER, "
+		"bytes_test INTEGER, "
+		"segundos_train REAL, "
+		"segundos_test REAL, "
+		"psi_max REAL, "
+		"ks_max REAL, "
+		"umbral_psi REAL, "
+		"umbral_ks REAL, "
+		"aprobado INTEGER);"
+		"CREATE TABLE IF NOT EXISTS drift_features ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"feature INTEGER, "
+		"nombre TEXT, "
+		"psi REAL, "
+		"ks REAL, "
+		"faltantes_train REAL, "
+		"faltantes_test REAL);"
+		"CREATE INDEX IF NOT EXISTS idx_drift_features_run ON drift_features (run_id);");
+	if (!db) return;
+
+	string fecha = now_text();
+	double worst_psi = 0.0, worst_ks = 0.0;
+	for (const FeatureDrift& d : drift) {
+		worst_psi = max(worst_psi, d.psi);
+		worst_ks = max(worst_ks, d.ks);
+	}
+	string train_path = train.path.string(), test_path = test.path.string();
+
+	replace_run_rows(db, {
+			"DELETE FROM drift_corridas WHERE run_id = ?1;",
+			"DELETE FROM drift_features WHERE run_id = ?1;" },
+		run_id, [&] {
+			Statement stmt(db, "INSERT INTO drift_corridas (run_id, fecha, train, test, filas_train, filas_test, bytes_train, "
+				"bytes_test, segundos_train, segundos_test, psi_max, ks_max, umbral_psi, umbral_ks, aprobado) "
+				"VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+			if (!stmt) return false;
+			sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, train_path.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 4, test_path.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(train.rows));
+			sqlite3_bind_int64(stmt, 6, static_cast<sqlite3_int64>(test.rows));
+			sqlite3_bind_int64(stmt, 7, static_cast<sqlite3_int64>(train.bytes));
+			sqlite3_bind_int64(stmt, 8, static_cast<sqlite3_int64>(test.bytes));
+			sqlite3_bind_double(stmt, 9, train.seconds);
+			sqlite3_bind_double(stmt, 10, test.seconds);
+			sqlite3_bind_double(stmt, 11, worst_psi);
+			sqlite3_bind_double(stmt, 12, worst_ks);
+			sqlite3_bind_double(stmt, 13, psi_max);
+			sqlite3_bind_double(stmt, 14, ks_max);
+			sqlite3_bind_int(stmt, 15, passed ? 1 : 0);
+			if (!step_row(db, stmt, "chequeo de drift")) return false;
+
+			Statement feat(db, "INSERT INTO drift_features (run_id, feature, nombre, psi, ks, faltantes_train, faltantes_test) "
+				"VALUES (?, ?, ?, ?, ?, ?, ?);");
+			if (!feat) return false;
+			for (const FeatureDrift& d : drift) {
+				sqlite3_bind_text(feat, 1, run_id.c_str(), -1, SQLITE_STATIC);
+				sqlite3_bind_int(feat, 2, d.feature);
+				sqlite3_bind_text(feat, 3, d.name.c_str(), -1, SQLITE_STATIC);
+				sqlite3_bind_double(feat, 4, d.psi);
+				sqlite3_bind_double(feat, 5, d.ks);
+				sqlite3_bind_double(feat, 6, d.train_missing);
+				sqlite3_bind_double(feat, 7, d.test_missing);
+				if (!step_row(db, feat, "drift por feature")) return false;
+			}
+			return true;
+		});
+}
+
+void insert_engine_benchmark_sqlite(const string& run_id, const string& model_hash, const vector<EngineBenchmark>& bench,
+	double max_diff_lightgbm) {
+	TraceSpan span("sqlite_insertar_benchmark_motores", "sqlite");
+	SqliteConnection db("CREATE TABLE IF NOT EXISTS benchmark_motores ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"fecha TEXT, "
+		"modelo_hash TEXT, "
+		"iteraciones INTEGER, "
+		"arboles INTEGER, "
+		"profundidad INTEGER, "
+		"hojas_max INTEGER, "
+		"filas INTEGER, "
+		"arboles_recorrido INTEGER, "
+		"avx2 INTEGER, "
+		"ms_recorrido REAL, "
+		"ms_quickscorer REAL, "
+		"ms_quickscorer_escalar REAL, "
+		"speedup REAL, "
+		"diferencia_max REAL, "
+		"error_max_lightgbm REAL);");
+	if (!db) return;
+
+	string fecha = now_text();
+	replace_run_rows(db, { "DELETE FROM benchmark_motores WHERE run_id = ?1;" }, run_id, [&] {
+		Statement stmt(db, "INSERT INTO benchmark_motores (run_id, fecha, modelo_hash, iteraciones, arboles, profundidad, "
+			"hojas_max, filas, arboles_recorrido, avx2, ms_recorrido, ms_quickscorer, ms_quickscorer_escalar, speedup, "
+			"diferencia_max, error_max_lightgbm) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+		if (!stmt) return false;
+		for (const EngineBenchmark& b : bench) {
+			sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, model_hash.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int(stmt, 4, b.iterations);
+			sqlite3_bind_int(stmt, 5, b.trees);
+			sqlite3_bind_int(stmt, 6, b.max_depth);
+			sqlite3_bind_int(stmt, 7, b.max_leaves);
+			sqlite3_bind_int64(stmt, 8, static_cast<sqlite3_int64>(b.rows));
+			sqlite3_bind_int64(stmt, 9, static_cast<sqlite3_int64>(b.fallback_trees));
+			sqlite3_bind_int(stmt, 10, b.vectorized ? 1 : 0);
+			sqlite3_bind_double(stmt, 11, b.traversal_ms);
+			sqlite3_bind_double(stmt, 12, b.quickscorer_ms);
+			sqlite3_bind_double(stmt, 13, b.scalar_ms);
+			sqlite3_bind_double(stmt, 14, b.speedup());
+			sqlite3_bind_double(stmt, 15, b.max_diff);
+			if (max_diff_lightgbm < 0.0) sqlite3_bind_null(stmt, 16);
+			else sqlite3_bind_double(stmt, 16, max_diff_lightgbm);
+			if (!step_row(db, stmt, "benchmark de motores")) return false;
+		}
+		return true;
+	});
+}
+
+void insert_training_curves_sqlite(const string& run_id, const string& phase, const TrainingMonitor& monitor) {
+	TraceSpan span("sqlite_insertar_curvas", "sqlite");
+	SqliteConnection db("CREATE TABLE IF NOT EXISTS curvas_entrenamiento ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"fecha TEXT, "
+		"fase TEXT, "
+		"etapa TEXT, "
+		"fold INTEGER, "
+		"conjunto TEXT, "
+		"metrica TEXT, "
+		"iteraciones INTEGER, "
+		"mejor_iteracion INTEGER, "
+		"mejor_valor REAL, "
+		"ultimo_valor REAL, "
+		"segundos REAL, "
+		"iter_por_segundo REAL, "
+		"valores BLOB);"
+		"CREATE INDEX IF NOT EXISTS idx_curvas_run ON curvas_entrenamiento (run_id, fase);");
+	if (!db) return;
+
+	string fecha = now_text();
+	replace_run_rows(db, { "DELETE FROM curvas_entrenamiento WHERE run_id = ?1 AND etapa = ?2;" }, run_id, [&] {
+		Statement stmt(db, "INSERT INTO curvas_entrenamiento (run_id, fecha, fase, etapa, fold, conjunto, metrica, "
+			"iteraciones, mejor_iteracion, mejor_valor, ultimo_valor, segundos, iter_por_segundo, valores) "
+			"VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+		if (!stmt) return false;
+		for (const TrainingCurve& c : monitor.curves()) {
+			int best = c.best_iteration();
+			sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, phase.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 4, c.stage.c_str(), -1, SQLITE_STATIC);
+			if (c.fold < 0) sqlite3_bind_null(stmt, 5);
+			else sqlite3_bind_int(stmt, 5, c.fold);
+			sqlite3_bind_text(stmt, 6, c.dataset.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 7, c.metric.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int(stmt, 8, static_cast<int>(c.values.size()));
+			sqlite3_bind_int(stmt, 9, best);
+			if (best > 0) sqlite3_bind_double(stmt, 10, c.values[best - 1]);
+			else sqlite3_bind_null(stmt, 10);
+			sqlite3_bind_double(stmt, 11, c.values.empty() ? 0.0 : c.values.back());
+			sqlite3_bind_double(stmt, 12, monitor.seconds());
+			sqlite3_bind_double(stmt, 13, monitor.iterations_per_second());
+			sqlite3_bind_blob(stmt, 14, c.values.data(), static_cast<int>(c.values.size() * sizeof(float)), SQLITE_STATIC);
+			if (!step_row(db, stmt, "curva de entrenamiento")) return false;
+		}
+		return true;
+	}, monitor.stage());
+}
+
+vector<TrainingCurve> load_training_curves_sqlite(const string& run_id, const string& phase) {
+	vector<TrainingCurve> curves;
+	if (!sqlite_table_exists(RESULTS_DB, "curvas_entrenamiento")) return curves;
+	SqliteConnection db(nullptr, RESULTS_DB, SQLITE_OPEN_READONLY);
+	if (!db) return curves;
+	Statement stmt(db, "SELECT etapa, fold, conjunto, metrica, valores FROM curvas_entrenamiento "
+		"WHERE run_id = ? AND fase = ? ORDER BY id;");
+	if (!stmt) return curves;
+	sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, phase.c_str(), -1, SQLITE_STATIC);
+	auto text = [&](int col) {
+		const unsigned char* value = sqlite3_column_text(stmt, col);
+		return value ? string(reinterpret_cast<const char*>(value)) : string();
+	};
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		TrainingCurve c;
+		c.stage = text(0);
+		c.fold = sqlite3_column_type(stmt, 1) == SQLITE_NULL ? -1 : sqlite3_column_int(stmt, 1);
+		c.dataset = text(2);
+		c.metric = text(3);
+		const float* values = static_cast<const float*>(sqlite3_column_blob(stmt, 4));
+		int bytes = sqlite3_column_bytes(stmt, 4);
+		if (values) c.values.assign(values, values + bytes / sizeof(float));
+		curves.push_back(std::move(c));
+	}
+	return curves;
+}
+
+void insert_iteration_advice_sqlite(const string& run_id, const IterationAdvice& advice) {
+	TraceSpan span("sqlite_insertar_recomendacion", "sqlite");
+	SqliteConnection db("CREATE TABLE IF NOT EXISTS recomendacion_iteraciones ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"fecha TEXT, "
+		"conjunto TEXT, "
+		"metrica TEXT, "
+		"curvas INTEGER, "
+		"iteraciones_config INTEGER, "
+		"mejor_iteracion INTEGER, "
+		"mejor_valor REAL, "
+		"ultima_iteracion INTEGER, "
+		"ultimo_valor REAL, "
+		"escala_datos REAL, "
+		"recomendado INTEGER);");
+	if (!db) return;
+
+	string fecha = now_text();
+	replace_run_rows(db, { "DELETE FROM recomendacion_iteraciones WHERE run_id = ?1;" }, run_id, [&] {
+		Statement stmt(db, "INSERT INTO recomendacion_iteraciones (run_id, fecha, conjunto, metrica, curvas, "
+			"iteraciones_config, mejor_iteracion, mejor_valor, ultima_iteracion, ultimo_valor, escala_datos, recomendado) "
+			"VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+		if (!stmt) return false;
+		sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 3, advice.dataset.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 4, advice.metric.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int(stmt, 5, advice.curves);
+		sqlite3_bind_int(stmt, 6, advice.configured);
+		sqlite3_bind_int(stmt, 7, advice.best_iteration);
+		sqlite3_bind_double(stmt, 8, advice.best_value);
+		sqlite3_bind_int(stmt, 9, advice.last_iteration);
+		sqlite3_bind_double(stmt, 10, advice.last_value);
+		sqlite3_bind_double(stmt, 11, advice.data_scale);
+		sqlite3_bind_int(stmt, 12, advice.recommended);
+		return step_row(db, stmt, "recomendacion de iteraciones");
+	});
+}
+
+// Resumen de recursos por fase y costo por trabajo de una corrida
+void print_resource_summary(const string& run_id) {
+	if (!sqlite_table_exists(RESULTS_DB, "recursos_procesos")) return;
+	SqliteConnection db(nullptr, RESULTS_DB, SQLITE_OPEN_READONLY);
+	if (!db) return;
+
+	cout << CYAN << BOLD << "\n==== RECURSOS POR FASE (corrida " << run_id << ") ====" << RESET << endl;
+	printf("%-28s %4s %10s %10s %10s %12s %12s\n", "fase", "n", "wall(s)", "cpu(s)", "pico(MB)", "leido(MB)", "escrito(MB)");
+
+	Statement by_phase(db, "SELECT fase, COUNT(*), SUM(wall_ms), SUM(user_ms + sys_ms), MAX(peak_rss_mb), "
+		"SUM(io_read_bytes), SUM(io_write_bytes) FROM recursos_procesos WHERE run_id = ? "
+		"GROUP BY fase ORDER BY SUM(wall_ms) DESC;");
+	if (by_phase) {
+		sqlite3_bind_text(by_phase, 1, run_id.c_str(), -1, SQLITE_STATIC);
+		while (sqlite3_step(by_phase) == SQLITE_ROW) {
+			printf("%-28s %4d %10.1f %10.1f %10.1f %12.1f %12.1f\n",
+				reinterpret_cast<const char*>(sqlite3_column_text(by_phase, 0)),
+				sqlite3_column_int(by_phase, 1),
+				sqlite3_column_double(by_phase, 2) / 1000.0,
+				sqlite3_column_double(by_phase, 3) / 1000.0,
+				sqlite3_column_double(by_phase, 4),
+				sqlite3_column_double(by_phase, 5) / (1024.0 * 1024.0),
+				sqlite3_column_double(by_phase, 6) / (1024.0 * 1024.0));
+		}
+	}
+
+	// Un fold se repite por repetición y semilla: cada trabajo y fase en su propia fila
+	Statement by_job(db, "SELECT COALESCE(repeticion, 0), semilla, fold, fase, SUM(wall_ms), SUM(user_ms + sys_ms), "
+		"MAX(peak_rss_mb) FROM recursos_procesos WHERE run_id = ? AND fold IS NOT NULL "
+		"GROUP BY COALESCE(repeticion, 0), semilla, fold, fase ORDER BY 1, 2, 3, 4;");
+	if (by_job) {
+		sqlite3_bind_text(by_job, 1, run_id.c_str(), -1, SQLITE_STATIC);
+		cout << CYAN << "\nCosto por trabajo:" << RESET << endl;
+		while (sqlite3_step(by_job) == SQLITE_ROW) {
+			string job = "r" + to_string(sqlite3_column_int(by_job, 0));
+			if (sqlite3_column_type(by_job, 1) != SQLITE_NULL) job += " s" + to_string(sqlite3_column_int(by_job, 1));
+			job += " fold " + to_string(sqlite3_column_int(by_job, 2));
+			printf("  %-18s %-24s wall=%.1f s | cpu=%.1f s | pico=%.1f MB\n",
+				job.c_str(),
+				reinterpret_cast<const char*>(sqlite3_column_text(by_job, 3)),
+				sqlite3_column_double(by_job, 4) / 1000.0,
+				sqlite3_column_double(by_job, 5) / 1000.0,
+				sqlite3_column_double(by_job, 6));
+		}
+	}
+}
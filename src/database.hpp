@@ -3,20 +3,117 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include "process.hpp"
+#include "permutation_importance.hpp"
+#include "tree_shap.hpp"
+#include "multi_seed.hpp"
+#include "drift_monitor.hpp"
+#include "quickscorer.hpp"
+#include "training_curves.hpp"
 
-int insert_result_sqlite(double acc, double f1, double kappa, const std::string& model_path,
-	const std::string& conf_path, const std::string& config_str);
+struct sqlite3;
 
-void insert_predictions_sqlite(const std::vector<int>& y_true,
-	const std::vector<int>& y_pred,
-	int result_id);
+// Guarda el resultado y sus predicciones (tabla predicciones) en una sola transacción.
+// run_id: corrida que produjo el resultado; si ya había una fila de la misma
+// corrida y modelo (evaluación interrumpida y reanudada) se reemplaza
+int insert_result_sqlite(double acc, double f1, double kappa, const std::string& model_path,
+	const std::string& conf_path, const std::string& config_str,
+	const std::vector<int>& y_true, const std::vector<int>& y_pred, const std::string& run_id = "");
 
+// Los mejores modelos y el final se promueven en el registro (model_registry.hpp):
+// aliases best_f1, best_kappa y final, con historial en mejor_modelo
 void save_best_model(const std::string& db_path = "resultados.db");
 
 void save_best_model_by_kappa();
 
-void save_final_model(const std::string& db_path, const std::string& model_path, const std::string& config_path);
+void save_final_model(const std::string& db_path, const std::string& model_path, const std::string& config_path,
+	const std::string& run_id = "");
 
 bool sqlite_table_exists(const std::string& db_path, const std::string& table_name);
 
+// Agrega la columna si la tabla no la tiene (bases creadas por versiones anteriores)
+void ensure_column(sqlite3* db, const std::string& table, const std::string& column, const std::string& type);
+
+// Índices de resultados y predicciones (ambas tablas deben existir)
+void ensure_results_indexes(sqlite3* db);
+
+// Registra los recursos consumidos por un proceso hijo (tabla recursos_procesos).
+// data_bytes: tamaño del dataset del trabajo, base del historial del scheduler.
+// repeat, seed (-1: sin semilla) y fold identifican el trabajo.
+void insert_process_stats_sqlite(const std::string& run_id, int fold, const std::string& phase,
+	const std::string& command, const ProcessStats& stats, uint64_t data_bytes = 0, int repeat = 0, int seed = -1);
+
+// Resultado del meta-modelo de stacking evaluado en holdout (tabla resultados_stacking)
+struct StackingRecord {
+	std::string run_id;
+	std::string model_path;
+	uint64_t oof_rows = 0;
+	int num_classes = 0;
+	int iterations = 0;
+	double l2 = 0.0;
+	double oof_logloss = 0.0;     // probabilidades OOF de LightGBM
+	double meta_logloss = 0.0;    // meta-modelo sobre el mismo OOF
+	double base_acc = 0.0, base_f1 = 0.0, base_kappa = 0.0;   // holdout, modelo base
+	double meta_acc = 0.0, meta_f1 = 0.0, meta_kappa = 0.0;   // holdout, meta-modelo
+};
+
+void insert_stacking_result_sqlite(const StackingRecord& record);
+
+// Importancia por permutación del modelo (tabla importancia_permutacion, una fila por feature)
+void insert_permutation_importance_sqlite(const std::string& run_id, const std::string& model_hash,
+	const PermutationResult& result);
+
+// Corrida de SHAP (tabla shap_corridas) y media de |SHAP| por feature y clase (tabla shap_importancia).
+// max_diff_lightgbm < 0: sin validación contra predict_contrib.
+void insert_shap_summary_sqlite(const std::string& run_id, const std::string& model_hash, const ShapResult& result,
+	const std::vector<std::string>& feature_names, double max_diff_lightgbm);
+
+// wall_ms y data_bytes del último proceso exitoso de la fase (wall_ms < 0 si no hay historial)
+double last_successful_wall_ms(const std::string& phase, uint64_t& data_bytes);
+
+// Reentrenamiento incremental del modelo final (tabla reentrenamiento_incremental)
+struct IncrementalRecord {
+	std::string run_id;
+	std::string base_hash;        // modelo del que se continuó el boosting
+	std::string new_hash;         // candidato
+	std::string data_path;
+	int iterations = 0;           // árboles agregados
+	double seconds = 0.0;         // entrenamiento incremental
+	double full_seconds = -1.0;   // reentrenamiento completo estimado (< 0: sin historial)
+	double base_acc = 0.0, base_f1 = 0.0, base_kappa = 0.0;   // holdout, modelo base
+	double new_acc = 0.0, new_f1 = 0.0, new_kappa = 0.0;      // holdout, candidato
+	bool promoted = false;
+};
+
+void insert_incremental_retrain_sqlite(const IncrementalRecord& record);
+
+// Métricas por semilla y trabajo del modo multi-semilla y del ensemble de semillas
+// (tabla resultados_semillas; semilla NULL = ensemble). Reemplaza las filas previas de run_id.
+void insert_seed_results_sqlite(const std::string& run_id, const std::vector<SeedScore>& scores,
+	const std::vector<SeedScore>& ensemble);
+
+// Chequeo de drift antes de la inferencia: rendimiento y resultado (tabla drift_corridas)
+// y PSI/KS por feature (tabla drift_features)
+void insert_drift_report_sqlite(const std::string& run_id, const DatasetProfile& train, const DatasetProfile& test,
+	const std::vector<FeatureDrift>& drift, double psi_max, double ks_max, bool passed);
+
+// Benchmark QuickScorer vs recorrido por celda (iteraciones x profundidad) y diferencia
+// con las probabilidades de LightGBM (tabla benchmark_motores). Reemplaza las filas previas de run_id.
+void insert_engine_benchmark_sqlite(const std::string& run_id, const std::string& model_hash,
+	const std::vector<EngineBenchmark>& bench, double max_diff_lightgbm);
+
+// Curvas por iteración de un entrenamiento (tabla curvas_entrenamiento, una fila por
+// conjunto y métrica con los valores como float32 en un BLOB). Reemplaza las de la misma etapa.
+void insert_training_curves_sqlite(const std::string& run_id, const std::string& phase, const TrainingMonitor& monitor);
+
+// Curvas de la fase guardadas por la corrida run_id, en orden de inserción
+std::vector<TrainingCurve> load_training_curves_sqlite(const std::string& run_id, const std::string& phase);
+
+// Recomendación de num_iterations para el modelo final (tabla recomendacion_iteraciones)
+void insert_iteration_advice_sqlite(const std::string& run_id, const IterationAdvice& advice);
+
+// Resumen por fase y por trabajo (repetición, semilla, fold y fase) de los recursos de la corrida run_id
+void print_resource_summary(const std::string& run_id);
+
 #endif // DATABASE_HPP
@@ -0,0 +1,347 @@
+#include "dataset_cache.hpp"
+#include "hashing.hpp"
+#include "io_utils.hpp"
+#include "trace.hpp"
+
+#include <sqlite3.h>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define YELLOW  "\033[33m"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	// Parámetros de LightGBM que cambian cómo se lee o discretiza el dataset (con sus alias)
+	const vector<vector<const char*>> BINNING_KEYS = {
+		{ "max_bin", "max_bins" },
+		{ "max_bin_by_feature" },
+		{ "min_data_in_bin" },
+		{ "bin_construct_sample_cnt", "subsample_for_bin" },
+		{ "data_random_seed", "data_seed" },
+		{ "seed", "random_seed", "random_state" },
+		{ "is_enable_sparse", "is_sparse", "enable_sparse", "sparse" },
+		{ "enable_bundle", "is_enable_bundle", "bundle" },
+		{ "max_conflict_rate" },
+		{ "use_missing" },
+		{ "zero_as_missing" },
+		{ "feature_pre_filter" },
+		{ "min_data_in_leaf", "min_data_per_leaf", "min_data", "min_child_samples", "min_samples_leaf" },
+		{ "pre_partition", "is_pre_partition" },
+		{ "two_round", "two_round_loading", "use_two_round_loading" },
+		{ "header", "has_header" },
+		{ "label_column", "label" },
+		{ "weight_column", "weight" },
+		{ "group_column", "group", "group_id", "query_column", "query", "query_id" },
+		{ "ignore_column", "ignore_feature", "blacklist" },
+		{ "categorical_feature", "cat_feature", "categorical_column", "cat_column", "categorical_features" },
+		{ "forcedbins_filename" },
+		{ "linear_tree", "linear_trees" },
+		{ "precise_float_parser" },
+	};
+
+	vector<string> split_list(const string& value) {
+		vector<string> items;
+		stringstream ss(value);
+		string item;
+		while (getline(ss, item, ',')) {
+			if (!item.empty()) items.push_back(item);
+		}
+		return items;
+	}
+
+	string now_text() {
+		time_t now = time(0);
+		string fecha = string(ctime(&now));
+		fecha.pop_back(); // quitar salto de línea
+		return fecha;
+	}
+
+	sqlite3* open_dataset_db(const string& db_path) {
+		sqlite3* db;
+		if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
+			cerr << "No se puede abrir la base de datos: " << sqlite3_errmsg(db) << endl;
+			sqlite3_close(db);
+			return nullptr;
+		}
+		sqlite3_busy_timeout(db, 5000);
+		const char* create_sql =
+			"CREATE TABLE IF NOT EXISTS cache_datasets ("
+			"clave TEXT PRIMARY KEY, rol TEXT, origen TEXT, ruta TEXT, bytes INTEGER, "
+			"segundos_texto REAL, creado TEXT, usos INTEGER DEFAULT 0, ultimo_uso TEXT);"
+			"CREATE TABLE IF NOT EXISTS carga_datasets ("
+			"id INTEGER PRIMARY KEY AUTOINCREMENT, run_id TEXT, etapa TEXT, fold INTEGER, clave TEXT, "
+			"origen TEXT, segundos REAL, segundos_texto REAL, ahorro REAL, fecha TEXT);";
+		sqlite3_exec(db, create_sql, nullptr, nullptr, nullptr);
+		return db;
+	}
+
+	// Clave de un dataset: contenido (más archivos auxiliares que LightGBM lee por nombre),
+	// parámetros de binning, binario de LightGBM y, para un valid, la clave del train
+	string dataset_key(const string& role, const fs::path& source, const map<string, string>& params,
+		const string& lightgbm_hash, const string& train_key) {
+		Fnv1a h;
+		h.update(role);
+		if (!h.update_file(source)) return string();
+		for (const char* ext : { ".weight", ".init", ".query" }) {
+			fs::path side = source;
+			side += ext;
+			if (fs::exists(side)) {
+				h.update(ext);
+				h.update_file(side);
+			}
+		}
+		for (const auto& keys : BINNING_KEYS) {
+			string value;
+			for (const char* key : keys) {
+				auto it = params.find(key);
+				if (it != params.end()) {
+					value = it->second;
+					break;
+				}
+			}
+			h.update(string(keys[0]) + "=" + value + ";");
+			if (string(keys[0]) == "forcedbins_filename" && !value.empty()) h.update_file(value);
+		}
+		h.update(lightgbm_hash);
+		h.update(train_key);
+		return h.hex();
+	}
+
+	fs::path binary_beside(const fs::path& file) {
+		fs::path bin = file;
+		bin += ".bin";
+		return bin;
+	}
+
+	// Enlace duro al archivo (copia si el sistema de archivos no lo permite)
+	bool link_or_copy(const fs::path& from, const fs::path& to) {
+		std::error_code ec;
+		fs::create_hard_link(from, to, ec);
+		if (!ec) return true;
+		ec.clear();
+		fs::copy_file(from, to, fs::copy_options::overwrite_existing, ec);
+		return !ec;
+	}
+
+	// El texto de un dataset (con sus .weight/.init/.query) en el directorio del trabajo
+	bool stage_dataset(const fs::path& source, const fs::path& staged) {
+		if (!link_or_copy(source, staged)) return false;
+		for (const char* ext : { ".weight", ".init", ".query" }) {
+			fs::path side = source;
+			side += ext;
+			fs::path staged_side = staged;
+			staged_side += ext;
+			if (fs::exists(side) && !link_or_copy(side, staged_side)) return false;
+		}
+		return true;
+	}
+
+	void bind_seconds(sqlite3_stmt* stmt, int index, double value) {
+		if (value < 0.0) sqlite3_bind_null(stmt, index);
+		else sqlite3_bind_double(stmt, index, value);
+	}
+} // namespace
+
+double parse_lightgbm_load_seconds(const string& line) {
+	const string marker = "Finished loading data in ";
+	size_t pos = line.find(marker);
+	if (pos == string::npos) return -1.0;
+	try {
+		return stod(line.substr(pos + marker.size()));
+	}
+	catch (const exception&) {
+		return -1.0;
+	}
+}
+
+DatasetCache::DatasetCache(string db_path, fs::path root, bool enabled)
+	: db_path_(std::move(db_path)), root_(std::move(root)), enabled_(enabled) {
+}
+
+DatasetCachePlan DatasetCache::prepare(const fs::path& config, const string& lightgbm_hash) {
+	DatasetCachePlan plan;
+	plan.config = config;
+	if (!enabled_) return plan;
+	auto params = read_config_map(config.string());
+	string task = config_get(params, { "task", "task_type" }, "train");
+	string data = config_get(params, CONFIG_DATA_KEYS);
+	if (task != "train" || data.empty()) return plan;
+	// Con input_model LightGBM necesita el texto para calcular el puntaje inicial
+	// del modelo base: no acepta datasets binarios
+	if (!config_get(params, CONFIG_INPUT_MODEL_KEYS).empty()) return plan;
+	TraceSpan span("cache_datasets", "cache");
+
+	DatasetCacheEntry train;
+	train.role = "train";
+	train.source = data;
+	train.key = dataset_key("train", train.source, params, lightgbm_hash, "");
+	if (train.key.empty()) return plan;
+	plan.datasets.push_back(train);
+	for (const string& valid : split_list(config_get(params, CONFIG_VALID_KEYS))) {
+		DatasetCacheEntry entry;
+		entry.role = "valid";
+		entry.source = valid;
+		entry.key = dataset_key("valid", entry.source, params, lightgbm_hash, train.key);
+		if (entry.key.empty()) return DatasetCachePlan{ config, {}, {} };
+		plan.datasets.push_back(entry);
+	}
+
+	bool any_miss = false;
+	int serial = 0;
+	{
+		lock_guard<mutex> lock(mtx_);
+		for (DatasetCacheEntry& entry : plan.datasets) {
+			entry.cached = root_ / (entry.key + ".bin");
+			entry.hit = fs::exists(entry.cached);
+			any_miss |= !entry.hit;
+		}
+		if (any_miss) serial = ++staged_;
+	}
+
+	// Misses: cada trabajo entrena con enlaces al texto en un directorio propio, así
+	// el <data>.bin que escribe LightGBM no choca con el de otro trabajo (ni con un
+	// <data>.bin viejo junto al texto original, que LightGBM cargaría solo)
+	std::error_code ec;
+	if (any_miss) {
+		auto stamp = chrono::system_clock::now().time_since_epoch().count();
+		plan.staging = root_ / "staging" / (plan.datasets[0].key + "_" + to_string(stamp) + "_" + to_string(serial));
+		fs::create_directories(plan.staging, ec);
+		for (size_t i = 0; i < plan.datasets.size(); ++i) {
+			DatasetCacheEntry& entry = plan.datasets[i];
+			if (entry.hit) continue;
+			entry.staged = plan.staging / (to_string(i) + "_" + entry.source.filename().string());
+			if (ec || !stage_dataset(entry.source, entry.staged)) {
+				cerr << YELLOW << "[WARN] No se pudo preparar " << entry.source.string()
+					<< " para la cache de datasets; se usa el config original" << RESET << endl;
+				fs::remove_all(plan.staging, ec);
+				return DatasetCachePlan{ config, {}, {} };
+			}
+		}
+	}
+
+	// Config derivado: data/valid apuntan a los binarios en cache (o a los textos
+	// del staging); save_binary sólo si falta alguno. Con misses el config queda en
+	// el staging porque sus rutas son propias del trabajo
+	fs::path derived = any_miss ? plan.staging / "config.txt"
+		: root_ / "configs" / (config.stem().string() + "_" + hash_file_hex(config) + ".txt");
+	fs::create_directories(derived.parent_path(), ec);
+	auto dataset_path = [&](size_t i) {
+		const DatasetCacheEntry& entry = plan.datasets[i];
+		return entry.hit ? entry.cached.generic_string() : entry.staged.generic_string();
+	};
+	string valid;
+	for (size_t i = 1; i < plan.datasets.size(); ++i) valid += (i > 1 ? "," : "") + dataset_path(i);
+	if (!write_config_overrides(config, derived, {
+		{ CONFIG_DATA_KEYS, dataset_path(0) },
+		{ CONFIG_VALID_KEYS, valid },
+		{ CONFIG_SAVE_BINARY_KEYS, any_miss ? "true" : "" } })) {
+		cerr << YELLOW << "[WARN] Se usa el config original" << RESET << endl;
+		if (!plan.staging.empty()) fs::remove_all(plan.staging, ec);
+		return DatasetCachePlan{ config, {}, {} };
+	}
+	plan.config = derived;
+	return plan;
+}
+
+DatasetLoadReport DatasetCache::finish(const DatasetCachePlan& plan, bool ok, double load_seconds,
+	const string& run_id, const string& stage, int fold) {
+	DatasetLoadReport report;
+	report.load_seconds = load_seconds;
+	if (plan.datasets.empty()) return report;
+	TraceSpan span("cache_datasets", "cache");
+	lock_guard<mutex> lock(mtx_);
+	report.from_binary = plan.train_hit();
+
+	sqlite3* db = open_dataset_db(db_path_);
+	string fecha = now_text();
+	for (size_t i = 0; i < plan.datasets.size(); ++i) {
+		const DatasetCacheEntry& entry = plan.datasets[i];
+		std::error_code ec;
+		if (entry.hit) {
+			// LightGBM puede intentar guardar <binario>.bin aunque haya cargado un binario
+			fs::remove(binary_beside(entry.cached), ec);
+			continue;
+		}
+		// Binario nuevo: pasa a la cache (el resto del staging se borra al final). Si
+		// otro trabajo con la misma clave lo guardó primero, se usa el suyo
+		fs::path produced = binary_beside(entry.staged);
+		if (!ok || !fs::exists(produced) || fs::exists(entry.cached)) continue;
+		fs::rename(produced, entry.cached, ec);
+		if (ec) {
+			cerr << YELLOW << "[WARN] No se pudo mover " << produced.string() << " a la cache: " << ec.message() << RESET << endl;
+			continue;
+		}
+		sqlite3_stmt* stmt;
+		if (db && sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO cache_datasets "
+			"(clave, rol, origen, ruta, bytes, segundos_texto, creado, usos) VALUES (?, ?, ?, ?, ?, ?, ?, 0);",
+			-1, &stmt, nullptr) == SQLITE_OK) {
+			string origen = entry.source.generic_string();
+			string ruta = entry.cached.generic_string();
+			sqlite3_bind_text(stmt, 1, entry.key.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, entry.role.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, origen.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_text(stmt, 4, ruta.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(fs::file_size(entry.cached, ec)));
+			// La carga desde texto que informa LightGBM incluye train y valid: queda en el train
+			bind_seconds(stmt, 6, i == 0 ? load_seconds : -1.0);
+			sqlite3_bind_text(stmt, 7, fecha.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+		}
+	}
+
+	const string& train_key = plan.datasets[0].key;
+	if (db && report.from_binary) {
+		sqlite3_stmt* stmt;
+		if (sqlite3_prepare_v2(db, "SELECT segundos_texto FROM cache_datasets WHERE clave = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+			sqlite3_bind_text(stmt, 1, train_key.c_str(), -1, SQLITE_STATIC);
+			if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+				report.text_seconds = sqlite3_column_double(stmt, 0);
+			}
+			sqlite3_finalize(stmt);
+		}
+		if (sqlite3_prepare_v2(db, "UPDATE cache_datasets SET usos = usos + 1, ultimo_uso = ? WHERE clave = ?;",
+			-1, &stmt, nullptr) == SQLITE_OK) {
+			sqlite3_bind_text(stmt, 1, fecha.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_text(stmt, 2, train_key.c_str(), -1, SQLITE_STATIC);
+			sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+		}
+	}
+	else if (!report.from_binary) {
+		report.text_seconds = load_seconds;
+	}
+
+	sqlite3_stmt* stmt;
+	if (db && ok && sqlite3_prepare_v2(db, "INSERT INTO carga_datasets "
+		"(run_id, etapa, fold, clave, origen, segundos, segundos_texto, ahorro, fecha) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);",
+		-1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, stage.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int(stmt, 3, fold);
+		sqlite3_bind_text(stmt, 4, train_key.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 5, report.from_binary ? "binario" : "texto", -1, SQLITE_STATIC);
+		bind_seconds(stmt, 6, report.load_seconds);
+		bind_seconds(stmt, 7, report.text_seconds);
+		sqlite3_bind_double(stmt, 8, report.saved_seconds());
+		sqlite3_bind_text(stmt, 9, fecha.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_step(stmt);
+		sqlite3_finalize(stmt);
+	}
+	if (db) sqlite3_close(db);
+	if (!plan.staging.empty()) {
+		std::error_code ec;
+		fs::remove_all(plan.staging, ec);
+	}
+
+	if (report.from_binary) ++hits_;
+	total_saved_seconds_ += report.saved_seconds();
+	return report;
+}
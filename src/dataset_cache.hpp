@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Cache de datasets binarios de LightGBM (carpeta cache_datasets/).
+// La primera vez que se entrena con un archivo de texto se agrega save_binary=true
+// y el <data>.bin que deja LightGBM se mueve a cache_datasets/<clave>.bin. Para
+// que trabajos simultáneos con el mismo texto (folds en paralelo, semillas) no
+// escriban el mismo <data>.bin, cada uno entrena con un enlace al texto en su
+// propio directorio (cache_datasets/staging/) y LightGBM deja el binario ahí. Las
+// corridas siguientes apuntan data=/valid= al binario con un config derivado
+// (cache_datasets/configs/), sin volver a parsear ni a discretizar el texto.
+// La clave depende del contenido del archivo (y de sus .weight/.init/.query), de
+// los parámetros que cambian el binning (max_bin, categorical_feature, ...) y
+// del binario de LightGBM; un valid además depende de la clave de su train,
+// porque se discretiza con los bins del train.
+struct DatasetCacheEntry {
+	std::string role;                  // train | valid
+	std::filesystem::path source;      // archivo de texto del config original
+	std::string key;
+	std::filesystem::path cached;      // cache_datasets/<clave>.bin
+	std::filesystem::path staged;      // miss: enlace al texto en el directorio del trabajo
+	bool hit = false;
+};
+
+struct DatasetCachePlan {
+	std::filesystem::path config;      // config que recibe LightGBM (original o derivado)
+	std::vector<DatasetCacheEntry> datasets;
+	std::filesystem::path staging;     // directorio propio del trabajo si hay misses
+
+	bool train_hit() const { return !datasets.empty() && datasets[0].hit; }
+};
+
+// Tiempo de carga informado por LightGBM ("Finished loading data in X seconds")
+// frente al de la carga desde texto que generó el binario
+struct DatasetLoadReport {
+	double load_seconds = -1.0;        // -1 = LightGBM no lo informó
+	double text_seconds = -1.0;        // -1 = desconocido
+	bool from_binary = false;
+
+	double saved_seconds() const {
+		return from_binary && load_seconds >= 0.0 && text_seconds >= 0.0 ? text_seconds - load_seconds : 0.0;
+	}
+};
+
+// Segundos de "Finished loading data in X seconds" si la línea es esa (-1 si no)
+double parse_lightgbm_load_seconds(const std::string& line);
+
+class DatasetCache {
+public:
+	DatasetCache(std::string db_path = "resultados.db", std::filesystem::path root = "cache_datasets",
+		bool enabled = true);
+
+	bool enabled() const { return enabled_; }
+
+	// Plan para un config de entrenamiento (con task=predict o la cache desactivada
+	// devuelve el config original sin datasets)
+	DatasetCachePlan prepare(const std::filesystem::path& config, const std::string& lightgbm_hash);
+
+	// Después de correr LightGBM: mueve a la cache los binarios nuevos, registra la
+	// carga en carga_datasets y devuelve el ahorro frente a la carga desde texto
+	DatasetLoadReport finish(const DatasetCachePlan& plan, bool ok, double load_seconds,
+		const std::string& run_id, const std::string& stage, int fold);
+
+	double total_saved_seconds() const { return total_saved_seconds_; }
+	int hits() const { return hits_; }
+
+private:
+	std::string db_path_;
+	std::filesystem::path root_;
+	bool enabled_;
+	double total_saved_seconds_ = 0.0;
+	int hits_ = 0;
+	int staged_ = 0;                   // directorios de staging creados por este proceso
+	std::mutex mtx_;
+};
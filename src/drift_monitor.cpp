@@ -0,0 +1,394 @@
+#include "drift_monitor.hpp"
+#include "io_utils.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define RED     "\033[31m"
+#define YELLOW  "\033[33m"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	// |v| por debajo de este valor cae en el bucket del cero
+	const double MIN_INDEXED = 1e-9;
+	// Desplazamiento de los índices logarítmicos: clave > 0 para valores positivos,
+	// < 0 para negativos y 0 para el cero, con el orden de los valores
+	const int KEY_OFFSET = 1 << 16;
+
+	struct Line {
+		const char* begin;
+		const char* end;
+	};
+
+	bool is_blank(const char* b, const char* e) {
+		for (; b < e; ++b) {
+			if (*b != ' ' && *b != '\t' && *b != '\r') return false;
+		}
+		return true;
+	}
+
+	// Campos de una línea; con separador espacio se ignoran los espacios repetidos
+	template <typename F>
+	size_t for_each_field(const char* b, const char* e, char sep, F&& f) {
+		size_t n = 0;
+		if (sep == ' ') {
+			while (b < e) {
+				while (b < e && (*b == ' ' || *b == '\t')) ++b;
+				if (b == e) break;
+				const char* s = b;
+				while (b < e && *b != ' ' && *b != '\t') ++b;
+				f(n++, s, b);
+			}
+			return n;
+		}
+		while (true) {
+			const char* s = b;
+			while (b < e && *b != sep) ++b;
+			f(n++, s, b);
+			if (b == e) return n;
+			++b;
+		}
+	}
+
+	// Vacío, "na", "null" o texto no numérico: faltante (strtod ya lee "nan")
+	double parse_value(const char* b, const char* e) {
+		while (b < e && (*b == ' ' || *b == '"')) ++b;
+		if (b == e) return numeric_limits<double>::quiet_NaN();
+		char buf[64];
+		size_t len = min<size_t>(e - b, sizeof(buf) - 1);
+		memcpy(buf, b, len);
+		buf[len] = '\0';
+		char* end = nullptr;
+		double v = strtod(buf, &end);
+		return end == buf ? numeric_limits<double>::quiet_NaN() : v;
+	}
+
+	// Clave del bucket en la posición q de la distribución (sin faltantes)
+	int key_at_quantile(const map<int, uint64_t>& buckets, uint64_t count, double q) {
+		double rank = q * (count - 1);
+		uint64_t seen = 0;
+		for (const auto& [key, n] : buckets) {
+			seen += n;
+			if (seen > rank) return key;
+		}
+		return buckets.rbegin()->first;
+	}
+
+	double psi_term(double expected, double actual) {
+		const double EPS = 1e-4;
+		expected = max(expected, EPS);
+		actual = max(actual, EPS);
+		return (actual - expected) * log(actual / expected);
+	}
+} // namespace
+
+QuantileSketch::QuantileSketch(double alpha, int max_buckets)
+	: gamma_((1.0 + alpha) / (1.0 - alpha)), log_gamma_(log(gamma_)), max_buckets_(max(2, max_buckets)) {
+}
+
+int QuantileSketch::key_for(double value) const {
+	double magnitude = fabs(value);
+	if (magnitude <= MIN_INDEXED) return 0;
+	double idx = ceil(log(magnitude) / log_gamma_);
+	int key = static_cast<int>(min<double>(max<double>(idx, 1.0 - KEY_OFFSET), KEY_OFFSET)) + KEY_OFFSET;
+	return value > 0 ? key : -key;
+}
+
+double QuantileSketch::bucket_value(int key) const {
+	if (key == 0) return 0.0;
+	double value = 2.0 * pow(gamma_, abs(key) - KEY_OFFSET) / (gamma_ + 1.0);
+	return key > 0 ? value : -value;
+}
+
+void QuantileSketch::DenseStore::add(int key, int max_buckets) {
+	if (counts.empty()) {
+		offset = key;
+		counts.assign(1, 0);
+	}
+	else if (key < offset) {
+		// Crece hacia abajo hasta max_buckets; más abajo cae en el bucket más bajo
+		int max_key = offset + static_cast<int>(counts.size()) - 1;
+		int new_min = max(key, max_key - max_buckets + 1);
+		if (new_min < offset) {
+			counts.insert(counts.begin(), static_cast<size_t>(offset - new_min), 0);
+			offset = new_min;
+		}
+		key = max(key, offset);
+	}
+	else if (key >= offset + static_cast<int>(counts.size())) {
+		// Crece hacia arriba; si se pasa de max_buckets los más bajos se suman al nuevo mínimo
+		int new_min = max(offset, key - max_buckets + 1);
+		uint64_t collapsed = 0;
+		if (new_min > offset) {
+			size_t drop = min(counts.size(), static_cast<size_t>(new_min - offset));
+			for (size_t i = 0; i < drop; ++i) collapsed += counts[i];
+			counts.erase(counts.begin(), counts.begin() + drop);
+			offset = new_min;
+		}
+		counts.resize(static_cast<size_t>(key - offset) + 1, 0);
+		counts[0] += collapsed;
+	}
+	counts[static_cast<size_t>(key - offset)]++;
+}
+
+void QuantileSketch::add(double value) {
+	if (std::isnan(value)) {
+		missing_++;
+		return;
+	}
+	count_++;
+	int key = key_for(value);
+	if (key > 0) positive_.add(key, max_buckets_);
+	else if (key < 0) negative_.add(key, max_buckets_);
+	else zero_++;
+}
+
+map<int, uint64_t> QuantileSketch::bucket_counts() const {
+	map<int, uint64_t> buckets;
+	for (const DenseStore* store : { &negative_, &positive_ }) {
+		for (size_t i = 0; i < store->counts.size(); ++i) {
+			if (store->counts[i] > 0) buckets.emplace_hint(buckets.end(), store->offset + static_cast<int>(i), store->counts[i]);
+		}
+	}
+	if (zero_ > 0) buckets[0] = zero_;
+	return buckets;
+}
+
+double QuantileSketch::quantile(double q) const {
+	if (count_ == 0) return numeric_limits<double>::quiet_NaN();
+	return bucket_value(key_at_quantile(bucket_counts(), count_, min(1.0, max(0.0, q))));
+}
+
+DatasetProfile profile_dataset(const fs::path& path, int label_column, bool has_header, int expected_features,
+	const DriftOptions& options) {
+	TraceSpan span("perfil_dataset", "drift");
+	DatasetProfile profile;
+	profile.path = path;
+	ifstream file(path, ios::binary);
+	if (!file) {
+		cerr << RED << "[ERROR] No se pudo abrir el dataset " << path.string() << RESET << endl;
+		return profile;
+	}
+	auto t0 = chrono::steady_clock::now();
+	int threads = options.num_threads > 0 ? options.num_threads : static_cast<int>(thread::hardware_concurrency());
+	threads = max(1, threads);
+
+	char sep = 0;
+	bool header_pending = has_header;
+	int label = -1;
+	size_t columns = 0;
+	int features = 0;
+	vector<char> data;
+	size_t carry = 0;            // bytes de una línea incompleta al final del bloque anterior
+	vector<Line> lines;
+	vector<double> block;        // filas x features del bloque, row-major
+	atomic<bool> bad_line{ false };
+	bool eof = false;
+
+	while (!eof) {
+		size_t chunk = max<size_t>(options.chunk_bytes, 1 << 16);
+		data.resize(carry + chunk);
+		file.read(data.data() + carry, static_cast<streamsize>(chunk));
+		size_t got = static_cast<size_t>(file.gcount());
+		eof = got < chunk;
+		profile.bytes += got;
+		size_t size = carry + got;
+		// Se procesa hasta el último salto de línea; el resto pasa al próximo bloque
+		size_t usable = size;
+		if (!eof) {
+			while (usable > 0 && data[usable - 1] != '\n') --usable;
+			if (usable == 0) {
+				carry = size;    // línea más larga que el bloque: se sigue leyendo
+				continue;
+			}
+		}
+
+		lines.clear();
+		const char* p = data.data();
+		const char* end = data.data() + usable;
+		while (p < end) {
+			const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+			const char* e = nl ? nl : end;
+			const char* le = e > p && e[-1] == '\r' ? e - 1 : e;
+			if (!is_blank(p, le)) {
+				if (sep == 0) {
+					string first(p, le);
+					sep = first.find(',') != string::npos ? ',' : (first.find('\t') != string::npos ? '\t' : ' ');
+				}
+				if (header_pending) {
+					header_pending = false;
+					for_each_field(p, le, sep, [&](size_t, const char* b, const char* fe) { profile.names.emplace_back(b, fe); });
+				}
+				else {
+					lines.push_back({ p, le });
+				}
+			}
+			p = e + 1;
+		}
+
+		if (!lines.empty() && columns == 0) {
+			columns = for_each_field(lines[0].begin, lines[0].end, sep, [](size_t, const char*, const char*) {});
+			label = expected_features >= 0 && static_cast<int>(columns) == expected_features ? -1 : label_column;
+			if (label >= static_cast<int>(columns)) {
+				cerr << RED << "[ERROR] label_column=" << label << " fuera de rango en " << path.string() << RESET << endl;
+				return profile;
+			}
+			features = static_cast<int>(columns) - (label >= 0 ? 1 : 0);
+			if (profile.names.size() == columns && label >= 0) profile.names.erase(profile.names.begin() + label);
+			if (static_cast<int>(profile.names.size()) != features) {
+				profile.names.clear();
+				for (int f = 0; f < features; ++f) profile.names.push_back("Column_" + to_string(f));
+			}
+			profile.features.assign(features, QuantileSketch(options.alpha, options.max_buckets));
+		}
+
+		if (!lines.empty()) {
+			// Parseo en paralelo por rangos de filas
+			size_t rows = lines.size();
+			block.resize(rows * features);
+			int parse_threads = static_cast<int>(min<size_t>(threads, max<size_t>(1, rows / 1024)));
+			auto parse = [&](int t) {
+				for (size_t r = rows * t / parse_threads; r < rows * (t + 1) / parse_threads; ++r) {
+					double* out = block.data() + r * features;
+					size_t n = for_each_field(lines[r].begin, lines[r].end, sep, [&](size_t c, const char* b, const char* e) {
+						if (c >= columns || static_cast<int>(c) == label) return;
+						out[static_cast<int>(c) - (label >= 0 && static_cast<int>(c) > label ? 1 : 0)] = parse_value(b, e);
+					});
+					if (n != columns) bad_line = true;
+				}
+			};
+			vector<thread> pool;
+			for (int t = 1; t < parse_threads; ++t) pool.emplace_back(parse, t);
+			parse(0);
+			for (auto& th : pool) th.join();
+			if (bad_line) {
+				cerr << RED << "[ERROR] " << path.string() << " tiene filas con distinta cantidad de columnas (se esperaban "
+					<< columns << ")" << RESET << endl;
+				return profile;
+			}
+
+			// Sketches en paralelo por bloques de columnas: cada hilo es dueño de sus features
+			int column_threads = min(threads, features);
+			auto update = [&](int t) {
+				int f0 = features * t / column_threads;
+				int f1 = features * (t + 1) / column_threads;
+				for (size_t r = 0; r < rows; ++r) {
+					const double* row = block.data() + r * features;
+					for (int f = f0; f < f1; ++f) profile.features[f].add(row[f]);
+				}
+			};
+			pool.clear();
+			for (int t = 1; t < column_threads; ++t) pool.emplace_back(update, t);
+			update(0);
+			for (auto& th : pool) th.join();
+			profile.rows += rows;
+		}
+
+		carry = size - usable;
+		if (carry > 0) memmove(data.data(), data.data() + usable, carry);
+	}
+
+	profile.seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+	profile.ok = features > 0;
+	if (!profile.ok) cerr << RED << "[ERROR] " << path.string() << " no tiene filas de datos" << RESET << endl;
+	return profile;
+}
+
+DatasetProfile profile_config_dataset(const fs::path& config, int expected_features, const DriftOptions& options) {
+	auto params = read_config_map(config.string());
+	string path = config_get(params, CONFIG_DATA_KEYS);
+	if (path.empty()) {
+		cerr << RED << "[ERROR] " << config.string() << " no declara data=" << RESET << endl;
+		return DatasetProfile();
+	}
+	string header = config_get(params, { "header", "has_header" }, "false");
+	string label = config_get(params, { "label_column", "label" }, "0");
+	int label_column = 0;
+	if (!label.empty() && isdigit(static_cast<unsigned char>(label[0]))) label_column = atoi(label.c_str());
+	else if (label != "0") {
+		cerr << YELLOW << "[WARN] label_column=" << label << " no soportado; se usa la columna 0" << RESET << endl;
+	}
+	return profile_dataset(path, label_column, header == "true" || header == "1", expected_features, options);
+}
+
+vector<FeatureDrift> compare_profiles(const DatasetProfile& train, const DatasetProfile& test, int psi_bins) {
+	TraceSpan span("comparar_perfiles", "drift");
+	vector<FeatureDrift> result;
+	size_t features = min(train.features.size(), test.features.size());
+	if (train.features.size() != test.features.size()) {
+		cerr << YELLOW << "[WARN] Train tiene " << train.features.size() << " features y test " << test.features.size()
+			<< "; se comparan las primeras " << features << RESET << endl;
+	}
+	for (size_t f = 0; f < features; ++f) {
+		const QuantileSketch& a = train.features[f];
+		const QuantileSketch& b = test.features[f];
+		map<int, uint64_t> buckets_a = a.bucket_counts(), buckets_b = b.bucket_counts();
+		FeatureDrift d;
+		d.feature = static_cast<int>(f);
+		d.name = train.names[f];
+		double total_a = static_cast<double>(a.count() + a.missing());
+		double total_b = static_cast<double>(b.count() + b.missing());
+		d.train_missing = total_a > 0 ? a.missing() / total_a : 0.0;
+		d.test_missing = total_b > 0 ? b.missing() / total_b : 0.0;
+
+		// PSI: bins con los cuantiles de train (los repetidos se unen: features discretas)
+		// más un bin de faltantes
+		vector<int> edges;
+		if (a.count() > 0) {
+			for (int i = 1; i < psi_bins; ++i) {
+				edges.push_back(key_at_quantile(buckets_a, a.count(), static_cast<double>(i) / psi_bins));
+			}
+			edges.erase(unique(edges.begin(), edges.end()), edges.end());
+		}
+		vector<double> mass_a(edges.size() + 1, 0.0), mass_b(edges.size() + 1, 0.0);
+		for (const auto& [key, n] : buckets_a) mass_a[lower_bound(edges.begin(), edges.end(), key) - edges.begin()] += n;
+		for (const auto& [key, n] : buckets_b) mass_b[lower_bound(edges.begin(), edges.end(), key) - edges.begin()] += n;
+		if (total_a > 0 && total_b > 0) {
+			for (size_t i = 0; i < mass_a.size(); ++i) d.psi += psi_term(mass_a[i] / total_a, mass_b[i] / total_b);
+			if (a.missing() > 0 || b.missing() > 0) d.psi += psi_term(d.train_missing, d.test_missing);
+		}
+
+		// KS sobre la unión de buckets en orden de valor
+		if (a.count() > 0 && b.count() > 0) {
+			auto ia = buckets_a.begin(), ea = buckets_a.end();
+			auto ib = buckets_b.begin(), eb = buckets_b.end();
+			double ca = 0.0, cb = 0.0;
+			while (ia != ea || ib != eb) {
+				int key = ib == eb || (ia != ea && ia->first < ib->first) ? ia->first : ib->first;
+				if (ia != ea && ia->first == key) ca += (ia++)->second;
+				if (ib != eb && ib->first == key) cb += (ib++)->second;
+				d.ks = max(d.ks, fabs(ca / a.count() - cb / b.count()));
+			}
+		}
+		else if (a.count() != b.count()) {
+			d.ks = 1.0;
+		}
+		result.push_back(d);
+	}
+	return result;
+}
+
+bool save_drift_csv(const fs::path& path, const vector<FeatureDrift>& drift) {
+	vector<FeatureDrift> sorted = drift;
+	sort(sorted.begin(), sorted.end(), [](const FeatureDrift& x, const FeatureDrift& y) { return x.psi > y.psi; });
+	ofstream out(path);
+	if (!out) return false;
+	out << "feature,nombre,psi,ks,faltantes_train,faltantes_test\n";
+	for (const FeatureDrift& d : sorted) {
+		out << d.feature << "," << d.name << "," << d.psi << "," << d.ks << "," << d.train_missing << "," << d.test_missing << "\n";
+	}
+	return static_cast<bool>(out);
+}
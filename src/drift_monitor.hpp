@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// Monitor de drift entre el dataset de entrenamiento (train_all) y el de
+// inferencia (test). Cada archivo se lee una sola vez, por bloques de tamaño
+// fijo, así que la memoria no depende del tamaño del archivo: las filas de un
+// bloque se parsean en paralelo y luego cada hilo actualiza los sketches de su
+// bloque de columnas. Con los sketches de ambos lados se calcula PSI y KS por
+// feature; antes de la inferencia final el pipeline falla si superan el umbral.
+
+// Sketch de cuantiles con error relativo acotado (estilo DDSketch): buckets
+// logarítmicos de ancho gamma = (1 + alpha) / (1 - alpha), contiguos en un vector
+// por signo. Si el rango supera max_buckets se juntan los buckets más bajos, así
+// la memoria por feature queda fija.
+class QuantileSketch {
+public:
+	explicit QuantileSketch(double alpha = 0.01, int max_buckets = 2048);
+
+	void add(double value);  // NaN cuenta como faltante
+
+	uint64_t count() const { return count_; }      // valores no faltantes
+	uint64_t missing() const { return missing_; }
+	size_t buckets() const { return negative_.counts.size() + positive_.counts.size() + 1; }
+	// Bucket -> cantidad (sin los vacíos), ordenado por valor; las claves de dos
+	// sketches con el mismo alpha coinciden
+	std::map<int, uint64_t> bucket_counts() const;
+	// Valor representativo de un bucket
+	double bucket_value(int key) const;
+	// Cuantil q en [0, 1] (NaN si no hay valores)
+	double quantile(double q) const;
+
+private:
+	// Buckets contiguos desde la clave offset
+	struct DenseStore {
+		int offset = 0;
+		std::vector<uint64_t> counts;
+		void add(int key, int max_buckets);
+	};
+
+	int key_for(double value) const;
+
+	double gamma_;
+	double log_gamma_;
+	int max_buckets_;
+	uint64_t count_ = 0;
+	uint64_t missing_ = 0;
+	uint64_t zero_ = 0;
+	DenseStore negative_;
+	DenseStore positive_;
+};
+
+struct DriftOptions {
+	double alpha = 0.01;               // error relativo de los sketches
+	int max_buckets = 2048;            // buckets por feature y signo
+	int psi_bins = 10;                 // bins de PSI por cuantiles de train (más uno de faltantes)
+	int num_threads = 0;               // 0 = hardware_concurrency
+	size_t chunk_bytes = 8u << 20;     // bytes leídos por bloque
+};
+
+// Perfil de un dataset: un sketch por feature y el costo de leerlo
+struct DatasetProfile {
+	bool ok = false;
+	std::filesystem::path path;
+	uint64_t rows = 0;
+	uint64_t bytes = 0;
+	double seconds = 0.0;
+	std::vector<std::string> names;
+	std::vector<QuantileSketch> features;
+	double rows_per_second() const { return seconds > 0.0 ? rows / seconds : 0.0; }
+	double mb_per_second() const { return seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0; }
+};
+
+// Lee un archivo de datos de LightGBM (CSV/TSV/espacios) en una pasada.
+// label_column: columna a descartar (-1 = ninguna). expected_features >= 0: si el
+// archivo tiene exactamente esa cantidad de columnas se asume que no trae etiqueta.
+DatasetProfile profile_dataset(const std::filesystem::path& path, int label_column, bool has_header,
+	int expected_features, const DriftOptions& options);
+
+// Mismo perfil para el data= de un config de LightGBM (header=, label_column=)
+DatasetProfile profile_config_dataset(const std::filesystem::path& config, int expected_features,
+	const DriftOptions& options);
+
+struct FeatureDrift {
+	int feature = 0;
+	std::string name;
+	double psi = 0.0;                  // Population Stability Index (bins por cuantiles de train + faltantes)
+	double ks = 0.0;                   // máxima diferencia entre las CDF de los valores no faltantes
+	double train_missing = 0.0;        // fracción de faltantes
+	double test_missing = 0.0;
+};
+
+std::vector<FeatureDrift> compare_profiles(const DatasetProfile& train, const DatasetProfile& test, int psi_bins = 10);
+
+// drift_features.csv: una fila por feature, ordenadas por PSI descendente
+bool save_drift_csv(const std::filesystem::path& path, const std::vector<FeatureDrift>& drift);
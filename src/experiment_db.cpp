@@ -0,0 +1,395 @@
+#include "experiment_db.hpp"
+#include "database.hpp"
+#include "hashing.hpp"
+#include "io_utils.hpp"
+#include "trace.hpp"
+
+#include <sqlite3.h>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define YELLOW  "\033[33m"
+#define CYAN    "\033[36m"
+
+using namespace std;
+
+namespace {
+	const int SCHEMA_VERSION = 1;
+
+	const char* SCHEMA_SQL =
+		"CREATE TABLE IF NOT EXISTS corridas ("
+		"run_id TEXT PRIMARY KEY, experimento TEXT, fecha_inicio TEXT, fecha_fin TEXT, estado TEXT, "
+		"num_folds INTEGER, num_repeats INTEGER, num_clases INTEGER);"
+		"CREATE INDEX IF NOT EXISTS idx_corridas_fecha ON corridas (fecha_inicio);"
+		"CREATE TABLE IF NOT EXISTS configs (hash TEXT PRIMARY KEY, texto TEXT, creado TEXT);"
+		"CREATE TABLE IF NOT EXISTS resultados_fold ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, run_id TEXT NOT NULL, tipo TEXT NOT NULL, "
+		"repeticion INTEGER NOT NULL, fold INTEGER NOT NULL, fecha TEXT, config_hash TEXT, modelo_hash TEXT, "
+		"id_resultado INTEGER, accuracy REAL, f1_macro REAL, kappa REAL);"
+		"CREATE UNIQUE INDEX IF NOT EXISTS idx_fold_clave ON resultados_fold (run_id, tipo, repeticion, fold);"
+		"CREATE INDEX IF NOT EXISTS idx_fold_kappa ON resultados_fold (kappa DESC);"
+		"CREATE INDEX IF NOT EXISTS idx_fold_f1 ON resultados_fold (f1_macro DESC);"
+		"CREATE INDEX IF NOT EXISTS idx_fold_config ON resultados_fold (config_hash);"
+		// Agregados por corrida: sumas para media y varianza de QWK sin recorrer los folds
+		"CREATE TABLE IF NOT EXISTS agregados_corrida ("
+		"run_id TEXT PRIMARY KEY, n INTEGER DEFAULT 0, "
+		"suma_kappa REAL DEFAULT 0, suma2_kappa REAL DEFAULT 0, suma_f1 REAL DEFAULT 0, suma_accuracy REAL DEFAULT 0, "
+		"media_kappa REAL, var_kappa REAL, min_kappa REAL, max_kappa REAL, media_f1 REAL, media_accuracy REAL, "
+		"holdout_kappa REAL, holdout_f1 REAL);"
+		"CREATE INDEX IF NOT EXISTS idx_agregados_kappa ON agregados_corrida (media_kappa DESC);"
+		"CREATE INDEX IF NOT EXISTS idx_agregados_f1 ON agregados_corrida (media_f1 DESC);"
+		"CREATE INDEX IF NOT EXISTS idx_agregados_holdout ON agregados_corrida (holdout_kappa DESC);"
+		"CREATE TRIGGER IF NOT EXISTS trg_fold_insert AFTER INSERT ON resultados_fold WHEN NEW.tipo = 'fold' BEGIN "
+		"INSERT OR IGNORE INTO agregados_corrida (run_id) VALUES (NEW.run_id); "
+		"UPDATE agregados_corrida SET n = n + 1, suma_kappa = suma_kappa + NEW.kappa, "
+		"suma2_kappa = suma2_kappa + NEW.kappa * NEW.kappa, suma_f1 = suma_f1 + NEW.f1_macro, "
+		"suma_accuracy = suma_accuracy + NEW.accuracy, "
+		"min_kappa = MIN(COALESCE(min_kappa, NEW.kappa), NEW.kappa), "
+		"max_kappa = MAX(COALESCE(max_kappa, NEW.kappa), NEW.kappa) WHERE run_id = NEW.run_id; "
+		"UPDATE agregados_corrida SET media_kappa = suma_kappa / n, media_f1 = suma_f1 / n, "
+		"media_accuracy = suma_accuracy / n, "
+		"var_kappa = CASE WHEN n > 1 THEN MAX((suma2_kappa - suma_kappa * suma_kappa / n) / (n - 1), 0) ELSE 0 END "
+		"WHERE run_id = NEW.run_id; "
+		"END;"
+		// Al borrar un fold (reemplazo al reanudar) se restan sus sumas; min/max salen del índice de la corrida
+		"CREATE TRIGGER IF NOT EXISTS trg_fold_delete AFTER DELETE ON resultados_fold WHEN OLD.tipo = 'fold' BEGIN "
+		"UPDATE agregados_corrida SET n = n - 1, suma_kappa = suma_kappa - OLD.kappa, "
+		"suma2_kappa = suma2_kappa - OLD.kappa * OLD.kappa, suma_f1 = suma_f1 - OLD.f1_macro, "
+		"suma_accuracy = suma_accuracy - OLD.accuracy, "
+		"min_kappa = (SELECT MIN(kappa) FROM resultados_fold WHERE run_id = OLD.run_id AND tipo = 'fold'), "
+		"max_kappa = (SELECT MAX(kappa) FROM resultados_fold WHERE run_id = OLD.run_id AND tipo = 'fold') "
+		"WHERE run_id = OLD.run_id; "
+		"UPDATE agregados_corrida SET "
+		"media_kappa = CASE WHEN n > 0 THEN suma_kappa / n END, media_f1 = CASE WHEN n > 0 THEN suma_f1 / n END, "
+		"media_accuracy = CASE WHEN n > 0 THEN suma_accuracy / n END, "
+		"var_kappa = CASE WHEN n > 1 THEN MAX((suma2_kappa - suma_kappa * suma_kappa / n) / (n - 1), 0) ELSE 0 END "
+		"WHERE run_id = OLD.run_id; "
+		"END;"
+		"CREATE TRIGGER IF NOT EXISTS trg_holdout_insert AFTER INSERT ON resultados_fold WHEN NEW.tipo = 'holdout' BEGIN "
+		"INSERT OR IGNORE INTO agregados_corrida (run_id) VALUES (NEW.run_id); "
+		"UPDATE agregados_corrida SET holdout_kappa = NEW.kappa, holdout_f1 = NEW.f1_macro WHERE run_id = NEW.run_id; "
+		"END;"
+		"CREATE TRIGGER IF NOT EXISTS trg_holdout_delete AFTER DELETE ON resultados_fold WHEN OLD.tipo = 'holdout' BEGIN "
+		"UPDATE agregados_corrida SET holdout_kappa = NULL, holdout_f1 = NULL WHERE run_id = OLD.run_id; "
+		"END;"
+		"CREATE VIEW IF NOT EXISTS leaderboard AS "
+		"SELECT a.run_id, c.experimento, c.fecha_inicio, a.n AS folds, a.media_kappa, a.var_kappa, "
+		"a.min_kappa, a.max_kappa, a.media_f1, a.media_accuracy, a.holdout_kappa, a.holdout_f1 "
+		"FROM agregados_corrida a LEFT JOIN corridas c ON c.run_id = a.run_id "
+		"WHERE a.n > 0 ORDER BY a.media_kappa DESC;";
+
+	// Fecha ISO (ordenable) en lugar del formato de ctime que usa resultados
+	string iso_now() {
+		time_t now = time(0);
+		char buffer[32];
+		strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&now));
+		return buffer;
+	}
+
+	string iso_from_ctime(const string& fecha) {
+		tm t = {};
+		istringstream in(fecha);
+		in >> get_time(&t, "%a %b %d %H:%M:%S %Y");
+		if (in.fail()) return fecha;
+		char buffer[32];
+		strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &t);
+		return buffer;
+	}
+
+	sqlite3* open_experiments(const string& db_path) {
+		sqlite3* db;
+		if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
+			cerr << "No se puede abrir la base de datos: " << sqlite3_errmsg(db) << endl;
+			sqlite3_close(db);
+			return nullptr;
+		}
+		sqlite3_busy_timeout(db, 5000);
+		return db;
+	}
+
+	bool has_table(sqlite3* db, const char* name) {
+		sqlite3_stmt* stmt;
+		bool exists = false;
+		if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+			sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+			exists = sqlite3_step(stmt) == SQLITE_ROW;
+			sqlite3_finalize(stmt);
+		}
+		return exists;
+	}
+
+	string column_text(sqlite3_stmt* stmt, int col) {
+		const unsigned char* value = sqlite3_column_text(stmt, col);
+		return value ? string(reinterpret_cast<const char*>(value)) : string();
+	}
+
+	// Guarda el texto del config una sola vez y devuelve su hash
+	string store_config(sqlite3* db, const string& text) {
+		if (text.empty()) return string();
+		Fnv1a h;
+		h.update(text);
+		string hash = h.hex();
+		sqlite3_stmt* stmt;
+		if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO configs (hash, texto, creado) VALUES (?, ?, ?);",
+			-1, &stmt, nullptr) == SQLITE_OK) {
+			string fecha = iso_now();
+			sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, text.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, fecha.c_str(), -1, SQLITE_STATIC);
+			sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+		}
+		return hash;
+	}
+
+	// Borra e inserta (no INSERT OR REPLACE, que no dispara el trigger de borrado)
+	void upsert_fold(sqlite3* db, const FoldResultRecord& r, const string& config_hash, const string& fecha) {
+		sqlite3_stmt* stmt;
+		if (sqlite3_prepare_v2(db, "DELETE FROM resultados_fold WHERE run_id = ? AND tipo = ? AND repeticion = ? AND fold = ?;",
+			-1, &stmt, nullptr) == SQLITE_OK) {
+			sqlite3_bind_text(stmt, 1, r.run_id.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, r.kind.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int(stmt, 3, r.repeat);
+			sqlite3_bind_int(stmt, 4, r.fold);
+			sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+		}
+		if (sqlite3_prepare_v2(db, "INSERT INTO resultados_fold (run_id, tipo, repeticion, fold, fecha, config_hash, "
+			"modelo_hash, id_resultado, accuracy, f1_macro, kappa) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);",
+			-1, &stmt, nullptr) != SQLITE_OK) {
+			cerr << "Error al insertar resultado de fold: " << sqlite3_errmsg(db) << endl;
+			return;
+		}
+		sqlite3_bind_text(stmt, 1, r.run_id.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, r.kind.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int(stmt, 3, r.repeat);
+		sqlite3_bind_int(stmt, 4, r.fold);
+		sqlite3_bind_text(stmt, 5, fecha.c_str(), -1, SQLITE_STATIC);
+		if (config_hash.empty()) sqlite3_bind_null(stmt, 6);
+		else sqlite3_bind_text(stmt, 6, config_hash.c_str(), -1, SQLITE_STATIC);
+		if (r.model_hash.empty()) sqlite3_bind_null(stmt, 7);
+		else sqlite3_bind_text(stmt, 7, r.model_hash.c_str(), -1, SQLITE_STATIC);
+		if (r.id_resultado >= 0) sqlite3_bind_int(stmt, 8, r.id_resultado);
+		else sqlite3_bind_null(stmt, 8);
+		sqlite3_bind_double(stmt, 9, r.accuracy);
+		sqlite3_bind_double(stmt, 10, r.f1_macro);
+		sqlite3_bind_double(stmt, 11, r.kappa);
+		if (sqlite3_step(stmt) != SQLITE_DONE) {
+			cerr << "Error al insertar resultado de fold: " << sqlite3_errmsg(db) << endl;
+		}
+		sqlite3_finalize(stmt);
+	}
+
+	// Filas de resultados anteriores al esquema. Las que tienen run_id conservan su corrida;
+	// las más viejas se agrupan en corridas "legacy_<id>": empieza una nueva cuando el
+	// número de fold no avanza o después de un holdout.
+	int migrate_results(sqlite3* db) {
+		ensure_column(db, "resultados", "run_id", "TEXT");
+		ensure_column(db, "resultados", "modelo_hash", "TEXT");
+		sqlite3_stmt* stmt;
+		if (sqlite3_prepare_v2(db, "SELECT id, fecha, accuracy, f1_macro, kappa, modelo, config_text, run_id, modelo_hash "
+			"FROM resultados ORDER BY id;", -1, &stmt, nullptr) != SQLITE_OK) {
+			return 0; // base nueva: no hay nada que migrar
+		}
+
+		const regex fold_re("fold_(\\d+)");
+		const regex repeat_re("repeat_(\\d+)");
+		struct RunInfo { string first_date, last_date; int folds = 0; int repeats = 1; };
+		map<string, RunInfo> runs;
+		string legacy_run;
+		int last_fold = -1;
+		bool closed = true;
+		int migrated = 0;
+
+		while (sqlite3_step(stmt) == SQLITE_ROW) {
+			FoldResultRecord r;
+			r.id_resultado = sqlite3_column_int(stmt, 0);
+			string fecha = iso_from_ctime(column_text(stmt, 1));
+			r.accuracy = sqlite3_column_double(stmt, 2);
+			r.f1_macro = sqlite3_column_double(stmt, 3);
+			r.kappa = sqlite3_column_double(stmt, 4);
+			string modelo = column_text(stmt, 5);
+			string config_text = column_text(stmt, 6);
+			r.run_id = column_text(stmt, 7);
+			r.model_hash = column_text(stmt, 8);
+
+			smatch m;
+			if (modelo.find("holdout") != string::npos) r.kind = "holdout";
+			else if (regex_search(modelo, m, fold_re)) r.fold = stoi(m[1]);
+			else continue; // modelo final u otros: no son resultados de validación
+			if (regex_search(modelo, m, repeat_re)) r.repeat = stoi(m[1]);
+
+			if (r.run_id.empty()) {
+				bool new_run = closed || (r.kind == "fold" && r.repeat == 0 && r.fold <= last_fold);
+				if (new_run) {
+					legacy_run = "legacy_" + to_string(r.id_resultado);
+					last_fold = -1;
+				}
+				r.run_id = legacy_run;
+				if (r.kind == "fold" && r.repeat == 0) last_fold = r.fold;
+				closed = r.kind == "holdout";
+			}
+
+			RunInfo& info = runs[r.run_id];
+			if (info.first_date.empty()) info.first_date = fecha;
+			info.last_date = fecha;
+			if (r.kind == "fold") {
+				info.folds = max(info.folds, r.fold + 1);
+				info.repeats = max(info.repeats, r.repeat + 1);
+			}
+			upsert_fold(db, r, store_config(db, config_text), fecha);
+			migrated++;
+		}
+		sqlite3_finalize(stmt);
+
+		for (const auto& [run_id, info] : runs) {
+			if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO corridas (run_id, experimento, fecha_inicio, fecha_fin, estado, "
+				"num_folds, num_repeats) VALUES (?, 'migrada', ?, ?, 'migrada', ?, ?);", -1, &stmt, nullptr) != SQLITE_OK) break;
+			sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, info.first_date.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, info.last_date.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int(stmt, 4, info.folds);
+			sqlite3_bind_int(stmt, 5, info.repeats);
+			sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+		}
+		return migrated;
+	}
+} // namespace
+
+void ensure_experiment_schema(const string& db_path) {
+	TraceSpan span("sqlite_esquema_experimentos", "sqlite");
+	sqlite3* db = open_experiments(db_path);
+	if (!db) return;
+
+	char* errMsg = nullptr;
+	sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr);
+	if (sqlite3_exec(db, SCHEMA_SQL, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+		cerr << "Error al crear el esquema de experimentos: " << errMsg << endl;
+		sqlite3_free(errMsg);
+		sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+		sqlite3_close(db);
+		return;
+	}
+	// Índices sobre la tabla histórica; sobre la misma conexión, que ya tiene el lock
+	if (has_table(db, "resultados") && has_table(db, "predicciones")) {
+		ensure_column(db, "resultados", "run_id", "TEXT");
+		ensure_results_indexes(db);
+	}
+
+	int version = 0;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK) {
+		if (sqlite3_step(stmt) == SQLITE_ROW) version = sqlite3_column_int(stmt, 0);
+		sqlite3_finalize(stmt);
+	}
+	if (version < SCHEMA_VERSION) {
+		int migrated = migrate_results(db);
+		sqlite3_exec(db, ("PRAGMA user_version = " + to_string(SCHEMA_VERSION) + ";").c_str(), nullptr, nullptr, nullptr);
+		if (migrated > 0) {
+			cout << CYAN << "[SQLITE] " << migrated << " resultado(s) migrados al esquema de experimentos" << RESET << endl;
+		}
+	}
+	sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+	sqlite3_close(db);
+}
+
+void record_run_start(const string& run_id, const string& experiment, int num_folds, int num_repeats,
+	int num_classes, const string& db_path) {
+	sqlite3* db = open_experiments(db_path);
+	if (!db) return;
+	sqlite3_stmt* stmt;
+	// Al reanudar se conserva la fecha de inicio original
+	if (sqlite3_prepare_v2(db, "INSERT INTO corridas (run_id, experimento, fecha_inicio, estado, num_folds, num_repeats, "
+		"num_clases) VALUES (?, ?, ?, 'en_curso', ?, ?, ?) "
+		"ON CONFLICT(run_id) DO UPDATE SET estado = 'en_curso', fecha_fin = NULL;", -1, &stmt, nullptr) == SQLITE_OK) {
+		string fecha = iso_now();
+		sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, experiment.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 3, fecha.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int(stmt, 4, num_folds);
+		sqlite3_bind_int(stmt, 5, num_repeats);
+		sqlite3_bind_int(stmt, 6, num_classes);
+		if (sqlite3_step(stmt) != SQLITE_DONE) cerr << "Error al registrar la corrida: " << sqlite3_errmsg(db) << endl;
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+}
+
+void record_run_end(const string& run_id, const string& status, const string& db_path) {
+	sqlite3* db = open_experiments(db_path);
+	if (!db) return;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "UPDATE corridas SET estado = ?, fecha_fin = ? WHERE run_id = ?;",
+		-1, &stmt, nullptr) == SQLITE_OK) {
+		string fecha = iso_now();
+		sqlite3_bind_text(stmt, 1, status.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 3, run_id.c_str(), -1, SQLITE_STATIC);
+		sqlite3_step(stmt);
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+}
+
+void record_fold_result(const FoldResultRecord& record, const string& db_path) {
+	TraceSpan span("sqlite_resultado_fold", "sqlite");
+	string config_text = record.config_path.empty() ? string() : read_config(record.config_path);
+	sqlite3* db = open_experiments(db_path);
+	if (!db) return;
+	sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr);
+	string config_hash = store_config(db, config_text);
+	upsert_fold(db, record, config_hash, iso_now());
+	sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+	sqlite3_close(db);
+}
+
+void print_leaderboard(int top_n, const string& order_by, const string& db_path) {
+	// Cada orden tiene su índice en agregados_corrida: se leen sólo las N primeras filas
+	string column = "media_kappa";
+	if (order_by == "f1") column = "media_f1";
+	else if (order_by == "holdout") column = "holdout_kappa";
+	else if (order_by != "kappa") {
+		cerr << YELLOW << "[WARN] top_by=" << order_by << " desconocido; se ordena por kappa" << RESET << endl;
+	}
+
+	sqlite3* db = open_experiments(db_path);
+	if (!db) return;
+	string sql = "SELECT a.run_id, c.experimento, c.fecha_inicio, a.n, a.media_kappa, a.var_kappa, a.min_kappa, "
+		"a.max_kappa, a.media_f1, a.media_accuracy, a.holdout_kappa "
+		"FROM agregados_corrida a LEFT JOIN corridas c ON c.run_id = a.run_id "
+		"WHERE a." + column + " IS NOT NULL AND a.n > 0 ORDER BY a." + column + " DESC LIMIT ?;";
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+		cerr << "Error al consultar el leaderboard: " << sqlite3_errmsg(db) << endl;
+		sqlite3_close(db);
+		return;
+	}
+	sqlite3_bind_int(stmt, 1, top_n);
+
+	cout << CYAN << "\n=== Top " << top_n << " corridas por " << column << " ===" << RESET << endl;
+	printf("%-4s %-26s %-12s %-19s %5s %16s %7s %7s %7s %7s %8s\n", "#", "run_id", "experimento", "inicio",
+		"folds", "QWK media+-std", "min", "max", "F1", "acc", "holdout");
+	int rank = 0;
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		double std_kappa = sqrt(max(0.0, sqlite3_column_double(stmt, 5)));
+		string holdout = sqlite3_column_type(stmt, 10) == SQLITE_NULL ? string("-")
+			: to_string(sqlite3_column_double(stmt, 10)).substr(0, 6);
+		printf("%-4d %-26s %-12s %-19s %5d %8.4f+-%.4f %7.4f %7.4f %7.4f %7.4f %8s\n", ++rank,
+			column_text(stmt, 0).c_str(), column_text(stmt, 1).c_str(), column_text(stmt, 2).c_str(),
+			sqlite3_column_int(stmt, 3), sqlite3_column_double(stmt, 4), std_kappa,
+			sqlite3_column_double(stmt, 6), sqlite3_column_double(stmt, 7),
+			sqlite3_column_double(stmt, 8), sqlite3_column_double(stmt, 9), holdout.c_str());
+	}
+	if (rank == 0) cout << "(sin corridas registradas)" << endl;
+	sqlite3_finalize(stmt);
+	sqlite3_close(db);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+
+// Esquema de experimentos en resultados.db (convive con la tabla histórica resultados):
+//   corridas            una fila por run_id (experimento, folds, repeticiones, clases, fechas)
+//   configs             texto de cada config una sola vez, por hash de contenido
+//   resultados_fold     métricas por fold/holdout de cada corrida, indexadas por métrica
+//   agregados_corrida   media/varianza/min/max de QWK y medias de F1/accuracy por corrida,
+//                       mantenidos por triggers al insertar o borrar en resultados_fold
+//   leaderboard         vista ordenada de agregados_corrida (índice por media de QWK)
+// La primera vez migra las filas existentes de resultados (PRAGMA user_version = 1).
+
+void ensure_experiment_schema(const std::string& db_path = "resultados.db");
+
+void record_run_start(const std::string& run_id, const std::string& experiment, int num_folds, int num_repeats,
+	int num_classes, const std::string& db_path = "resultados.db");
+
+// status: terminada | fallida | abortada
+void record_run_end(const std::string& run_id, const std::string& status = "terminada",
+	const std::string& db_path = "resultados.db");
+
+struct FoldResultRecord {
+	std::string run_id;
+	std::string kind = "fold";     // fold | holdout
+	int repeat = 0;
+	int fold = -1;
+	std::string config_path;
+	std::string model_hash;
+	int id_resultado = -1;         // fila equivalente en resultados
+	double accuracy = 0.0;
+	double f1_macro = 0.0;
+	double kappa = 0.0;
+};
+
+// Reemplaza el resultado (run_id, tipo, repetición, fold) si ya existía
+void record_fold_result(const FoldResultRecord& record, const std::string& db_path = "resultados.db");
+
+// Top-N de corridas por media de QWK (order_by: kappa | f1 | holdout)
+void print_leaderboard(int top_n, const std::string& order_by = "kappa", const std::string& db_path = "resultados.db");
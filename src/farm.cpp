@@ -0,0 +1,262 @@
+#include "farm.hpp"
+#include "job_queue.hpp"
+#include "io_utils.hpp"
+#include "metrics.hpp"
+#include "process.hpp"
+#include "trace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define RED     "\033[31m"
+#define GREEN   "\033[32m"
+#define YELLOW  "\033[33m"
+#define CYAN    "\033[36m"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	string worker_id() {
+		char host[256] = "worker";
+#ifdef _WIN32
+		DWORD size = sizeof(host);
+		GetComputerNameA(host, &size);
+		int pid = _getpid();
+#else
+		gethostname(host, sizeof(host) - 1);
+		int pid = static_cast<int>(getpid());
+#endif
+		return string(host) + "-" + to_string(pid);
+	}
+
+	string read_file_bytes(const fs::path& path) {
+		ifstream file(path, ios::binary);
+		stringstream buffer;
+		buffer << file.rdbuf();
+		return buffer.str();
+	}
+
+	bool write_file_bytes(const fs::path& path, const string& data) {
+		std::error_code ec;
+		if (path.has_parent_path()) fs::create_directories(path.parent_path(), ec);
+		// Archivo nuevo: el anterior puede ser un hard link a un objeto del registro
+		fs::remove(path, ec);
+		ofstream file(path, ios::binary);
+		file.write(data.data(), static_cast<streamsize>(data.size()));
+		return static_cast<bool>(file);
+	}
+
+	// Salida declarada en un config (con el default de LightGBM si no está)
+	fs::path config_output(const fs::path& config, const vector<string>& keys, const char* fallback) {
+		return config_get(read_config_map(config.string()), keys, fallback);
+	}
+
+	// Ejecuta un trabajo en el directorio temporal del worker
+	JobOutcome execute_job(const QueueJob& job, const fs::path& lightgbm_path, const fs::path& scratch) {
+		JobOutcome o;
+		std::error_code ec;
+		fs::create_directories(scratch, ec);
+		fs::path model = scratch / "model.txt";
+		fs::path preds = scratch / "predictions.txt";
+		fs::path cfg_train = scratch / "config_train.txt";
+		fs::path cfg_pred = scratch / "config_pred.txt";
+
+		// Las salidas van al directorio local; save_binary desactivado para que varios
+		// workers no escriban el mismo .bin junto al dataset compartido
+		write_file_bytes(cfg_train, rewrite_config_overrides(job.config_train, {
+			{ CONFIG_OUTPUT_MODEL_KEYS, model.string() },
+			{ CONFIG_SAVE_BINARY_KEYS, "false" } }));
+		write_file_bytes(cfg_pred, rewrite_config_overrides(job.config_pred, {
+			{ CONFIG_INPUT_MODEL_KEYS, model.string() },
+			{ CONFIG_RESULT_KEYS, preds.string() } }));
+
+		ProcessStats train = run_process(lightgbm_path.string() + " config=" + cfg_train.string());
+		o.wall_ms = train.wall_ms;
+		o.peak_rss_mb = train.peak_rss_bytes / (1024.0 * 1024.0);
+		o.exit_code = train.exit_code;
+		if (train.exit_code != 0) {
+			o.failed_phase = "train";
+			o.error = "LightGBM train exit_code=" + to_string(train.exit_code);
+			return o;
+		}
+		ProcessStats pred = run_process(lightgbm_path.string() + " config=" + cfg_pred.string());
+		o.wall_ms += pred.wall_ms;
+		o.peak_rss_mb = max(o.peak_rss_mb, pred.peak_rss_bytes / (1024.0 * 1024.0));
+		o.exit_code = pred.exit_code;
+		if (pred.exit_code != 0) {
+			o.failed_phase = "predict";
+			o.error = "LightGBM predict exit_code=" + to_string(pred.exit_code);
+			return o;
+		}
+
+		o.model = read_file_bytes(model);
+		o.predictions = read_file_bytes(preds);
+		if (!job.labels_path.empty() && fs::exists(job.labels_path)) {
+			vector<int> y_true = read_labels(job.labels_path);
+			int cols = 0;
+			vector<double> probs = read_probabilities(preds.string(), cols);
+			vector<int> y_pred = argmax_classes(probs, cols);
+			if (!y_true.empty() && y_true.size() == y_pred.size()) {
+				o.has_metrics = true;
+				o.accuracy = accuracy(y_true, y_pred);
+				o.f1_macro = f1_score_macro(y_true, y_pred, job.num_classes);
+				o.kappa = quadratic_weighted_kappa(y_true, y_pred, job.num_classes);
+			}
+		}
+		o.ok = true;
+		return o;
+	}
+} // namespace
+
+vector<int> farm_run_jobs(const string& run_id, const vector<FarmJob>& jobs, int num_classes, const FarmSettings& settings) {
+	TraceSpan span("farm_coordinador", "farm");
+	JobQueue queue(settings.queue_db);
+	vector<int> status(jobs.size(), -1);
+	vector<int64_t> ids(jobs.size(), -1);
+
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		QueueJob job;
+		job.name = jobs[i].name;
+		job.kind = jobs[i].kind;
+		job.fold = jobs[i].fold;
+		job.num_classes = num_classes;
+		job.config_train = read_config(jobs[i].config_train.string());
+		job.config_pred = read_config(jobs[i].config_pred.string());
+		job.labels_path = jobs[i].labels.string();
+		ids[i] = queue.publish(run_id, job, settings.max_attempts);
+		if (ids[i] == -1) status[i] = 1;
+	}
+	cout << CYAN << "[FARM] " << jobs.size() << " trabajos publicados en " << settings.queue_db
+		<< "; esperando workers (PetFinderLGBM --worker queue_db=" << settings.queue_db << ")" << RESET << endl;
+
+	size_t pending = 0;
+	for (int s : status) pending += s == -1;
+	string last_progress;
+	auto last_activity = chrono::steady_clock::now();
+	while (pending > 0) {
+		int requeued = queue.requeue_expired();
+		if (requeued > 0) {
+			cerr << YELLOW << "[FARM] " << requeued << " trabajo(s) con lease vencido vuelven a la cola" << RESET << endl;
+		}
+
+		for (size_t i = 0; i < jobs.size(); ++i) {
+			if (status[i] != -1) continue;
+			JobOutcome o;
+			string estado = queue.status(ids[i], o);
+			if (estado == "completo") {
+				fs::path model_out = config_output(jobs[i].config_train, CONFIG_OUTPUT_MODEL_KEYS, "LightGBM_model.txt");
+				fs::path pred_out = config_output(jobs[i].config_pred, CONFIG_RESULT_KEYS, "LightGBM_predict_result.txt");
+				bool written = write_file_bytes(model_out, o.model) && write_file_bytes(pred_out, o.predictions);
+				status[i] = written ? 0 : 2;
+				printf(GREEN "[FARM] %s completo en %s: wall=%.1f s | pico=%.0f MB",
+					jobs[i].name.c_str(), o.worker.c_str(), o.wall_ms / 1000.0, o.peak_rss_mb);
+				if (o.has_metrics) printf(" | Kappa=%.4f", o.kappa);
+				printf(RESET "\n");
+				if (!written) cerr << RED << "[FARM] No se pudieron escribir las salidas de " << jobs[i].name << RESET << endl;
+			}
+			else if (estado == "fallido") {
+				status[i] = o.failed_phase == "predict" ? 2 : 1;
+				cerr << RED << "[FARM] " << jobs[i].name << " fallido (" << o.error << ")" << RESET << endl;
+			}
+			if (status[i] != -1) pending--;
+		}
+
+		QueueCounts c = queue.counts(run_id);
+		string progress = "[FARM] completos " + to_string(c.done) + " | asignados " + to_string(c.leased) +
+			" | pendientes " + to_string(c.pending) + " | fallidos " + to_string(c.failed);
+		if (progress != last_progress) {
+			cout << progress << endl;
+			last_progress = progress;
+			last_activity = chrono::steady_clock::now();
+		}
+		// Un trabajo asignado tiene un worker que renueva su lease (si muere, vence y se reencola)
+		else if (c.leased > 0) {
+			last_activity = chrono::steady_clock::now();
+		}
+		double idle = chrono::duration<double>(chrono::steady_clock::now() - last_activity).count();
+		if (pending > 0 && settings.wait_timeout_seconds > 0 && idle >= settings.wait_timeout_seconds) {
+			int abandoned = queue.abandon(run_id, "sin workers activos");
+			cerr << RED << "[FARM] Sin workers activos durante " << settings.wait_timeout_seconds << " s; "
+				<< abandoned << " trabajo(s) pendientes se dan por fallidos" << RESET << endl;
+			for (int& s : status) {
+				if (s == -1) s = 1;
+			}
+			break;
+		}
+		if (pending > 0) this_thread::sleep_for(chrono::seconds(1));
+	}
+	return status;
+}
+
+int run_worker(const fs::path& lightgbm_path, const FarmSettings& settings) {
+	JobQueue queue(settings.queue_db);
+	string id = worker_id();
+	fs::path scratch_root = fs::temp_directory_path() / "petfinder_worker" / id;
+	cout << CYAN << "[WORKER] " << id << " atendiendo " << settings.queue_db << RESET << endl;
+
+	auto idle_since = chrono::steady_clock::now();
+	int jobs_done = 0;
+	while (true) {
+		QueueJob job;
+		if (!queue.lease(id, settings.lease_seconds, job)) {
+			double idle = chrono::duration<double>(chrono::steady_clock::now() - idle_since).count();
+			if (settings.idle_exit_seconds > 0 && idle >= settings.idle_exit_seconds) break;
+			this_thread::sleep_for(chrono::seconds(1));
+			continue;
+		}
+
+		cout << "[WORKER] " << job.name << " (trabajo " << job.id << ", intento " << job.attempt << ")" << endl;
+		// Heartbeat: renueva el lease mientras LightGBM corre
+		atomic<bool> running{ true };
+		atomic<bool> lost{ false };
+		thread heartbeat([&] {
+			auto period = chrono::milliseconds(max(1, settings.lease_seconds) * 1000 / 3);
+			auto next = chrono::steady_clock::now() + period;
+			while (running) {
+				this_thread::sleep_for(chrono::milliseconds(200));
+				if (chrono::steady_clock::now() < next) continue;
+				next += period;
+				if (!queue.heartbeat(job.id, id, settings.lease_seconds) && !lost.exchange(true)) {
+					cerr << YELLOW << "[WORKER] No se pudo renovar el lease de " << job.name << RESET << endl;
+				}
+			}
+		});
+
+		JobOutcome outcome = execute_job(job, lightgbm_path, scratch_root / to_string(job.id));
+		running = false;
+		heartbeat.join();
+
+		// La entrega sólo se acepta si el lease sigue siendo de este worker
+		if (!queue.complete(job.id, id, outcome)) {
+			cerr << YELLOW << "[WORKER] Lease perdido para " << job.name << "; se descarta el resultado" << RESET << endl;
+		}
+		else if (outcome.ok) {
+			cout << GREEN << "[WORKER] " << job.name << " entregado" << RESET << endl;
+			jobs_done++;
+		}
+		else {
+			cerr << RED << "[WORKER] " << job.name << " fallo: " << outcome.error << RESET << endl;
+		}
+		std::error_code ec;
+		fs::remove_all(scratch_root / to_string(job.id), ec);
+		idle_since = chrono::steady_clock::now();
+	}
+	cout << CYAN << "[WORKER] " << id << " sin trabajos; termina tras " << jobs_done << " trabajo(s)" << RESET << endl;
+	return 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Modo coordinador/worker: el coordinador publica los trabajos de folds y
+// holdout en la cola compartida (job_queue.hpp) y los workers, en este u otros
+// nodos, los ejecutan con su LightGBM local. Los datos se referencian por ruta,
+// así que todos deben ver los mismos archivos (carpeta compartida) y correr
+// desde el mismo directorio de trabajo relativo.
+struct FarmSettings {
+	std::string queue_db = "cola_trabajos.db";
+	int lease_seconds = 60;          // el worker renueva el lease cada lease/3
+	int max_attempts = 3;            // intentos por trabajo antes de darlo por fallido
+	int idle_exit_seconds = 0;       // worker: termina tras N s sin trabajos (0 = nunca)
+	int wait_timeout_seconds = 600;  // coordinador: abandona tras N s sin workers activos (0 = nunca)
+};
+
+// Trabajo que publica el coordinador: entrenar + predecir un fold o el holdout
+struct FarmJob {
+	std::string name;                // ej. fold_3, r1_fold_0, holdout
+	std::string kind;                // fold | holdout
+	int fold = -1;
+	std::filesystem::path config_train;
+	std::filesystem::path config_pred;
+	std::filesystem::path labels;    // etiquetas de validación (métricas en el worker)
+};
+
+// Publica los trabajos y espera a que terminen. El modelo y las predicciones que
+// devuelve cada worker se escriben en las rutas de salida de los configs originales.
+// Devuelve por trabajo: 0 = ok, 1 = falló el entrenamiento, 2 = falló la predicción.
+// Si durante wait_timeout_seconds ningún trabajo está asignado ni cambia de estado
+// (no hay workers vivos), los pendientes se marcan fallidos y cuentan como 1.
+std::vector<int> farm_run_jobs(const std::string& run_id, const std::vector<FarmJob>& jobs,
+	int num_classes, const FarmSettings& settings);
+
+// Bucle del worker: toma trabajos de la cola, corre LightGBM y entrega resultados
+int run_worker(const std::filesystem::path& lightgbm_path, const FarmSettings& settings);
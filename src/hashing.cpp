@@ -0,0 +1,228 @@
+#include "hashing.hpp"
+
+#include <sqlite3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	struct MemoEntry {
+		uintmax_t size = 0;
+		int64_t mtime = 0;
+		string hash;
+	};
+
+	mutex memo_mtx;
+	string memo_db;                                // "" = sólo en memoria
+	unordered_map<string, MemoEntry> memo;
+
+	bool hash_content(const fs::path& path, string& hex) {
+		ifstream file(path, ios::binary);
+		if (!file) return false;
+		Fnv1a h;
+		vector<char> buffer(1 << 20);
+		while (file) {
+			file.read(buffer.data(), buffer.size());
+			h.update(buffer.data(), static_cast<size_t>(file.gcount()));
+		}
+		hex = h.hex();
+		return true;
+	}
+
+	sqlite3* open_memo_db(const string& db_path) {
+		sqlite3* db;
+		if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
+			cerr << "No se puede abrir la base de datos: " << sqlite3_errmsg(db) << endl;
+			sqlite3_close(db);
+			return nullptr;
+		}
+		sqlite3_busy_timeout(db, 5000);
+		sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS hash_archivos ("
+			"ruta TEXT PRIMARY KEY, bytes INTEGER, mtime INTEGER, hash TEXT);", nullptr, nullptr, nullptr);
+		return db;
+	}
+
+	void persist_memo(const string& db_path, const string& key, const MemoEntry& entry) {
+		sqlite3* db = open_memo_db(db_path);
+		if (!db) return;
+		sqlite3_stmt* stmt;
+		if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO hash_archivos (ruta, bytes, mtime, hash) VALUES (?, ?, ?, ?);",
+			-1, &stmt, nullptr) == SQLITE_OK) {
+			sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(entry.size));
+			sqlite3_bind_int64(stmt, 3, entry.mtime);
+			sqlite3_bind_text(stmt, 4, entry.hash.c_str(), -1, SQLITE_STATIC);
+			sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+		}
+		sqlite3_close(db);
+	}
+
+	const uint32_t SHA256_K[64] = {
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2 };
+
+	inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+} // namespace
+
+void Fnv1a::update(const void* data, size_t size) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t h = hash_;
+	for (size_t i = 0; i < size; ++i) {
+		h ^= bytes[i];
+		h *= 1099511628211ull;
+	}
+	hash_ = h;
+}
+
+bool Fnv1a::update_file(const fs::path& path) {
+	string hex = hash_file_hex(path);
+	if (hex.empty()) return false;
+	update(hex);
+	return true;
+}
+
+string Fnv1a::hex() const {
+	char buf[17];
+	snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash_));
+	return string(buf);
+}
+
+Sha256::Sha256() {
+	const uint32_t init[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+	copy(init, init + 8, state_);
+}
+
+void Sha256::compress(const unsigned char* block) {
+	uint32_t w[64];
+	for (int i = 0; i < 16; ++i) {
+		w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) | (uint32_t(block[4 * i + 2]) << 8)
+			| uint32_t(block[4 * i + 3]);
+	}
+	for (int i = 16; i < 64; ++i) {
+		uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+	uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+	uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+	for (int i = 0; i < 64; ++i) {
+		uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+		uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+	state_[0] += a; state_[1] += b; state_[2] += c; state_[3] += d;
+	state_[4] += e; state_[5] += f; state_[6] += g; state_[7] += h;
+}
+
+void Sha256::update(const void* data, size_t size) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	length_ += size;
+	if (buffered_ > 0) {
+		size_t take = min(size, sizeof(buffer_) - buffered_);
+		copy(bytes, bytes + take, buffer_ + buffered_);
+		buffered_ += take;
+		bytes += take;
+		size -= take;
+		if (buffered_ < sizeof(buffer_)) return;
+		compress(buffer_);
+		buffered_ = 0;
+	}
+	for (; size >= 64; bytes += 64, size -= 64) compress(bytes);
+	copy(bytes, bytes + size, buffer_);
+	buffered_ = size;
+}
+
+string Sha256::hex() {
+	// Relleno: 0x80, ceros y la longitud en bits (big endian) al final del último bloque
+	uint64_t bits = length_ * 8;
+	unsigned char pad[72] = { 0x80 };
+	size_t pad_size = (buffered_ < 56 ? 56 : 120) - buffered_;
+	for (int i = 0; i < 8; ++i) pad[pad_size + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+	update(pad, pad_size + 8);
+	char buf[65];
+	for (int i = 0; i < 8; ++i) snprintf(buf + 8 * i, 9, "%08x", state_[i]);
+	return string(buf, 64);
+}
+
+string sha256_file_hex(const fs::path& path) {
+	ifstream file(path, ios::binary);
+	if (!file) return string();
+	Sha256 h;
+	vector<char> buffer(1 << 20);
+	while (file) {
+		file.read(buffer.data(), buffer.size());
+		h.update(buffer.data(), static_cast<size_t>(file.gcount()));
+	}
+	return h.hex();
+}
+
+string hash_file_hex(const fs::path& path) {
+	std::error_code ec;
+	fs::path absolute = fs::absolute(path, ec);
+	MemoEntry entry;
+	entry.size = fs::file_size(path, ec);
+	fs::file_time_type written = ec ? fs::file_time_type() : fs::last_write_time(path, ec);
+	string hex;
+	if (ec) return hash_content(path, hex) ? hex : string();
+	entry.mtime = static_cast<int64_t>(written.time_since_epoch().count());
+	string key = absolute.generic_string();
+	{
+		lock_guard<mutex> lock(memo_mtx);
+		auto it = memo.find(key);
+		if (it != memo.end() && it->second.size == entry.size && it->second.mtime == entry.mtime) return it->second.hash;
+	}
+	if (!hash_content(path, hex)) return string();
+	if (fs::file_time_type::clock::now() - written < chrono::seconds(2)) return hex;
+	entry.hash = hex;
+	string db_path;
+	{
+		lock_guard<mutex> lock(memo_mtx);
+		memo[key] = entry;
+		db_path = memo_db;
+	}
+	if (!db_path.empty()) persist_memo(db_path, key, entry);
+	return hex;
+}
+
+void enable_file_hash_memo(const string& db_path) {
+	sqlite3* db = open_memo_db(db_path);
+	if (!db) return;
+	lock_guard<mutex> lock(memo_mtx);
+	memo_db = db_path;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "SELECT ruta, bytes, mtime, hash FROM hash_archivos;", -1, &stmt, nullptr) == SQLITE_OK) {
+		while (sqlite3_step(stmt) == SQLITE_ROW) {
+			const unsigned char* ruta = sqlite3_column_text(stmt, 0);
+			const unsigned char* hash = sqlite3_column_text(stmt, 3);
+			if (!ruta || !hash) continue;
+			MemoEntry& entry = memo[reinterpret_cast<const char*>(ruta)];
+			entry.size = static_cast<uintmax_t>(sqlite3_column_int64(stmt, 1));
+			entry.mtime = sqlite3_column_int64(stmt, 2);
+			entry.hash = reinterpret_cast<const char*>(hash);
+		}
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Hash FNV-1a de 64 bits. No es criptográfico: sólo sirve como huella barata
+// de configs y datasets para detectar si una etapa cambió de entradas.
+class Fnv1a {
+public:
+	void update(const void* data, size_t size);
+	void update(const std::string& text) { update(text.data(), text.size()); }
+	// Agrega el hash del contenido del archivo (hash_file_hex); false si no se pudo leer
+	bool update_file(const std::filesystem::path& path);
+
+	uint64_t value() const { return hash_; }
+	std::string hex() const;
+
+private:
+	uint64_t hash_ = 14695981039346656037ull;
+};
+
+// SHA-256 (FIPS 180-4). Dirección de contenido del registro de modelos, donde
+// dos modelos distintos con el mismo hash compartirían el objeto.
+class Sha256 {
+public:
+	Sha256();
+	void update(const void* data, size_t size);
+	// Digest de 64 caracteres hexadecimales; cierra el hash (no admite más update)
+	std::string hex();
+
+private:
+	void compress(const unsigned char* block);
+
+	uint32_t state_[8];
+	unsigned char buffer_[64];
+	size_t buffered_ = 0;
+	uint64_t length_ = 0;
+};
+
+// SHA-256 del contenido de un archivo ("" si no se pudo leer); sin memoria
+std::string sha256_file_hex(const std::filesystem::path& path);
+
+// Hash del contenido de un archivo en hexadecimal ("" si no se pudo leer).
+// Se memoriza por (ruta absoluta, tamaño, mtime): un archivo que no cambió no se
+// vuelve a leer (folds, train_all, lightgbm.exe en cada huella y clave de dataset).
+// Los archivos modificados hace menos de 2 s no se memorizan, porque otra escritura
+// en el mismo instante podría dejar igual el mtime.
+std::string hash_file_hex(const std::filesystem::path& path);
+
+// Persiste la memoria de hashes en la tabla hash_archivos de db_path y carga la
+// guardada por corridas anteriores (sin llamarla sólo dura lo que el proceso)
+void enable_file_hash_memo(const std::string& db_path);
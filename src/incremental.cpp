@@ -0,0 +1,54 @@
+#include "incremental.hpp"
+#include "io_utils.hpp"
+#include "lgbm_model.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+
+#include <iostream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+bool write_warm_start_config(const fs::path& base_config, const fs::path& out_config, const fs::path& base_model,
+	const fs::path& output_model, const string& data, int extra_iterations) {
+	// Con input_model, LightGBM toma las predicciones del modelo base como puntaje
+	// inicial y num_iterations cuenta sólo los árboles nuevos
+	vector<ConfigOverride> overrides = {
+		{ CONFIG_INPUT_MODEL_KEYS, base_model.generic_string() },
+		{ CONFIG_OUTPUT_MODEL_KEYS, output_model.generic_string() },
+		{ CONFIG_ITERATION_KEYS, to_string(extra_iterations) },
+	};
+	if (!data.empty()) overrides.push_back({ CONFIG_DATA_KEYS, data });
+	return write_config_overrides(base_config, out_config, overrides);
+}
+
+HoldoutScore score_model_on_holdout(const fs::path& model_path, const fs::path& holdout_config,
+	const fs::path& holdout_labels, int num_classes, int num_threads, PredictEngine engine) {
+	TraceSpan span("evaluar_holdout_en_proceso", "modelo");
+	HoldoutScore score;
+	LgbmModel model;
+	DenseDataset data;
+	if (!model.load(model_path) || !load_config_dataset(holdout_config, data, model.num_features())) return score;
+	vector<int> y_true = read_labels(holdout_labels.string());
+	if (y_true.size() != data.rows()) {
+		cerr << "Holdout con " << y_true.size() << " etiquetas y " << data.rows() << " filas" << endl;
+		return score;
+	}
+	int k = model.num_tree_per_iteration();
+	vector<double> probs = predict_proba_engine(model, data, engine, num_threads);
+	if (probs.size() != data.rows() * k) return score;
+	vector<int> y_pred;
+	if (k > 1) {
+		y_pred = argmax_classes(probs, k);
+	}
+	else {
+		// Una sola salida: probabilidad de la clase 1
+		for (double p : probs) y_pred.push_back(p >= 0.5 ? 1 : 0);
+	}
+	score.ok = true;
+	score.rows = y_true.size();
+	score.accuracy = accuracy(y_true, y_pred);
+	score.f1_macro = f1_score_macro(y_true, y_pred, num_classes);
+	score.kappa = quadratic_weighted_kappa(y_true, y_pred, num_classes);
+	return score;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "quickscorer.hpp"
+
+#include <filesystem>
+#include <string>
+
+// Reentrenamiento incremental del modelo final (incremental=1 / --incremental):
+// se continúa el boosting del modelo en producción (input_model de LightGBM) con
+// el dataset combinado o sólo con las filas nuevas, por una cantidad acotada de
+// iteraciones extra. El candidato se compara en holdout con el modelo en
+// producción con el predictor en proceso y sólo se promueve si el QWK no baja.
+
+// Config de continuación: el del entrenamiento completo con input_model = base,
+// num_iterations = iteraciones extra, output_model = output y, si data no está
+// vacío, data = archivo con las filas nuevas
+bool write_warm_start_config(const std::filesystem::path& base_config, const std::filesystem::path& out_config,
+	const std::filesystem::path& base_model, const std::filesystem::path& output_model,
+	const std::string& data, int extra_iterations);
+
+// Métricas de un modelo en el holdout (datos del config de predicción, etiquetas aparte)
+struct HoldoutScore {
+	bool ok = false;
+	size_t rows = 0;
+	double accuracy = 0.0;
+	double f1_macro = 0.0;
+	double kappa = 0.0;
+};
+
+HoldoutScore score_model_on_holdout(const std::filesystem::path& model_path, const std::filesystem::path& holdout_config,
+	const std::filesystem::path& holdout_labels, int num_classes, int num_threads = 0,
+	PredictEngine engine = PredictEngine::Auto);
@@ -3,11 +3,17 @@
 #include <sstream>
 #include <algorithm>
 #include <iostream>
+#include <ctime>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include "trace.hpp"
 
 using namespace std;
 
 // Leer matriz de predicciones (una fila por observacin, con probabilidades)
 vector<int> read_predicted_classes(const string& filename) {
+	TraceSpan span("leer_predicciones", "io");
 	ifstream file(filename);
 	vector<int> predicted_classes;
 	string line;
@@ -24,8 +30,46 @@ vector<int> read_predicted_classes(const string& filename) {
 	return predicted_classes;
 }
 
+// Leer matriz de probabilidades completa (filas x clases, row-major)
+vector<double> read_probabilities(const string& filename, int& num_classes) {
+	TraceSpan span("leer_predicciones", "io");
+	ifstream file(filename);
+	vector<double> probs;
+	num_classes = 0;
+	string line;
+	while (getline(file, line)) {
+		stringstream ss(line);
+		double prob;
+		int cols = 0;
+		while (ss >> prob) {
+			probs.push_back(prob);
+			cols++;
+		}
+		if (cols == 0) continue;
+		if (num_classes == 0) num_classes = cols;
+		else if (cols != num_classes) {
+			cerr << "Fila con " << cols << " columnas (se esperaban " << num_classes << ") en " << filename << endl;
+			num_classes = 0;
+			return {};
+		}
+	}
+	return probs;
+}
+
+// Clase de mayor probabilidad por fila
+vector<int> argmax_classes(const vector<double>& probs, int num_classes) {
+	vector<int> classes;
+	if (num_classes <= 0) return classes;
+	classes.reserve(probs.size() / num_classes);
+	for (size_t i = 0; i + num_classes <= probs.size(); i += num_classes) {
+		classes.push_back(static_cast<int>(max_element(probs.begin() + i, probs.begin() + i + num_classes) - (probs.begin() + i)));
+	}
+	return classes;
+}
+
 // Leer etiquetas reales desde archivo
 vector<int> read_labels(const string& filename) {
+	TraceSpan span("leer_etiquetas", "io");
 	ifstream file(filename);
 	vector<int> labels;
 	int val;
@@ -41,8 +85,124 @@ string read_config(const string& filename) {
 	return buffer.str();
 }
 
+// Lee archivo de configuracion como mapa clave=valor (ignora comentarios '#')
+map<string, string> read_config_map(const string& filename) {
+	ifstream file(filename);
+	map<string, string> params;
+	string line;
+	while (getline(file, line)) {
+		size_t hash = line.find('#');
+		if (hash != string::npos) line.erase(hash);
+		size_t eq = line.find('=');
+		if (eq == string::npos) continue;
+		auto trim = [](string s) {
+			size_t b = s.find_first_not_of(" \t\r\n");
+			size_t e = s.find_last_not_of(" \t\r\n");
+			return b == string::npos ? string() : s.substr(b, e - b + 1);
+		};
+		string key = trim(line.substr(0, eq));
+		if (!key.empty()) params[key] = trim(line.substr(eq + 1));
+	}
+	return params;
+}
+
+// Busca una clave de LightGBM o cualquiera de sus alias
+string config_get(const map<string, string>& params, initializer_list<const char*> keys, const string& default_value) {
+	for (const char* key : keys) {
+		auto it = params.find(key);
+		if (it != params.end()) return it->second;
+	}
+	return default_value;
+}
+
+string config_get(const map<string, string>& params, const vector<string>& keys, const string& default_value) {
+	for (const string& key : keys) {
+		auto it = params.find(key);
+		if (it != params.end()) return it->second;
+	}
+	return default_value;
+}
+
+const vector<string> CONFIG_DATA_KEYS = { "data", "train", "train_data", "train_data_file", "data_filename" };
+const vector<string> CONFIG_VALID_KEYS = { "valid", "test", "valid_data", "valid_data_file", "test_data",
+	"test_data_file", "valid_filenames" };
+const vector<string> CONFIG_OUTPUT_MODEL_KEYS = { "output_model", "model_output", "model_out" };
+const vector<string> CONFIG_INPUT_MODEL_KEYS = { "input_model", "model_input", "model_in" };
+const vector<string> CONFIG_RESULT_KEYS = { "output_result", "predict_result", "prediction_result", "predict_name",
+	"prediction_name", "pred_name", "name_pred" };
+const vector<string> CONFIG_ITERATION_KEYS = { "num_iterations", "num_iteration", "n_iter", "num_tree", "num_trees",
+	"num_round", "num_rounds", "nrounds", "num_boost_round", "n_estimators", "max_iter" };
+const vector<string> CONFIG_THREAD_KEYS = { "num_threads", "num_thread", "nthread", "nthreads", "n_jobs" };
+const vector<string> CONFIG_SAVE_BINARY_KEYS = { "save_binary", "is_save_binary", "is_save_binary_file" };
+
+// Reescribe claves de un config de LightGBM (incluidos sus alias) y agrega las que falten
+string rewrite_config_overrides(const string& text, const vector<ConfigOverride>& overrides) {
+	vector<bool> applied(overrides.size(), false);
+	stringstream in(text), out;
+	string line;
+	while (getline(in, line)) {
+		string clean = line.substr(0, line.find('#'));
+		size_t eq = clean.find('=');
+		string key = eq == string::npos ? string() : clean.substr(0, eq);
+		key.erase(0, key.find_first_not_of(" \t"));
+		key.erase(key.find_last_not_of(" \t\r") + 1);
+		size_t match = overrides.size();
+		for (size_t i = 0; i < overrides.size() && match == overrides.size() && !key.empty(); ++i) {
+			if (find(overrides[i].first.begin(), overrides[i].first.end(), key) != overrides[i].first.end()) match = i;
+		}
+		if (match == overrides.size()) {
+			out << line << "\n";
+			continue;
+		}
+		if (!applied[match] && !overrides[match].second.empty()) {
+			out << overrides[match].first.front() << "=" << overrides[match].second << "\n";
+		}
+		applied[match] = true;
+	}
+	for (size_t i = 0; i < overrides.size(); ++i) {
+		if (!applied[i] && !overrides[i].second.empty()) out << overrides[i].first.front() << "=" << overrides[i].second << "\n";
+	}
+	return out.str();
+}
+
+bool write_config_overrides(const filesystem::path& source, const filesystem::path& target,
+	const vector<ConfigOverride>& overrides) {
+	ifstream in(source);
+	if (!in) {
+		cerr << "No se pudo leer " << source.string() << endl;
+		return false;
+	}
+	stringstream buffer;
+	buffer << in.rdbuf();
+	string text = rewrite_config_overrides(buffer.str(), overrides);
+
+	// Otros trabajos pueden estar leyendo el mismo config: si ya tiene este contenido no se
+	// toca; si no, se escribe a un temporal propio y se renombra encima del anterior
+	ifstream current(target);
+	if (current) {
+		stringstream existing;
+		existing << current.rdbuf();
+		if (existing.str() == text) return true;
+		current.close();
+	}
+	filesystem::path tmp = target;
+	tmp += ".tmp" + to_string(random_device{}());
+	ofstream out(tmp);
+	out << text;
+	out.close();
+	std::error_code ec;
+	if (out) filesystem::rename(tmp, target, ec);
+	if (!out || ec) {
+		cerr << "No se pudo generar " << target.string() << " a partir de " << source.string() << endl;
+		filesystem::remove(tmp, ec);
+		return false;
+	}
+	return true;
+}
+
 // Guarda datos de vector en un archivo CSV
 void save_vector_to_csv(const string& filename, const vector<int>& data) {
+	TraceSpan span("guardar_csv", "io");
 	ofstream file(filename);
 	for (const auto& val : data) {
 		file << val << "\n";
@@ -51,9 +211,22 @@ void save_vector_to_csv(const string& filename, const vector<int>& data) {
 
 // Almacena en un solo archivo CSV las etiquetas reales y las predicciones
 void save_combined_csv(const string& filename, const vector<int>& y_true, const vector<int>& y_pred) {
+	TraceSpan span("guardar_csv", "io");
 	ofstream file(filename);
 	file << "indice,y_true,y_pred\n";
 	for (size_t i = 0; i < y_true.size(); ++i) {
 		file << i << "," << y_true[i] << "," << y_pred[i] << "\n";
 	}
 }
+
+// Identificador de corrida basado en fecha y hora local, con milisegundos y un sufijo
+// aleatorio: dos corridas lanzadas en el mismo segundo no comparten run_id
+string generate_run_id() {
+	auto now = chrono::system_clock::now();
+	time_t seconds = chrono::system_clock::to_time_t(now);
+	int millis = static_cast<int>(chrono::duration_cast<chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+	char buf[48];
+	size_t len = strftime(buf, sizeof(buf), "%Y%m%d_%H%M%S", localtime(&seconds));
+	snprintf(buf + len, sizeof(buf) - len, "_%03d_%04x", millis, static_cast<unsigned>(random_device{}() & 0xffff));
+	return string(buf);
+}
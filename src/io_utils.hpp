@@ -1,15 +1,59 @@
 // Archivo: io_utils.hpp
 #pragma once
+#include <filesystem>
 #include <string>
+#include <utility>
 #include <vector>
+#include <map>
+#include <initializer_list>
 
 std::vector<int> read_labels(const std::string& filename);
 
 std::vector<int> read_predicted_classes(const std::string& filename);
 
+// Probabilidades por fila (filas x clases, row-major); num_classes = columnas leídas
+std::vector<double> read_probabilities(const std::string& filename, int& num_classes);
+
+std::vector<int> argmax_classes(const std::vector<double>& probs, int num_classes);
+
 std::string read_config(const std::string& filename);
 
+// Lee un config de LightGBM (clave=valor, '#' comentarios) como mapa
+std::map<std::string, std::string> read_config_map(const std::string& filename);
+
+// Primer valor presente entre una clave y sus alias (ej. {"data", "train", "train_data"})
+std::string config_get(const std::map<std::string, std::string>& params,
+	std::initializer_list<const char*> keys, const std::string& default_value = "");
+std::string config_get(const std::map<std::string, std::string>& params,
+	const std::vector<std::string>& keys, const std::string& default_value = "");
+
+// Alias de LightGBM de las claves que el pipeline lee o reescribe (la primera es la canónica)
+extern const std::vector<std::string> CONFIG_DATA_KEYS;          // data, train, ...
+extern const std::vector<std::string> CONFIG_VALID_KEYS;         // valid, test, ...
+extern const std::vector<std::string> CONFIG_OUTPUT_MODEL_KEYS;  // output_model, ...
+extern const std::vector<std::string> CONFIG_INPUT_MODEL_KEYS;   // input_model, ...
+extern const std::vector<std::string> CONFIG_RESULT_KEYS;        // output_result, ...
+extern const std::vector<std::string> CONFIG_ITERATION_KEYS;     // num_iterations, ...
+extern const std::vector<std::string> CONFIG_THREAD_KEYS;        // num_threads, ...
+extern const std::vector<std::string> CONFIG_SAVE_BINARY_KEYS;   // save_binary, ...
+
+// Una clave (con sus alias) y su nuevo valor; un valor vacío quita la clave
+using ConfigOverride = std::pair<std::vector<std::string>, std::string>;
+
+// Texto de un config con los overrides aplicados: la línea de cualquier alias se
+// reemplaza por "<clave canónica>=<valor>" (sólo la primera; las repetidas se
+// quitan) y los overrides que no estaban se agregan al final
+std::string rewrite_config_overrides(const std::string& text, const std::vector<ConfigOverride>& overrides);
+
+// Copia el config source en target aplicando los overrides (false si falla). Si target ya
+// tiene ese contenido no se reescribe; si no, se reemplaza de forma atómica (temporal + rename)
+bool write_config_overrides(const std::filesystem::path& source, const std::filesystem::path& target,
+	const std::vector<ConfigOverride>& overrides);
+
 void save_vector_to_csv(const std::string& filename, const std::vector<int>& data);
 
 void save_combined_csv(const std::string& filename, const std::vector<int>& y_true, const std::vector<int>& y_pred);
 
+// Identificador de corrida basado en fecha y hora local (ej. 20250314_153012)
+std::string generate_run_id();
+
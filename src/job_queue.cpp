@@ -0,0 +1,337 @@
+#include "job_queue.hpp"
+#include "trace.hpp"
+
+#include <sqlite3.h>
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+	const char* CREATE_SQL = "CREATE TABLE IF NOT EXISTS cola_trabajos ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"nombre TEXT, "
+		"tipo TEXT, "
+		"fold INTEGER, "
+		"clases INTEGER, "
+		"config_train TEXT, "
+		"config_pred TEXT, "
+		"etiquetas TEXT, "
+		"estado TEXT, "
+		"worker TEXT, "
+		"intentos INTEGER DEFAULT 0, "
+		"max_intentos INTEGER, "
+		"lease_hasta REAL, "
+		"creado REAL, "
+		"terminado REAL, "
+		"exit_code INTEGER, "
+		"fase_fallida TEXT, "
+		"error TEXT, "
+		"wall_ms REAL, "
+		"peak_rss_mb REAL, "
+		"accuracy REAL, "
+		"f1_macro REAL, "
+		"kappa REAL, "
+		"modelo BLOB, "
+		"predicciones BLOB);"
+		"CREATE INDEX IF NOT EXISTS idx_cola_estado ON cola_trabajos (estado, id);"
+		"CREATE INDEX IF NOT EXISTS idx_cola_corrida ON cola_trabajos (run_id, nombre);";
+
+	double now_seconds() {
+		return chrono::duration<double>(chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+	sqlite3* open_queue(const string& db_path) {
+		sqlite3* db;
+		if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
+			cerr << "No se puede abrir la cola de trabajos " << db_path << ": " << sqlite3_errmsg(db) << endl;
+			sqlite3_close(db);
+			return nullptr;
+		}
+		// Varios procesos escriben a la vez: se espera el lock en vez de fallar
+		sqlite3_busy_timeout(db, 15000);
+		sqlite3_exec(db, CREATE_SQL, nullptr, nullptr, nullptr);
+		return db;
+	}
+
+	string column_text(sqlite3_stmt* stmt, int col) {
+		const unsigned char* text = sqlite3_column_text(stmt, col);
+		return text ? reinterpret_cast<const char*>(text) : string();
+	}
+
+	string column_blob(sqlite3_stmt* stmt, int col) {
+		const void* data = sqlite3_column_blob(stmt, col);
+		int size = sqlite3_column_bytes(stmt, col);
+		return data ? string(static_cast<const char*>(data), size) : string();
+	}
+} // namespace
+
+JobQueue::JobQueue(string db_path) : db_path_(std::move(db_path)) {
+}
+
+int64_t JobQueue::publish(const string& run_id, const QueueJob& job, int max_attempts) {
+	sqlite3* db = open_queue(db_path_);
+	if (!db) return -1;
+	int64_t id = -1;
+	sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr);
+
+	sqlite3_stmt* stmt;
+	string estado;
+	bool same_job = false;
+	if (sqlite3_prepare_v2(db, "SELECT id, estado, config_train = ?3 AND config_pred = ?4 AND etiquetas = ?5 AND clases = ?6 "
+		"FROM cola_trabajos WHERE run_id = ?1 AND nombre = ?2 ORDER BY id DESC LIMIT 1;", -1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, job.name.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 3, job.config_train.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 4, job.config_pred.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 5, job.labels_path.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int(stmt, 6, job.num_classes);
+		if (sqlite3_step(stmt) == SQLITE_ROW) {
+			id = sqlite3_column_int64(stmt, 0);
+			estado = column_text(stmt, 1);
+			same_job = sqlite3_column_int(stmt, 2) != 0;
+		}
+		sqlite3_finalize(stmt);
+	}
+
+	if (id != -1 && !same_job) {
+		// Coordinador reiniciado con otros configs: el resultado guardado (o el que
+		// entregue el worker que lo tiene asignado) ya no vale; se vuelve a correr
+		if (sqlite3_prepare_v2(db, "UPDATE cola_trabajos SET estado = 'pendiente', worker = NULL, intentos = 0, "
+			"max_intentos = ?1, clases = ?2, config_train = ?3, config_pred = ?4, etiquetas = ?5, lease_hasta = NULL, "
+			"terminado = NULL, exit_code = NULL, fase_fallida = NULL, error = NULL, wall_ms = NULL, peak_rss_mb = NULL, "
+			"accuracy = NULL, f1_macro = NULL, kappa = NULL, modelo = NULL, predicciones = NULL WHERE id = ?6;",
+			-1, &stmt, nullptr) == SQLITE_OK) {
+			sqlite3_bind_int(stmt, 1, max_attempts);
+			sqlite3_bind_int(stmt, 2, job.num_classes);
+			sqlite3_bind_text(stmt, 3, job.config_train.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 4, job.config_pred.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 5, job.labels_path.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int64(stmt, 6, id);
+			if (sqlite3_step(stmt) != SQLITE_DONE) {
+				cerr << "Error al republicar trabajo " << job.name << ": " << sqlite3_errmsg(db) << endl;
+				id = -1;
+			}
+			sqlite3_finalize(stmt);
+		}
+		else id = -1;
+	}
+	else if (id != -1) {
+		// Coordinador reiniciado: se reutiliza el trabajo; uno fallido se reintenta
+		if (estado == "fallido") {
+			string sql = "UPDATE cola_trabajos SET estado = 'pendiente', worker = NULL, intentos = 0, max_intentos = "
+				+ to_string(max_attempts) + " WHERE id = " + to_string(id) + ";";
+			sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+		}
+	}
+	else if (sqlite3_prepare_v2(db, "INSERT INTO cola_trabajos (run_id, nombre, tipo, fold, clases, config_train, config_pred, "
+		"etiquetas, estado, max_intentos, creado) VALUES (?, ?, ?, ?, ?, ?, ?, ?, 'pendiente', ?, ?);", -1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, job.name.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 3, job.kind.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int(stmt, 4, job.fold);
+		sqlite3_bind_int(stmt, 5, job.num_classes);
+		sqlite3_bind_text(stmt, 6, job.config_train.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 7, job.config_pred.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 8, job.labels_path.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int(stmt, 9, max_attempts);
+		sqlite3_bind_double(stmt, 10, now_seconds());
+		if (sqlite3_step(stmt) == SQLITE_DONE) id = sqlite3_last_insert_rowid(db);
+		else cerr << "Error al publicar trabajo " << job.name << ": " << sqlite3_errmsg(db) << endl;
+		sqlite3_finalize(stmt);
+	}
+
+	sqlite3_exec(db, id != -1 ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+	sqlite3_close(db);
+	return id;
+}
+
+bool JobQueue::lease(const string& worker, int lease_seconds, QueueJob& job) {
+	sqlite3* db = open_queue(db_path_);
+	if (!db) return false;
+	bool found = false;
+	// IMMEDIATE: dos workers no pueden tomar el mismo trabajo
+	if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+		sqlite3_close(db);
+		return false;
+	}
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "SELECT id, nombre, tipo, fold, clases, config_train, config_pred, etiquetas, intentos "
+		"FROM cola_trabajos WHERE estado = 'pendiente' ORDER BY id LIMIT 1;", -1, &stmt, nullptr) == SQLITE_OK) {
+		if (sqlite3_step(stmt) == SQLITE_ROW) {
+			job.id = sqlite3_column_int64(stmt, 0);
+			job.name = column_text(stmt, 1);
+			job.kind = column_text(stmt, 2);
+			job.fold = sqlite3_column_int(stmt, 3);
+			job.num_classes = sqlite3_column_int(stmt, 4);
+			job.config_train = column_text(stmt, 5);
+			job.config_pred = column_text(stmt, 6);
+			job.labels_path = column_text(stmt, 7);
+			job.attempt = sqlite3_column_int(stmt, 8) + 1;
+			found = true;
+		}
+		sqlite3_finalize(stmt);
+	}
+	if (found && sqlite3_prepare_v2(db, "UPDATE cola_trabajos SET estado = 'asignado', worker = ?, intentos = intentos + 1, "
+		"lease_hasta = ? WHERE id = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, worker.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_double(stmt, 2, now_seconds() + lease_seconds);
+		sqlite3_bind_int64(stmt, 3, job.id);
+		found = sqlite3_step(stmt) == SQLITE_DONE;
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_exec(db, found ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+	sqlite3_close(db);
+	return found;
+}
+
+bool JobQueue::heartbeat(int64_t id, const string& worker, int lease_seconds) {
+	sqlite3* db = open_queue(db_path_);
+	if (!db) return false;
+	bool owned = false;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "UPDATE cola_trabajos SET lease_hasta = ? WHERE id = ? AND worker = ? AND estado = 'asignado';",
+		-1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_double(stmt, 1, now_seconds() + lease_seconds);
+		sqlite3_bind_int64(stmt, 2, id);
+		sqlite3_bind_text(stmt, 3, worker.c_str(), -1, SQLITE_STATIC);
+		owned = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) == 1;
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+	return owned;
+}
+
+bool JobQueue::complete(int64_t id, const string& worker, const JobOutcome& o) {
+	TraceSpan span("cola_completar", "sqlite");
+	sqlite3* db = open_queue(db_path_);
+	if (!db) return false;
+	bool owned = false;
+	sqlite3_stmt* stmt;
+	// Sólo el dueño del lease entrega; un fallo con intentos disponibles vuelve a la cola
+	const char* sql = "UPDATE cola_trabajos SET "
+		"estado = CASE WHEN ?1 THEN 'completo' WHEN intentos < max_intentos THEN 'pendiente' ELSE 'fallido' END, "
+		"worker = CASE WHEN ?1 OR intentos >= max_intentos THEN worker ELSE NULL END, "
+		"terminado = ?2, exit_code = ?3, fase_fallida = ?4, error = ?5, wall_ms = ?6, peak_rss_mb = ?7, "
+		"accuracy = ?8, f1_macro = ?9, kappa = ?10, modelo = ?11, predicciones = ?12 "
+		"WHERE id = ?13 AND worker = ?14 AND estado = 'asignado';";
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_int(stmt, 1, o.ok ? 1 : 0);
+		sqlite3_bind_double(stmt, 2, now_seconds());
+		sqlite3_bind_int(stmt, 3, o.exit_code);
+		sqlite3_bind_text(stmt, 4, o.failed_phase.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 5, o.error.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_double(stmt, 6, o.wall_ms);
+		sqlite3_bind_double(stmt, 7, o.peak_rss_mb);
+		if (o.has_metrics) {
+			sqlite3_bind_double(stmt, 8, o.accuracy);
+			sqlite3_bind_double(stmt, 9, o.f1_macro);
+			sqlite3_bind_double(stmt, 10, o.kappa);
+		}
+		sqlite3_bind_blob(stmt, 11, o.model.data(), static_cast<int>(o.model.size()), SQLITE_STATIC);
+		sqlite3_bind_blob(stmt, 12, o.predictions.data(), static_cast<int>(o.predictions.size()), SQLITE_STATIC);
+		sqlite3_bind_int64(stmt, 13, id);
+		sqlite3_bind_text(stmt, 14, worker.c_str(), -1, SQLITE_STATIC);
+		owned = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) == 1;
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+	return owned;
+}
+
+int JobQueue::requeue_expired() {
+	sqlite3* db = open_queue(db_path_);
+	if (!db) return 0;
+	int requeued = 0;
+	sqlite3_stmt* stmt;
+	sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr);
+	double now = now_seconds();
+	if (sqlite3_prepare_v2(db, "UPDATE cola_trabajos SET estado = 'pendiente', worker = NULL "
+		"WHERE estado = 'asignado' AND lease_hasta < ? AND intentos < max_intentos;", -1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_double(stmt, 1, now);
+		if (sqlite3_step(stmt) == SQLITE_DONE) requeued = sqlite3_changes(db);
+		sqlite3_finalize(stmt);
+	}
+	if (sqlite3_prepare_v2(db, "UPDATE cola_trabajos SET estado = 'fallido', error = 'lease vencido sin intentos restantes', "
+		"terminado = ? WHERE estado = 'asignado' AND lease_hasta < ? AND intentos >= max_intentos;", -1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_double(stmt, 1, now);
+		sqlite3_bind_double(stmt, 2, now);
+		sqlite3_step(stmt);
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+	sqlite3_close(db);
+	return requeued;
+}
+
+QueueCounts JobQueue::counts(const string& run_id) {
+	QueueCounts c;
+	sqlite3* db = open_queue(db_path_);
+	if (!db) return c;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "SELECT estado, COUNT(*) FROM cola_trabajos WHERE run_id = ? GROUP BY estado;",
+		-1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+		while (sqlite3_step(stmt) == SQLITE_ROW) {
+			string estado = column_text(stmt, 0);
+			int n = sqlite3_column_int(stmt, 1);
+			if (estado == "pendiente") c.pending = n;
+			else if (estado == "asignado") c.leased = n;
+			else if (estado == "completo") c.done = n;
+			else if (estado == "fallido") c.failed = n;
+		}
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+	return c;
+}
+
+int JobQueue::abandon(const string& run_id, const string& error) {
+	sqlite3* db = open_queue(db_path_);
+	if (!db) return 0;
+	int abandoned = 0;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "UPDATE cola_trabajos SET estado = 'fallido', error = ?, terminado = ? "
+		"WHERE run_id = ? AND estado = 'pendiente';", -1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, error.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_double(stmt, 2, now_seconds());
+		sqlite3_bind_text(stmt, 3, run_id.c_str(), -1, SQLITE_STATIC);
+		if (sqlite3_step(stmt) == SQLITE_DONE) abandoned = sqlite3_changes(db);
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+	return abandoned;
+}
+
+string JobQueue::status(int64_t id, JobOutcome& o) {
+	sqlite3* db = open_queue(db_path_);
+	if (!db) return string();
+	string estado;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "SELECT estado, worker, exit_code, fase_fallida, error, wall_ms, peak_rss_mb, "
+		"accuracy, f1_macro, kappa, modelo, predicciones FROM cola_trabajos WHERE id = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_int64(stmt, 1, id);
+		if (sqlite3_step(stmt) == SQLITE_ROW) {
+			estado = column_text(stmt, 0);
+			if (estado == "completo" || estado == "fallido") {
+				o.ok = estado == "completo";
+				o.worker = column_text(stmt, 1);
+				o.exit_code = sqlite3_column_int(stmt, 2);
+				o.failed_phase = column_text(stmt, 3);
+				o.error = column_text(stmt, 4);
+				o.wall_ms = sqlite3_column_double(stmt, 5);
+				o.peak_rss_mb = sqlite3_column_double(stmt, 6);
+				o.has_metrics = sqlite3_column_type(stmt, 7) != SQLITE_NULL;
+				o.accuracy = sqlite3_column_double(stmt, 7);
+				o.f1_macro = sqlite3_column_double(stmt, 8);
+				o.kappa = sqlite3_column_double(stmt, 9);
+				o.model = column_blob(stmt, 10);
+				o.predictions = column_blob(stmt, 11);
+			}
+		}
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+	return estado;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Cola de trabajos compartida entre el coordinador y los workers (tabla
+// cola_trabajos en un archivo SQLite accesible por todos los nodos).
+// Un trabajo = entrenar + predecir con LightGBM; lleva el texto de los configs y
+// referencias a los datos. Los workers toman trabajos con un lease que renuevan
+// con heartbeats; si el lease vence, el coordinador lo vuelve a encolar.
+//
+// Estados: pendiente -> asignado -> completo | fallido
+
+struct QueueJob {
+	int64_t id = 0;
+	std::string name;            // ej. fold_3, r1_fold_0, holdout
+	std::string kind;            // fold | holdout
+	int fold = -1;
+	int num_classes = 0;
+	std::string config_train;    // texto del config de entrenamiento
+	std::string config_pred;     // texto del config de predicción
+	std::string labels_path;     // etiquetas reales para métricas ("" = no se calculan)
+	int attempt = 0;
+};
+
+struct JobOutcome {
+	bool ok = false;
+	int exit_code = -1;
+	std::string failed_phase;    // train | predict
+	std::string error;
+	std::string worker;
+	double wall_ms = 0.0;
+	double peak_rss_mb = 0.0;
+	bool has_metrics = false;
+	double accuracy = 0.0, f1_macro = 0.0, kappa = 0.0;
+	std::string model;           // contenido de model.txt
+	std::string predictions;     // contenido del archivo de predicciones
+};
+
+struct QueueCounts {
+	int pending = 0, leased = 0, done = 0, failed = 0;
+};
+
+class JobQueue {
+public:
+	explicit JobQueue(std::string db_path);
+
+	// Publica un trabajo; si ya existe uno con el mismo run_id y nombre y los mismos
+	// configs se reutiliza (uno fallido vuelve a pendiente); si los configs cambiaron
+	// se reemplazan y el trabajo vuelve a pendiente aunque estuviera completo.
+	// Devuelve el id o -1.
+	int64_t publish(const std::string& run_id, const QueueJob& job, int max_attempts);
+
+	// Toma el trabajo pendiente más antiguo; false si no hay
+	bool lease(const std::string& worker, int lease_seconds, QueueJob& job);
+
+	// Renueva el lease; false si el trabajo ya no pertenece al worker
+	bool heartbeat(int64_t id, const std::string& worker, int lease_seconds);
+
+	// Entrega el resultado; si falló y quedan intentos vuelve a pendiente.
+	// false si el lease se había perdido (el resultado se descarta).
+	bool complete(int64_t id, const std::string& worker, const JobOutcome& outcome);
+
+	// Reencola los leases vencidos (o los marca fallidos si agotaron intentos);
+	// devuelve cuántos se reencolaron
+	int requeue_expired();
+
+	QueueCounts counts(const std::string& run_id);
+
+	// Marca fallidos los trabajos pendientes de la corrida (el coordinador dejó de
+	// esperar); devuelve cuántos se marcaron
+	int abandon(const std::string& run_id, const std::string& error);
+
+	// Estado actual del trabajo; con completo/fallido llena outcome
+	std::string status(int64_t id, JobOutcome& outcome);
+
+private:
+	std::string db_path_;
+};
@@ -0,0 +1,174 @@
+#include "journal.hpp"
+#include "hashing.hpp"
+#include "io_utils.hpp"
+#include "trace.hpp"
+
+#include <sqlite3.h>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	const char* CREATE_SQL = "CREATE TABLE IF NOT EXISTS journal_etapas ("
+		"run_id TEXT NOT NULL, "
+		"etapa TEXT NOT NULL, "
+		"hash_entrada TEXT, "
+		"estado TEXT, "
+		"intentos INTEGER DEFAULT 0, "
+		"inicio TEXT, "
+		"fin TEXT, "
+		"detalle TEXT, "
+		"PRIMARY KEY (run_id, etapa));";
+
+	string now_text() {
+		time_t now = time(0);
+		string fecha = string(ctime(&now));
+		fecha.pop_back(); // quitar salto de línea
+		return fecha;
+	}
+
+	sqlite3* open_journal(const string& db_path) {
+		sqlite3* db;
+		if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
+			cerr << "No se puede abrir la base de datos: " << sqlite3_errmsg(db) << endl;
+			sqlite3_close(db);
+			return nullptr;
+		}
+		sqlite3_busy_timeout(db, 5000);
+		sqlite3_exec(db, CREATE_SQL, nullptr, nullptr, nullptr);
+		return db;
+	}
+
+	// Archivos de entrada de un config; "valid" puede traer varios separados por coma
+	vector<string> config_inputs(const map<string, string>& params) {
+		vector<string> files;
+		for (auto keys : { config_get(params, CONFIG_DATA_KEYS), config_get(params, CONFIG_VALID_KEYS),
+			config_get(params, CONFIG_INPUT_MODEL_KEYS) }) {
+			stringstream ss(keys);
+			string file;
+			while (getline(ss, file, ',')) {
+				if (!file.empty()) files.push_back(file);
+			}
+		}
+		return files;
+	}
+} // namespace
+
+RunJournal::RunJournal(string db_path, string run_id)
+	: db_path_(std::move(db_path)), run_id_(std::move(run_id)) {
+}
+
+int RunJournal::completed_count() const {
+	lock_guard<mutex> lock(mtx_);
+	sqlite3* db = open_journal(db_path_);
+	if (!db) return 0;
+	int count = 0;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM journal_etapas WHERE run_id = ? AND estado = 'completa';",
+		-1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, run_id_.c_str(), -1, SQLITE_STATIC);
+		if (sqlite3_step(stmt) == SQLITE_ROW) count = sqlite3_column_int(stmt, 0);
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+	return count;
+}
+
+bool RunJournal::completed(const string& stage, const string& input_hash) const {
+	lock_guard<mutex> lock(mtx_);
+	sqlite3* db = open_journal(db_path_);
+	if (!db) return false;
+	bool done = false;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "SELECT hash_entrada FROM journal_etapas "
+		"WHERE run_id = ? AND etapa = ? AND estado = 'completa';", -1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, run_id_.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, stage.c_str(), -1, SQLITE_STATIC);
+		if (sqlite3_step(stmt) == SQLITE_ROW) {
+			const unsigned char* hash = sqlite3_column_text(stmt, 0);
+			done = hash && input_hash == reinterpret_cast<const char*>(hash);
+		}
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+	return done;
+}
+
+// Ejecuta una sentencia de escritura (parámetros: run_id, etapa, valor1, valor2)
+// dentro de una transacción IMMEDIATE para no mezclar escrituras entre hilos/procesos
+bool RunJournal::exec_transaction(const string& sql_text, const string& stage,
+	const string& value1, const string& value2) const {
+	sqlite3* db = open_journal(db_path_);
+	if (!db) return false;
+	bool ok = sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK;
+	sqlite3_stmt* stmt;
+	if (ok && sqlite3_prepare_v2(db, sql_text.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, run_id_.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, stage.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 3, value1.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 4, value2.c_str(), -1, SQLITE_STATIC);
+		ok = sqlite3_step(stmt) == SQLITE_DONE;
+		sqlite3_finalize(stmt);
+	}
+	else {
+		ok = false;
+	}
+	if (!ok) cerr << "Error en journal_etapas (" << stage << "): " << sqlite3_errmsg(db) << endl;
+	sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+	sqlite3_close(db);
+	return ok;
+}
+
+void RunJournal::begin(const string& stage, const string& input_hash) {
+	TraceSpan span("journal", "sqlite");
+	lock_guard<mutex> lock(mtx_);
+	exec_transaction("INSERT INTO journal_etapas (run_id, etapa, hash_entrada, estado, intentos, inicio) "
+		"VALUES (?1, ?2, ?3, 'en_curso', 1, ?4) "
+		"ON CONFLICT(run_id, etapa) DO UPDATE SET hash_entrada = ?3, estado = 'en_curso', "
+		"intentos = intentos + 1, inicio = ?4, fin = NULL, detalle = NULL;",
+		stage, input_hash, now_text());
+}
+
+void RunJournal::finish(const string& stage, bool ok, const string& detail) {
+	TraceSpan span("journal", "sqlite");
+	lock_guard<mutex> lock(mtx_);
+	exec_transaction(string("UPDATE journal_etapas SET estado = '") + (ok ? "completa" : "fallida") +
+		"', fin = ?3, detalle = ?4 WHERE run_id = ?1 AND etapa = ?2;",
+		stage, now_text(), detail);
+}
+
+string lightgbm_input_hash(const fs::path& config) {
+	TraceSpan span("hash_entradas", "io");
+	Fnv1a h;
+	h.update_file(config);
+	for (const string& file : config_inputs(read_config_map(config.string()))) {
+		h.update(file);
+		if (!h.update_file(file)) h.update("<sin archivo>");
+	}
+	return h.hex();
+}
+
+vector<fs::path> lightgbm_inputs(const fs::path& config) {
+	vector<fs::path> files;
+	for (const string& file : config_inputs(read_config_map(config.string()))) files.push_back(file);
+	return files;
+}
+
+vector<fs::path> lightgbm_outputs(const fs::path& config) {
+	auto params = read_config_map(config.string());
+	vector<fs::path> files;
+	for (const string& out : { config_get(params, CONFIG_OUTPUT_MODEL_KEYS), config_get(params, CONFIG_RESULT_KEYS) }) {
+		if (!out.empty()) files.push_back(out);
+	}
+	return files;
+}
+
+bool lightgbm_outputs_exist(const fs::path& config) {
+	for (const fs::path& out : lightgbm_outputs(config)) {
+		if (!fs::exists(out)) return false;
+	}
+	return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Journal de la corrida (tabla journal_etapas de resultados.db).
+// Cada etapa (entrenar/predecir un fold, evaluar, holdout, modelo final,
+// inferencia) queda registrada con el hash de sus entradas y su estado
+// (en_curso / completa / fallida). Con --resume <run_id> las etapas completas
+// cuyo hash no cambió se saltean y se reutilizan sus artefactos.
+class RunJournal {
+public:
+	RunJournal(std::string db_path, std::string run_id);
+
+	// Cantidad de etapas completas registradas para la corrida
+	int completed_count() const;
+
+	// true si la etapa terminó bien con exactamente estas entradas
+	bool completed(const std::string& stage, const std::string& input_hash) const;
+
+	void begin(const std::string& stage, const std::string& input_hash);
+	void finish(const std::string& stage, bool ok, const std::string& detail = "");
+
+private:
+	bool exec_transaction(const std::string& sql_text, const std::string& stage,
+		const std::string& value1, const std::string& value2) const;
+
+	std::string db_path_;
+	std::string run_id_;
+	mutable std::mutex mtx_;
+};
+
+// Hash de un config de LightGBM más el contenido de los archivos que referencia
+// (data, valid, input_model)
+std::string lightgbm_input_hash(const std::filesystem::path& config);
+
+// Archivos que lee el config (data, valid, input_model) y los que escribe
+// (output_model / output_result)
+std::vector<std::filesystem::path> lightgbm_inputs(const std::filesystem::path& config);
+std::vector<std::filesystem::path> lightgbm_outputs(const std::filesystem::path& config);
+
+// true si existen todas las salidas declaradas en el config (output_model / output_result)
+bool lightgbm_outputs_exist(const std::filesystem::path& config);
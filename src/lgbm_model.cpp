@@ -0,0 +1,431 @@
+#include "lgbm_model.hpp"
+#include "io_utils.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <thread>
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define RED     "\033[31m"
+#define YELLOW  "\033[33m"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	// Mismas constantes que LightGBM (tree.h)
+	const int8_t CATEGORICAL_MASK = 1;
+	const int8_t DEFAULT_LEFT_MASK = 2;
+	const int MISSING_ZERO = 1;
+	const int MISSING_NAN = 2;
+	const double ZERO_THRESHOLD = 1e-35;
+
+	string trim(const string& s) {
+		size_t b = s.find_first_not_of(" \t\r\n");
+		if (b == string::npos) return string();
+		size_t e = s.find_last_not_of(" \t\r\n");
+		return s.substr(b, e - b + 1);
+	}
+
+	template <typename T>
+	vector<T> parse_array(const string& text) {
+		vector<T> out;
+		const char* p = text.c_str();
+		char* end = nullptr;
+		while (*p) {
+			double v = strtod(p, &end);
+			if (end == p) break;
+			out.push_back(static_cast<T>(v));
+			p = end;
+		}
+		return out;
+	}
+
+	vector<string> split_spaces(const string& text) {
+		vector<string> out;
+		stringstream ss(text);
+		string item;
+		while (ss >> item) out.push_back(item);
+		return out;
+	}
+
+	bool build_tree(const map<string, string>& kv, LgbmTree& tree) {
+		auto get = [&](const char* key) {
+			auto it = kv.find(key);
+			return it == kv.end() ? string() : it->second;
+		};
+		tree.num_leaves = atoi(get("num_leaves").c_str());
+		if (tree.num_leaves < 1) return false;
+		tree.leaf_value = parse_array<double>(get("leaf_value"));
+		tree.leaf_count = parse_array<double>(get("leaf_count"));
+		if (static_cast<int>(tree.leaf_value.size()) != tree.num_leaves) return false;
+		if (tree.num_leaves == 1) return true;
+
+		tree.split_feature = parse_array<int>(get("split_feature"));
+		tree.threshold = parse_array<double>(get("threshold"));
+		tree.decision_type = parse_array<int8_t>(get("decision_type"));
+		tree.left_child = parse_array<int>(get("left_child"));
+		tree.right_child = parse_array<int>(get("right_child"));
+		tree.internal_value = parse_array<double>(get("internal_value"));
+		tree.internal_count = parse_array<double>(get("internal_count"));
+		if (atoi(get("num_cat").c_str()) > 0) {
+			tree.cat_boundaries = parse_array<int>(get("cat_boundaries"));
+			tree.cat_threshold = parse_array<uint32_t>(get("cat_threshold"));
+		}
+		size_t internal = static_cast<size_t>(tree.num_leaves - 1);
+		return tree.split_feature.size() == internal && tree.threshold.size() == internal
+			&& tree.decision_type.size() == internal && tree.left_child.size() == internal
+			&& tree.right_child.size() == internal;
+	}
+
+	bool is_missing_token(const string& s) {
+		if (s.empty()) return true;
+		string lower = s;
+		transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+		return lower == "na" || lower == "nan" || lower == "null";
+	}
+
+	// Divide conservando campos vacíos (los faltantes del CSV)
+	void split_fields(const string& line, char sep, vector<string>& out) {
+		out.clear();
+		if (sep == ' ') {
+			stringstream ss(line);
+			string item;
+			while (ss >> item) out.push_back(item);
+			return;
+		}
+		size_t start = 0;
+		while (true) {
+			size_t pos = line.find(sep, start);
+			out.push_back(trim(line.substr(start, pos == string::npos ? string::npos : pos - start)));
+			if (pos == string::npos) break;
+			start = pos + 1;
+		}
+	}
+} // namespace
+
+int LgbmTree::next_node(int node, double fval) const {
+	int8_t type = decision_type[node];
+	int missing_type = (type >> 2) & 3;
+	if (type & CATEGORICAL_MASK) {
+		int int_fval;
+		if (std::isnan(fval)) {
+			if (missing_type == MISSING_NAN) return right_child[node];
+			int_fval = 0;
+		}
+		else {
+			int_fval = static_cast<int>(fval);
+			if (int_fval < 0) return right_child[node];
+		}
+		int cat_idx = static_cast<int>(threshold[node]);
+		int begin = cat_boundaries[cat_idx];
+		int words = cat_boundaries[cat_idx + 1] - begin;
+		int word = int_fval / 32;
+		if (word < words && ((cat_threshold[begin + word] >> (int_fval % 32)) & 1)) return left_child[node];
+		return right_child[node];
+	}
+	if (std::isnan(fval) && missing_type != MISSING_NAN) fval = 0.0;
+	if ((missing_type == MISSING_ZERO && fabs(fval) <= ZERO_THRESHOLD) || (missing_type == MISSING_NAN && std::isnan(fval))) {
+		return (type & DEFAULT_LEFT_MASK) ? left_child[node] : right_child[node];
+	}
+	return fval <= threshold[node] ? left_child[node] : right_child[node];
+}
+
+int LgbmTree::leaf_index(const double* row) const {
+	if (num_leaves == 1) return 0;
+	int node = 0;
+	while (node >= 0) node = next_node(node, row[split_feature[node]]);
+	return ~node;
+}
+
+bool LgbmModel::load(const fs::path& path) {
+	TraceSpan span("cargar_modelo_lgbm", "modelo");
+	ifstream file(path);
+	if (!file) {
+		cerr << RED << "[ERROR] No se pudo abrir el modelo " << path.string() << RESET << endl;
+		return false;
+	}
+	trees_.clear();
+	feature_names_.clear();
+
+	string line;
+	map<string, string> tree_kv;
+	bool in_tree = false;
+	auto flush_tree = [&]() {
+		if (!in_tree) return true;
+		LgbmTree tree;
+		if (!build_tree(tree_kv, tree)) return false;
+		trees_.push_back(move(tree));
+		tree_kv.clear();
+		in_tree = false;
+		return true;
+	};
+
+	while (getline(file, line)) {
+		line = trim(line);
+		if (line.empty()) continue;
+		if (line.rfind("Tree=", 0) == 0) {
+			if (!flush_tree()) break;
+			in_tree = true;
+			continue;
+		}
+		if (line == "end of trees") {
+			if (!flush_tree()) break;
+			break;
+		}
+		size_t eq = line.find('=');
+		if (in_tree) {
+			if (eq != string::npos) tree_kv[line.substr(0, eq)] = line.substr(eq + 1);
+			continue;
+		}
+		if (eq == string::npos) {
+			if (line == "average_output") average_output_ = true;
+			continue;
+		}
+		string key = line.substr(0, eq);
+		string value = line.substr(eq + 1);
+		if (key == "num_class") num_class_ = atoi(value.c_str());
+		else if (key == "num_tree_per_iteration") num_tree_per_iteration_ = atoi(value.c_str());
+		else if (key == "max_feature_idx") max_feature_idx_ = atoi(value.c_str());
+		else if (key == "objective") objective_ = value;
+		else if (key == "feature_names") feature_names_ = split_spaces(value);
+		else if (key == "is_linear" && value != "0") {
+			cerr << RED << "[ERROR] Árboles lineales no soportados por el predictor en proceso" << RESET << endl;
+			return false;
+		}
+	}
+	if (in_tree || trees_.empty() || num_tree_per_iteration_ < 1 || max_feature_idx_ < 0) {
+		cerr << RED << "[ERROR] Modelo LightGBM inválido o truncado: " << path.string() << RESET << endl;
+		trees_.clear();
+		return false;
+	}
+	for (const LgbmTree& tree : trees_) {
+		for (int f : tree.split_feature) {
+			if (f < 0 || f > max_feature_idx_) {
+				cerr << RED << "[ERROR] Feature fuera de rango en " << path.string() << RESET << endl;
+				trees_.clear();
+				return false;
+			}
+		}
+	}
+	size_t sig = objective_.find("sigmoid:");
+	if (sig != string::npos) sigmoid_ = atof(objective_.c_str() + sig + 8);
+	if (feature_names_.size() != static_cast<size_t>(num_features())) {
+		feature_names_.clear();
+		for (int f = 0; f < num_features(); ++f) feature_names_.push_back("Column_" + to_string(f));
+	}
+	return true;
+}
+
+void LgbmModel::predict_raw(const double* row, double* out) const {
+	fill(out, out + num_tree_per_iteration_, 0.0);
+	for (size_t t = 0; t < trees_.size(); ++t) out[t % num_tree_per_iteration_] += trees_[t].predict(row);
+	if (average_output_) {
+		double iterations = static_cast<double>(trees_.size() / num_tree_per_iteration_);
+		for (int k = 0; k < num_tree_per_iteration_; ++k) out[k] /= iterations;
+	}
+}
+
+void LgbmModel::raw_to_output(double* values) const {
+	int k = num_tree_per_iteration_;
+	string name = objective_.substr(0, objective_.find(' '));
+	if (name == "multiclass" || name == "softmax") {
+		double vmax = *max_element(values, values + k);
+		double sum = 0.0;
+		for (int c = 0; c < k; ++c) {
+			values[c] = exp(values[c] - vmax);
+			sum += values[c];
+		}
+		for (int c = 0; c < k; ++c) values[c] /= sum;
+	}
+	else if (name == "binary" || name == "multiclassova" || name == "multiclass_ova" || name == "ova" || name == "ovr") {
+		for (int c = 0; c < k; ++c) values[c] = 1.0 / (1.0 + exp(-sigmoid_ * values[c]));
+	}
+	else if (name == "cross_entropy" || name == "xentropy") {
+		for (int c = 0; c < k; ++c) values[c] = 1.0 / (1.0 + exp(-values[c]));
+	}
+	else if (name == "poisson" || name == "gamma" || name == "tweedie") {
+		for (int c = 0; c < k; ++c) values[c] = exp(values[c]);
+	}
+}
+
+void LgbmModel::predict_proba(const double* row, double* out) const {
+	predict_raw(row, out);
+	raw_to_output(out);
+}
+
+int LgbmTree::depth() const {
+	if (num_leaves <= 1) return 0;
+	int deepest = 0;
+	vector<pair<int, int>> stack = { { 0, 1 } };
+	while (!stack.empty()) {
+		auto [node, level] = stack.back();
+		stack.pop_back();
+		deepest = max(deepest, level);
+		for (int child : { left_child[node], right_child[node] }) {
+			if (child >= 0) stack.push_back({ child, level + 1 });
+		}
+	}
+	return deepest;
+}
+
+LgbmModel LgbmModel::truncated(int iterations, int max_depth) const {
+	LgbmModel out = *this;
+	size_t keep = trees_.size();
+	if (iterations > 0) keep = min(keep, static_cast<size_t>(iterations) * num_tree_per_iteration_);
+	out.trees_.resize(keep);
+	if (max_depth <= 0) return out;
+	for (LgbmTree& tree : out.trees_) {
+		if (tree.depth() <= max_depth) continue;
+		const LgbmTree src = tree;
+		tree = LgbmTree();
+		tree.cat_boundaries = src.cat_boundaries;
+		tree.cat_threshold = src.cat_threshold;
+		tree.num_leaves = 0;
+		// Copia en preorden; devuelve el índice del nodo (o ~hoja) en el árbol nuevo
+		auto copy = [&](auto& self, int node, int level) -> int {
+			if (node < 0 || level >= max_depth) {
+				double value = node < 0 ? src.leaf_value[~node]
+					: (node < static_cast<int>(src.internal_value.size()) ? src.internal_value[node] : 0.0);
+				double count = node < 0 ? (~node < static_cast<int>(src.leaf_count.size()) ? src.leaf_count[~node] : 0.0)
+					: (node < static_cast<int>(src.internal_count.size()) ? src.internal_count[node] : 0.0);
+				tree.leaf_value.push_back(value);
+				tree.leaf_count.push_back(count);
+				return ~(tree.num_leaves++);
+			}
+			int id = static_cast<int>(tree.split_feature.size());
+			tree.split_feature.push_back(src.split_feature[node]);
+			tree.threshold.push_back(src.threshold[node]);
+			tree.decision_type.push_back(src.decision_type[node]);
+			tree.internal_value.push_back(node < static_cast<int>(src.internal_value.size()) ? src.internal_value[node] : 0.0);
+			tree.internal_count.push_back(node < static_cast<int>(src.internal_count.size()) ? src.internal_count[node] : 0.0);
+			tree.left_child.push_back(0);
+			tree.right_child.push_back(0);
+			int left = self(self, src.left_child[node], level + 1);
+			int right = self(self, src.right_child[node], level + 1);
+			tree.left_child[id] = left;
+			tree.right_child[id] = right;
+			return id;
+		};
+		copy(copy, 0, 0);
+	}
+	return out;
+}
+
+vector<vector<int>> LgbmModel::trees_by_feature() const {
+	vector<vector<int>> by_feature(num_features());
+	for (size_t t = 0; t < trees_.size(); ++t) {
+		for (int f : trees_[t].split_feature) {
+			if (by_feature[f].empty() || by_feature[f].back() != static_cast<int>(t)) by_feature[f].push_back(static_cast<int>(t));
+		}
+	}
+	return by_feature;
+}
+
+bool load_lightgbm_text_data(const fs::path& path, DenseDataset& data, int label_column, bool has_header) {
+	TraceSpan span("cargar_dataset_texto", "modelo");
+	ifstream file(path);
+	if (!file) {
+		cerr << RED << "[ERROR] No se pudo abrir el dataset " << path.string() << RESET << endl;
+		return false;
+	}
+	data = DenseDataset();
+	string line;
+	vector<string> fields;
+	char sep = 0;
+	size_t columns = 0;
+	size_t line_no = 0;
+	const double nan = numeric_limits<double>::quiet_NaN();
+	while (getline(file, line)) {
+		line_no++;
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (trim(line).empty()) continue;
+		if (sep == 0) {
+			sep = line.find(',') != string::npos ? ',' : (line.find('\t') != string::npos ? '\t' : ' ');
+			if (has_header) continue;
+		}
+		split_fields(line, sep, fields);
+		if (columns == 0) {
+			columns = fields.size();
+			if (label_column >= static_cast<int>(columns)) {
+				cerr << RED << "[ERROR] label_column=" << label_column << " fuera de rango en " << path.string() << RESET << endl;
+				return false;
+			}
+			data.num_features = static_cast<int>(columns) - (label_column >= 0 ? 1 : 0);
+		}
+		if (fields.size() != columns) {
+			cerr << RED << "[ERROR] " << path.string() << ":" << line_no << " tiene " << fields.size()
+				<< " columnas (se esperaban " << columns << ")" << RESET << endl;
+			return false;
+		}
+		for (size_t c = 0; c < columns; ++c) {
+			double v = is_missing_token(fields[c]) ? nan : strtod(fields[c].c_str(), nullptr);
+			if (static_cast<int>(c) == label_column) data.labels.push_back(v);
+			else data.values.push_back(v);
+		}
+	}
+	return data.num_features > 0;
+}
+
+bool load_config_dataset(const fs::path& config, DenseDataset& data, int model_features) {
+	auto params = read_config_map(config.string());
+	string path = config_get(params, CONFIG_DATA_KEYS);
+	if (path.empty()) {
+		cerr << RED << "[ERROR] " << config.string() << " no declara data=" << RESET << endl;
+		return false;
+	}
+	string header = config_get(params, { "header", "has_header" }, "false");
+	bool has_header = header == "true" || header == "1";
+	// label_column por índice; con "name:" se asume la primera columna como hace el resto del pipeline
+	string label = config_get(params, { "label_column", "label" }, "0");
+	int label_column = 0;
+	if (!label.empty() && isdigit(static_cast<unsigned char>(label[0]))) label_column = atoi(label.c_str());
+	else if (label != "0") {
+		cerr << YELLOW << "[WARN] label_column=" << label << " no soportado; se usa la columna 0" << RESET << endl;
+	}
+	if (model_features >= 0) {
+		ifstream file(path);
+		string line;
+		while (getline(file, line) && trim(line).empty()) {}
+		if (has_header) getline(file, line);
+		char sep = line.find(',') != string::npos ? ',' : (line.find('\t') != string::npos ? '\t' : ' ');
+		vector<string> fields;
+		split_fields(line, sep, fields);
+		if (static_cast<int>(fields.size()) == model_features) label_column = -1;
+	}
+	return load_lightgbm_text_data(path, data, label_column, has_header);
+}
+
+vector<double> predict_proba_batch(const LgbmModel& model, const DenseDataset& data, int num_threads) {
+	TraceSpan span("predecir_en_proceso", "modelo");
+	size_t n = data.rows();
+	int k = model.num_tree_per_iteration();
+	vector<double> probs(n * k, 0.0);
+	if (data.num_features < model.num_features()) {
+		cerr << RED << "[ERROR] El dataset tiene " << data.num_features << " features y el modelo espera "
+			<< model.num_features() << RESET << endl;
+		return vector<double>();
+	}
+	if (num_threads <= 0) num_threads = static_cast<int>(thread::hardware_concurrency());
+	// Bloques de al menos 256 filas por hilo
+	int threads = static_cast<int>(min<size_t>(max(1, num_threads), max<size_t>(1, n / 256)));
+	auto work = [&](int t) {
+		size_t begin = n * t / threads;
+		size_t end = n * (t + 1) / threads;
+		for (size_t i = begin; i < end; ++i) model.predict_proba(data.row(i), probs.data() + i * k);
+	};
+	vector<thread> pool;
+	for (int t = 1; t < threads; ++t) pool.emplace_back(work, t);
+	work(0);
+	for (auto& th : pool) th.join();
+	return probs;
+}
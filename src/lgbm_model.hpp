@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Lector del modelo de texto de LightGBM (output_model) y predictor en proceso,
+// con la misma lógica de decisión que LightGBM (umbral numérico, valores
+// faltantes según missing_type/default_left y splits categóricos por bitset).
+// Evita escribir archivos y relanzar lightgbm.exe cuando hay que predecir
+// muchas veces sobre los mismos datos (importancia por permutación, SHAP).
+
+struct LgbmTree {
+	int num_leaves = 1;
+	std::vector<int> split_feature;
+	std::vector<double> threshold;
+	std::vector<int8_t> decision_type;
+	std::vector<int> left_child;       // < 0: hoja ~hijo
+	std::vector<int> right_child;
+	std::vector<double> leaf_value;    // ya incluye el shrinkage
+	std::vector<double> leaf_count;
+	std::vector<double> internal_value;
+	std::vector<double> internal_count;
+	std::vector<int> cat_boundaries;
+	std::vector<uint32_t> cat_threshold;
+
+	// Hoja a la que cae la fila (valores de features por índice; NaN = faltante)
+	int leaf_index(const double* row) const;
+	double predict(const double* row) const { return leaf_value[leaf_index(row)]; }
+	// Nodo hijo que sigue la fila en el nodo interno node
+	int next_node(int node, double value) const;
+	// Niveles de splits del camino más largo (0 = una sola hoja)
+	int depth() const;
+};
+
+class LgbmModel {
+public:
+	bool load(const std::filesystem::path& path);
+
+	int num_class() const { return num_class_; }
+	int num_tree_per_iteration() const { return num_tree_per_iteration_; }
+	int num_features() const { return max_feature_idx_ + 1; }
+	bool average_output() const { return average_output_; }
+	const std::vector<std::string>& feature_names() const { return feature_names_; }
+	const std::vector<LgbmTree>& trees() const { return trees_; }
+	const std::string& objective() const { return objective_; }
+	// Clase (salida) a la que suma el árbol t
+	int tree_class(size_t t) const { return static_cast<int>(t % num_tree_per_iteration_); }
+
+	// Puntaje crudo por clase (out: num_tree_per_iteration valores)
+	void predict_raw(const double* row, double* out) const;
+	// Transformación de la salida según el objetivo (softmax, sigmoide o identidad)
+	void raw_to_output(double* values) const;
+	void predict_proba(const double* row, double* out) const;
+
+	// Árboles que usan cada feature en algún split (para reevaluar sólo esos)
+	std::vector<std::vector<int>> trees_by_feature() const;
+
+	// Copia con las primeras iterations iteraciones (0 = todas) y los árboles podados
+	// a max_depth niveles (0 = sin podar; los nodos cortados pasan a hoja con su
+	// internal_value). Para benchmarks del predictor.
+	LgbmModel truncated(int iterations, int max_depth) const;
+
+private:
+	int num_class_ = 1;
+	int num_tree_per_iteration_ = 1;
+	int max_feature_idx_ = -1;
+	bool average_output_ = false;
+	double sigmoid_ = 1.0;
+	std::string objective_;
+	std::vector<std::string> feature_names_;
+	std::vector<LgbmTree> trees_;
+};
+
+// Dataset de texto de LightGBM (CSV/TSV/espacios) en memoria, filas x features
+// row-major; las celdas vacías o "nan"/"na" quedan como NaN.
+struct DenseDataset {
+	int num_features = 0;
+	std::vector<double> values;
+	std::vector<double> labels;
+	size_t rows() const { return num_features > 0 ? values.size() / num_features : 0; }
+	const double* row(size_t i) const { return values.data() + i * num_features; }
+};
+
+// label_column: columna de la etiqueta (-1 = sin etiqueta, ej. datos de inferencia)
+bool load_lightgbm_text_data(const std::filesystem::path& path, DenseDataset& data, int label_column = 0,
+	bool has_header = false);
+
+// Dataset referenciado por un config de LightGBM (data=, label_column=, header=).
+// Si model_features >= 0 y el archivo tiene exactamente esa cantidad de columnas
+// se asume que no trae etiqueta (datos de inferencia), como hace LightGBM al predecir.
+bool load_config_dataset(const std::filesystem::path& config, DenseDataset& data, int model_features = -1);
+
+// Predicción de probabilidades en paralelo (filas x clases, row-major)
+std::vector<double> predict_proba_batch(const LgbmModel& model, const DenseDataset& data, int num_threads = 0);
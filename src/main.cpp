@@ -15,6 +15,7 @@
 #include <sstream>
 #include <vector>
 #include <cstdlib>
+#include <cstdio>
 #include <cmath>
 #include <map>
 #include <algorithm>
@@ -22,11 +23,36 @@
 #include <sqlite3.h>
 #include <ctime>
 #include <filesystem>
+#include <thread>
+#include <functional>
+#include <memory>
+#include <chrono>
 #include "io_utils.hpp"
 #include "metrics.hpp"
 #include "database.hpp"
 #include "optuna_report.hpp"
-#include <windows.h>
+#include "trace.hpp"
+#include "process.hpp"
+#include "run_config.hpp"
+#include "scheduler.hpp"
+#include "oof_store.hpp"
+#include "stacking.hpp"
+#include "hashing.hpp"
+#include "journal.hpp"
+#include "experiment_db.hpp"
+#include "farm.hpp"
+#include "model_registry.hpp"
+#include "lgbm_model.hpp"
+#include "permutation_importance.hpp"
+#include "tree_shap.hpp"
+#include "stage_cache.hpp"
+#include "dataset_cache.hpp"
+#include "prediction_stream.hpp"
+#include "incremental.hpp"
+#include "multi_seed.hpp"
+#include "drift_monitor.hpp"
+#include "quickscorer.hpp"
+#include "training_curves.hpp"
 
 // Códigos ANSI para color
 #define RESET   "\033[0m"
@@ -41,129 +67,1006 @@
 using namespace std;
 namespace fs = std::filesystem;
 
-const int NUM_CLASSES = 5;
-const int NUM_FOLDS = 5;
+// Ejecuta un proceso hijo (LightGBM o Python) registrando su duración en la traza
+// y los recursos consumidos (CPU, memoria, I/O) en la tabla recursos_procesos.
+// on_line recibe cada línea de salida del hijo mientras corre; repeat y seed (-1: sin
+// semilla) identifican el trabajo junto con fold.
+static int run_child(const string& run_id, const string& cmd, const string& phase, int fold = -1,
+	uint64_t data_bytes = 0, const LineCallback& on_line = nullptr, int repeat = 0, int seed = -1) {
+	ProcessStats stats;
+	{
+		TraceSpan span(phase, "proceso", fold);
+		stats = run_process(cmd, on_line);
+	}
+	insert_process_stats_sqlite(run_id, fold, phase, cmd, stats, data_bytes, repeat, seed);
+	printf("[RECURSOS] %s%s: wall=%.1f s | cpu=%.1f s | pico=%.0f MB | io=%.1f/%.1f MB\n",
+		phase.c_str(), fold >= 0 ? (" fold " + to_string(fold)).c_str() : "",
+		stats.wall_ms / 1000.0, (stats.user_ms + stats.sys_ms) / 1000.0,
+		stats.peak_rss_bytes / (1024.0 * 1024.0),
+		stats.io_read_bytes / (1024.0 * 1024.0), stats.io_write_bytes / (1024.0 * 1024.0));
+	return stats.exit_code;
+}
 
-int main() {
-	char result_path[MAX_PATH];
-	GetModuleFileNameA(NULL, result_path, MAX_PATH);
-	fs::path exe_path = fs::path(result_path).parent_path();
+// Contexto compartido por los trabajos LightGBM de la corrida
+struct RunContext {
+	string run_id;
+	fs::path lightgbm_path;
+	MemoryScheduler& scheduler;
+	RunJournal& journal;
+	const RunConfig& config;
+	StageCache& cache;
+	DatasetCache& datasets;
+	string lightgbm_hash;   // el binario de LightGBM también forma parte de la huella
+};
 
-	fs::path fold_dir = exe_path / "folds";
-	fs::path lightgbm_path = exe_path / "lightgbm.exe";
+// Hash de los archivos de entrada de una etapa que no es un proceso LightGBM
+static string files_hash(initializer_list<fs::path> files) {
+	Fnv1a h;
+	for (const auto& file : files) {
+		h.update(file.string());
+		if (!h.update_file(file)) h.update("<sin archivo>");
+	}
+	return h.hex();
+}
 
-	double total_acc = 0.0, total_f1 = 0.0;
-	double total_kappa = 0.0;
+// Igual que files_hash, pero con probabilidades en memoria (predicciones por FIFO, sin archivo)
+static string probs_hash(const vector<double>& probs, initializer_list<fs::path> files) {
+	Fnv1a h;
+	h.update(probs.data(), probs.size() * sizeof(double));
+	h.update(files_hash(files));
+	return h.hex();
+}
 
-	// Archivo global para guardar todas las predicciones
-	ofstream global_csv(exe_path / "predicciones_completas.csv");
-	global_csv << "fold,indice,y_true,y_pred\n";
+// Predicciones leídas de la FIFO durante la predicción (stream_predictions=1)
+struct StreamedPredictions {
+	// Entrada: etiquetas reales para armar la matriz de confusión mientras llegan las filas
+	fs::path labels;
+	int num_classes = 0;
+
+	bool valid = false;
+	int cols = 0;
+	vector<double> probs;
+	vector<int> y_pred;                 // argmax de cada fila, calculado a medida que llegan
+	vector<vector<int>> confusion;      // fila = real, columna = predicha
 
-	for (int fold = 0; fold < NUM_FOLDS; ++fold) {
-		cout << "\n=== Fold " << fold << " ===" << endl;
+	ConfusionMetrics metrics() const { return metrics_from_confusion(confusion); }
+};
 
-		string train_file = (fold_dir / ("train_fold_" + to_string(fold) + ".txt")).string();
-		string valid_file = (fold_dir / ("valid_fold_" + to_string(fold) + ".txt")).string();
-		string valid_labels = (fold_dir / ("y_valid_fold_" + to_string(fold) + ".txt")).string();
-		string model_file = (fold_dir / ("model_fold_" + to_string(fold) + ".txt")).string();
-		string pred_file = (fold_dir / ("predictions_fold_" + to_string(fold) + ".txt")).string();
-		string config_train = (fold_dir / ("config_train_fold_" + to_string(fold) + ".txt")).string();
-		string config_pred = (fold_dir / ("config_pred_fold_" + to_string(fold) + ".txt")).string();
+// Etapa resuelta sin ejecutarla: completa en el journal de esta corrida (--resume)
+// o con salidas en la cache de etapas para la misma huella de entradas
+static bool stage_reused(RunContext& ctx, const StageSpec& spec, const string& fingerprint) {
+	if (ctx.journal.completed(spec.name, fingerprint) && stage_outputs_exist(spec)) {
+		cout << GREEN << "[RESUME] Etapa " << spec.name << " ya completa; se reutilizan sus salidas" << RESET << endl;
+		return true;
+	}
+	if (ctx.cache.restore(spec, fingerprint)) {
+		ctx.journal.begin(spec.name, fingerprint);
+		ctx.journal.finish(spec.name, true, "cache");
+		cout << GREEN << "[CACHE] Etapa " << spec.name << " sin cambios en sus entradas; se restauran sus salidas" << RESET << endl;
+		return true;
+	}
+	return false;
+}
 
-		if (system((lightgbm_path.string() + " config=" + config_train).c_str()) != 0) {
-			cerr << RED << BOLD << "Error en entrenamiento del fold " << fold << RESET << endl;
-			continue;
+// Ejecuta una etapa declarada (entradas/salidas): journal y cache primero; si no se
+// pueden reutilizar y la etapa está seleccionada (stages=) se corre y sus salidas
+// quedan en la cache. Una etapa no seleccionada sólo usa las salidas que ya existen.
+static int run_stage(RunContext& ctx, const StageSpec& spec, const function<int()>& run) {
+	string fingerprint = stage_fingerprint(spec);
+	if (spec.reusable && stage_reused(ctx, spec, fingerprint)) return 0;
+	if (!stage_selected(ctx.config, spec.kind)) {
+		if (stage_outputs_exist(spec)) {
+			cout << YELLOW << "[SKIP] Etapa " << spec.name << " (" << spec.kind << ") no seleccionada; se usan las salidas existentes" << RESET << endl;
+			return 0;
 		}
+		cerr << RED << "[ERROR] Etapa " << spec.name << " (" << spec.kind << ") no seleccionada y sin salidas previas" << RESET << endl;
+		return -1;
+	}
+	ctx.journal.begin(spec.name, fingerprint);
+	int rc = run();
+	ctx.journal.finish(spec.name, rc == 0, rc == 0 ? "" : "exit_code=" + to_string(rc));
+	if (rc == 0 && spec.reusable) ctx.cache.store(spec, fingerprint);
+	return rc;
+}
 
-		if (system((lightgbm_path.string() + " config=" + config_pred).c_str()) != 0) {
-			cerr << RED << BOLD << "Error en prediccion del fold " << fold << RESET << endl;
-			continue;
+// Ejecuta LightGBM con un config como etapa kind (train, predict, final, infer),
+// esperando antes la admisión por memoria. Con streamed y stream_predictions=1 la
+// predicción se lee de una FIFO mientras LightGBM la escribe. En los entrenamientos
+// las métricas por iteración se parsean de la salida y quedan en curvas_entrenamiento.
+// repeat/seed sólo etiquetan los recursos del proceso.
+static int run_lightgbm(RunContext& ctx, const fs::path& config, const string& phase, const string& stage,
+	const string& kind, int fold = -1, StreamedPredictions* streamed = nullptr, int repeat = 0, int seed = -1) {
+	StageSpec spec = lightgbm_stage(stage, kind, config, ctx.lightgbm_hash);
+	bool stream_only = streamed && ctx.config.stream_predictions && !ctx.config.stream_keep_file;
+	spec.reusable = !stream_only;
+	return run_stage(ctx, spec, [&] {
+		JobEstimate est = ctx.scheduler.estimate(phase, config);
+		string job_name = phase + (fold >= 0 ? "_fold_" + to_string(fold) : "");
+		MemoryScheduler::Ticket ticket;
+		{
+			TraceSpan span("espera_admision", "scheduler", fold);
+			ticket = ctx.scheduler.admit(job_name, est);
 		}
+		// Las salidas pueden ser hard links a objetos del registro de modelos: se borran
+		// para que LightGBM cree archivos nuevos en lugar de reescribir el objeto
+		std::error_code ec;
+		for (const fs::path& out : lightgbm_outputs(config)) fs::remove(out, ec);
+		// Entrenamiento: data/valid se cargan del binario en cache si su clave no cambió
+		DatasetCachePlan plan = ctx.datasets.prepare(config, ctx.lightgbm_hash);
+		vector<int> stream_labels;   // antes que stream: el lector la usa hasta que termina
+		unique_ptr<PredictionStream> stream;
+		if (streamed && ctx.config.stream_predictions) {
+			streamed->valid = false;
+			streamed->cols = 0;
+			streamed->probs.clear();
+			streamed->y_pred.clear();
+			streamed->confusion.assign(streamed->num_classes, vector<int>(streamed->num_classes, 0));
+			if (!streamed->labels.empty()) stream_labels = read_labels(streamed->labels.string());
+			// Con stream_keep_file=1 la FIFO se copia a output_result mientras se lee (salida
+			// reutilizable por la cache y --resume); si no, ningún archivo de predicción toca el disco
+			fs::path keep;
+			if (ctx.config.stream_keep_file) {
+				keep = config_get(read_config_map(config.string()), CONFIG_RESULT_KEYS, "LightGBM_predict_result.txt");
+			}
+			stream = make_unique<PredictionStream>(stage);
+			bool started = stream->start(config, keep, [streamed, &stream_labels](const double* values, int cols) {
+				int pred = static_cast<int>(max_element(values, values + cols) - values);
+				size_t row = streamed->y_pred.size();
+				streamed->y_pred.push_back(pred);
+				if (row < stream_labels.size()) {
+					unsigned t = static_cast<unsigned>(stream_labels[row]);
+					unsigned k = static_cast<unsigned>(streamed->num_classes);
+					if (t < k && static_cast<unsigned>(pred) < k) streamed->confusion[t][pred]++;
+				}
+			});
+			if (!started) {
+				cerr << YELLOW << "[WARN] " << stage << ": sin FIFO, la prediccion se escribe a archivo" << RESET << endl;
+				stream.reset();
+			}
+		}
+		unique_ptr<TrainingMonitor> monitor;
+		if (ctx.config.train_curves && (kind == "train" || kind == "final")) {
+			monitor = make_unique<TrainingMonitor>(stage, fold, configured_iterations(config), ctx.config.train_progress_seconds);
+		}
+		fs::path run_config = stream ? stream->config() : plan.config;
+		string cmd = ctx.lightgbm_path.string() + " config=" + run_config.string();
+		cout << "[RUN] " << cmd << endl;
+		double load_seconds = -1.0;
+		int rc = run_child(ctx.run_id, cmd, phase, fold, est.data_bytes, [&](const string& line) {
+			double seconds = parse_lightgbm_load_seconds(line);
+			if (seconds >= 0.0) load_seconds = seconds;
+			if (monitor) monitor->on_line(line);
+		}, repeat, seed);
+		if (monitor) {
+			monitor->finish();
+			if (rc == 0 && !monitor->curves().empty()) insert_training_curves_sqlite(ctx.run_id, phase, *monitor);
+		}
+		if (stream) {
+			streamed->valid = stream->finish() && rc == 0;
+			printf("[STREAM] %s: %zu filas leidas de la FIFO; el lector termino %.1f ms despues de LightGBM\n",
+				stage.c_str(), stream->rows(), stream->drain_ms());
+			streamed->cols = stream->cols();
+			streamed->probs = std::move(stream->values());
+		}
+		DatasetLoadReport load = ctx.datasets.finish(plan, rc == 0, load_seconds, ctx.run_id, stage, fold);
+		if (!plan.datasets.empty() && rc == 0 && load.load_seconds >= 0.0) {
+			if (load.from_binary) {
+				printf("[DATASET] %s: carga %.2f s desde binario (texto %.2f s) -> ahorro %.2f s\n",
+					stage.c_str(), load.load_seconds, load.text_seconds, load.saved_seconds());
+			}
+			else {
+				printf("[DATASET] %s: carga %.2f s desde texto; binario guardado en cache_datasets/\n",
+					stage.c_str(), load.load_seconds);
+			}
+		}
+		return rc;
+	});
+}
 
-		// Leer resultados
-		vector<int> y_true = read_labels(valid_labels);
-		vector<int> y_pred = read_predicted_classes(pred_file);
+// Reentrenamiento incremental (incremental=1): continúa el boosting del modelo en
+// producción con incremental_iterations árboles extra, compara el candidato con
+// el modelo base en holdout y sólo lo promueve a final/production si el QWK no
+// baja más que incremental_tolerance. Registra el tiempo contra el de un
+// reentrenamiento completo estimado con el historial de recursos_procesos.
+static int run_incremental_retrain(RunContext& ctx, const fs::path& fold_dir, const fs::path& cfg_pred_hold,
+	const fs::path& y_hold) {
+	const RunConfig& cfg = ctx.config;
+	cout << BLUE << BOLD << "\n=== Reentrenamiento incremental del modelo final ===" << RESET << endl;
+	fs::path full_config = fold_dir / "config_train_all.txt";
+	fs::path final_model = fold_dir / "model_all.txt";
+	fs::path inc_config = fold_dir / "config_train_incremental.txt";
+	fs::path candidate = fold_dir / "model_all_incremental.txt";
 
-		if (y_true.size() != y_pred.size()) {
-			cerr << RED << BOLD << "Tamaño inconsistente en fold " << fold << RESET << endl;
-			continue;
+	// Base: el modelo en producción; si nunca se promovió, el último modelo final entrenado
+	string base_hash = registry_alias_hash("production");
+	fs::path base_model = base_hash.empty() ? final_model : registry_object_path(base_hash);
+	if (!fs::exists(base_model)) {
+		cerr << RED << BOLD << "❌ No hay modelo base para continuar (" << base_model.string()
+			<< "); entrenar primero el modelo final completo." << RESET << endl;
+		return 1;
+	}
+	if (base_hash.empty()) base_hash = sha256_file_hex(base_model);
+	if (!fs::exists(cfg_pred_hold) || !fs::exists(y_hold)) {
+		cerr << RED << BOLD << "❌ El reentrenamiento incremental necesita el holdout para validar el candidato ("
+			<< cfg_pred_hold.string() << ", " << y_hold.string() << ")." << RESET << endl;
+		return 1;
+	}
+	string data = cfg.incremental_data;
+	if (!write_warm_start_config(full_config, inc_config, base_model, candidate, data, cfg.incremental_iterations)) return 1;
+	if (data.empty()) data = config_get(read_config_map(full_config.string()), CONFIG_DATA_KEYS);
+	cout << CYAN << "[INFO] Base " << base_model.string() << " + " << cfg.incremental_iterations << " iteraciones sobre "
+		<< data << RESET << endl;
+
+	auto t0 = chrono::steady_clock::now();
+	if (run_lightgbm(ctx, inc_config, "lightgbm_train_incremental", "entrenar_incremental", "final") != 0) {
+		cerr << RED << BOLD << "❌ Error en el reentrenamiento incremental." << RESET << endl;
+		return 1;
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+	// Costo de un reentrenamiento completo: último entrenamiento final exitoso,
+	// escalado por el tamaño actual de train_all
+	uint64_t history_bytes = 0;
+	double full_wall_ms = last_successful_wall_ms("lightgbm_train_final", history_bytes);
+	double full_seconds = -1.0;
+	if (full_wall_ms >= 0.0) {
+		uint64_t full_bytes = ctx.scheduler.estimate("lightgbm_train_final", full_config).data_bytes;
+		double scale = history_bytes > 0 && full_bytes > 0 ? static_cast<double>(full_bytes) / history_bytes : 1.0;
+		full_seconds = full_wall_ms / 1000.0 * scale;
+	}
+
+	// Validación en holdout con el predictor en proceso: mismos datos para ambos modelos
+	PredictEngine engine = PredictEngine::Auto;
+	parse_predict_engine(cfg.predict_engine, engine);
+	HoldoutScore base = score_model_on_holdout(base_model, cfg_pred_hold, y_hold, cfg.num_classes, cfg.num_threads, engine);
+	HoldoutScore next = score_model_on_holdout(candidate, cfg_pred_hold, y_hold, cfg.num_classes, cfg.num_threads, engine);
+	if (!base.ok || !next.ok) {
+		cerr << RED << BOLD << "❌ No se pudo evaluar en holdout el modelo base o el candidato." << RESET << endl;
+		return 1;
+	}
+	printf("[INCREMENTAL] holdout (%zu filas)  base: acc=%.4f f1=%.4f qwk=%.4f | candidato: acc=%.4f f1=%.4f qwk=%.4f\n",
+		next.rows, base.accuracy, base.f1_macro, base.kappa, next.accuracy, next.f1_macro, next.kappa);
+
+	IncrementalRecord record;
+	record.run_id = ctx.run_id;
+	record.base_hash = base_hash;
+	record.data_path = data;
+	record.iterations = cfg.incremental_iterations;
+	record.seconds = seconds;
+	record.full_seconds = full_seconds;
+	record.base_acc = base.accuracy;
+	record.base_f1 = base.f1_macro;
+	record.base_kappa = base.kappa;
+	record.new_acc = next.accuracy;
+	record.new_f1 = next.f1_macro;
+	record.new_kappa = next.kappa;
+	record.promoted = next.kappa >= base.kappa - cfg.incremental_tolerance;
+
+	ModelLineage lineage;
+	lineage.run_id = ctx.run_id;
+	lineage.config_path = inc_config.string();
+	lineage.accuracy = next.accuracy;
+	lineage.f1_macro = next.f1_macro;
+	lineage.kappa = next.kappa;
+	// El candidato sólo entra al registro (y reemplaza model_all.txt) si se acepta;
+	// si no, model_all.txt y los aliases quedan como estaban
+	if (record.promoted) {
+		record.new_hash = registry_store_model(candidate.string(), lineage);
+		record.promoted = !record.new_hash.empty();
+	}
+	if (record.promoted) {
+		// model_all.txt pasa a ser el candidato (config_pred_infer.txt lo usa) y los
+		// aliases final y production apuntan a él
+		std::error_code ec;
+		fs::path tmp = final_model;
+		tmp += ".tmp";
+		fs::copy_file(candidate, tmp, fs::copy_options::overwrite_existing, ec);
+		if (!ec) fs::rename(tmp, final_model, ec);
+		if (ec) cerr << YELLOW << "[WARN] No se pudo reemplazar " << final_model.string() << ": " << ec.message() << RESET << endl;
+		registry_promote("final", record.new_hash, lineage);
+		registry_promote("production", record.new_hash, lineage);
+		cout << GREEN << BOLD << "✅ Candidato promovido a final y production: QWK " << base.kappa << " -> " << next.kappa
+			<< RESET << endl;
+	}
+	else {
+		record.new_hash = sha256_file_hex(candidate);
+		if (next.kappa >= base.kappa - cfg.incremental_tolerance) {
+			cout << YELLOW << BOLD << "[INCREMENTAL] Candidato descartado: no se pudo guardar en el registro" << RESET << endl;
 		}
+		else {
+			cout << YELLOW << BOLD << "[INCREMENTAL] Candidato descartado: QWK " << next.kappa << " < " << base.kappa
+				<< " - tolerancia " << cfg.incremental_tolerance << RESET << endl;
+		}
+		cout << YELLOW << "[INCREMENTAL] " << final_model.string() << " y production (" << base_hash
+			<< ") no cambian; el candidato queda sin registrar en " << candidate.string() << RESET << endl;
+	}
+	insert_incremental_retrain_sqlite(record);
 
-		double acc = accuracy(y_true, y_pred);
-		double f1 = f1_score_macro(y_true, y_pred);
-		total_acc += acc;
-		total_f1 += f1;
-		double kappa = quadratic_weighted_kappa(y_true, y_pred, NUM_CLASSES);
-		total_kappa += kappa;
+	if (full_seconds >= 0.0) {
+		printf("[INCREMENTAL] %.2f s vs %.2f s estimados para el reentrenamiento completo -> ahorro %.2f s\n",
+			seconds, full_seconds, full_seconds - seconds);
+	}
+	else {
+		printf("[INCREMENTAL] %.2f s (sin historial de lightgbm_train_final para estimar el ahorro)\n", seconds);
+	}
+	return 0;
+}
 
-		cout << GREEN << BOLD << "Fold " << fold << " - Accuracy: " << acc << ", F1 macro: " << f1 << ", Kappa: " << kappa << RESET << endl;
+// Modo multi-semilla (seeds=...): cada trabajo (folds y holdout) se entrena y predice
+// una vez por semilla con sus variantes de config; todas las variantes se lanzan a
+// la vez y el scheduler las admite de a max_parallel_jobs, cada una con su parte
+// del presupuesto de hilos. Métricas por semilla y del ensemble en resultados_semillas.
+static int run_multi_seed(RunContext& ctx, const vector<SeedJob>& jobs, const fs::path& root) {
+	const RunConfig& cfg = ctx.config;
+	const vector<int>& seeds = cfg.seeds;
+	int threads = seed_threads_per_job(cfg.seed_thread_budget, cfg.max_parallel_jobs);
+	cout << BLUE << BOLD << "\n=== Evaluacion multi-semilla: " << seeds.size() << " semillas x " << jobs.size()
+		<< " trabajos | " << threads << " hilos por LightGBM ===" << RESET << endl;
 
-		// Calcular y mostrar matriz de confusión
-		vector<vector<int>> matrix(NUM_CLASSES, vector<int>(NUM_CLASSES, 0));
-		for (size_t i = 0; i < y_true.size(); ++i) {
-			matrix[y_true[i]][y_pred[i]]++;
+	// Variantes y estado por (semilla, trabajo): 0 = ok, 1 = entrenamiento, 2 = predicción, 3 = config
+	size_t n = seeds.size() * jobs.size();
+	vector<SeedVariant> variants(n);
+	vector<int> status(n, 0);
+	vector<StreamedPredictions> streams(n);
+	for (size_t s = 0; s < seeds.size(); ++s) {
+		for (size_t j = 0; j < jobs.size(); ++j) {
+			size_t i = s * jobs.size() + j;
+			variants[i] = write_seed_variant(jobs[j], root / ("seed_" + to_string(seeds[s])), seeds[s], threads);
+			if (!variants[i].ok) status[i] = 3;
 		}
+	}
+	{
+		TraceSpan span_jobs("trabajos_semillas", "fase");
+		vector<thread> workers;
+		for (size_t i = 0; i < n; ++i) {
+			if (status[i] != 0) continue;
+			workers.emplace_back([&, i] {
+				const SeedJob& job = jobs[i % jobs.size()];
+				const SeedVariant& v = variants[i];
+				string name = "s" + to_string(seeds[i / jobs.size()]) + "_" + job.tag;
+				trace_set_thread_name(name);
+				TraceSpan span_job("semilla", "fold", job.fold);
+				// Mismas fases que los trabajos sin semilla: comparten el historial de memoria
+				bool holdout = job.fold < 0;
+				int seed = seeds[i / jobs.size()];
+				if (run_lightgbm(ctx, v.config_train, holdout ? "lightgbm_train_holdout" : "lightgbm_train",
+					"entrenar_" + name, "train", job.fold, nullptr, job.repeat, seed) != 0) {
+					status[i] = 1;
+					return;
+				}
+				streams[i].labels = job.labels;
+				streams[i].num_classes = cfg.num_classes;
+				if (run_lightgbm(ctx, v.config_pred, holdout ? "lightgbm_predict_holdout" : "lightgbm_predict",
+					"predecir_" + name, "predict", job.fold, &streams[i], job.repeat, seed) != 0) {
+					status[i] = 2;
+				}
+			});
+		}
+		for (auto& worker : workers) worker.join();
+	}
 
-		cout << "\nMatriz de confusion fold " << fold << ":" << endl;
-		for (int i = 0; i < NUM_CLASSES; ++i) {
-			for (int j = 0; j < NUM_CLASSES; ++j) {
-				cout << matrix[i][j] << "\t";
+	vector<SeedScore> scores, ensemble;
+	for (size_t j = 0; j < jobs.size(); ++j) {
+		const SeedJob& job = jobs[j];
+		vector<int> y_true = read_labels(job.labels.string());
+		vector<vector<double>> member_probs;
+		int member_cols = 0;
+		for (size_t s = 0; s < seeds.size(); ++s) {
+			size_t i = s * jobs.size() + j;
+			if (status[i] != 0) {
+				cerr << RED << "[ERROR] Semilla " << seeds[s] << ", " << job.tag << ": "
+					<< (status[i] == 1 ? "fallo el entrenamiento" : status[i] == 2 ? "fallo la prediccion" : "no se pudo escribir el config")
+					<< RESET << endl;
+				continue;
+			}
+			int cols = 0;
+			vector<double> probs;
+			vector<int> y_pred;
+			if (streams[i].valid) {
+				cols = streams[i].cols;
+				probs = std::move(streams[i].probs);
+				y_pred = std::move(streams[i].y_pred);
+			}
+			else {
+				probs = read_probabilities(variants[i].predictions.string(), cols);
+				y_pred = argmax_classes(probs, cols);
+			}
+			if (y_true.empty() || y_true.size() != y_pred.size()) {
+				cerr << RED << "[ERROR] Semilla " << seeds[s] << ", " << job.tag << ": tamano inconsistente" << RESET << endl;
+				continue;
 			}
-			cout << endl;
+			SeedScore score;
+			score.seed = seeds[s];
+			score.repeat = job.repeat;
+			score.fold = job.fold;
+			score.tag = job.tag;
+			// Con FIFO la matriz de confusión ya se armó mientras llegaban las filas
+			ConfusionMetrics m = streams[i].valid ? streams[i].metrics()
+				: metrics_from_confusion(confusion_matrix(y_true, y_pred, cfg.num_classes));
+			score.accuracy = m.accuracy;
+			score.f1_macro = m.f1_macro;
+			score.kappa = m.kappa;
+			scores.push_back(score);
+			if (cfg.seed_ensemble && (member_cols == 0 || member_cols == cols)) {
+				member_cols = cols;
+				member_probs.push_back(std::move(probs));
+			}
+		}
+
+		// Ensemble: promedio de las probabilidades de las semillas que terminaron bien
+		if (member_probs.size() < 2) continue;
+		vector<const vector<double>*> members;
+		for (const auto& probs : member_probs) members.push_back(&probs);
+		vector<double> avg = average_probabilities(members);
+		vector<int> y_pred = argmax_classes(avg, member_cols);
+		if (y_pred.size() != y_true.size()) continue;
+		save_probabilities(root / "ensemble" / ("predictions_" + job.tag + ".txt"), avg, member_cols);
+		SeedScore score;
+		score.repeat = job.repeat;
+		score.fold = job.fold;
+		score.tag = job.tag;
+		score.accuracy = accuracy(y_true, y_pred);
+		score.f1_macro = f1_score_macro(y_true, y_pred, cfg.num_classes);
+		score.kappa = quadratic_weighted_kappa(y_true, y_pred, cfg.num_classes);
+		ensemble.push_back(score);
+	}
+	if (scores.empty()) {
+		cerr << RED << BOLD << "❌ Ninguna semilla produjo predicciones evaluables." << RESET << endl;
+		return 1;
+	}
+	print_seed_summary(scores, ensemble, seeds);
+	insert_seed_results_sqlite(ctx.run_id, scores, ensemble);
+	cout << MAGENTA << "📁 " << scores.size() << " resultados por semilla" << (ensemble.empty() ? "" : " y "
+		+ to_string(ensemble.size()) + " del ensemble") << " en resultados_semillas (corrida " << ctx.run_id << ")" << RESET << endl;
+	return 0;
+}
+
+// Drift entre train_all y los datos de inferencia antes de puntuarlos: PSI y KS por
+// feature con sketches de memoria fija. Devuelve false si algún feature supera
+// drift_psi_max o drift_ks_max y drift_action=fail (la inferencia no se corre).
+static bool check_inference_drift(RunContext& ctx, const fs::path& train_config, const fs::path& infer_config,
+	const fs::path& report_csv) {
+	const RunConfig& cfg = ctx.config;
+	cout << CYAN << BOLD << "\n=== Drift train vs test ===" << RESET << endl;
+	DriftOptions options;
+	options.num_threads = cfg.num_threads;
+	DatasetProfile train = profile_config_dataset(train_config, -1, options);
+	DatasetProfile test = train.ok ? profile_config_dataset(infer_config, static_cast<int>(train.features.size()), options)
+		: DatasetProfile();
+	if (!train.ok || !test.ok) {
+		cerr << RED << "[ERROR] No se pudo perfilar train/test para el chequeo de drift" << RESET << endl;
+		return cfg.drift_action != "fail";
+	}
+	for (const DatasetProfile* p : { &train, &test }) {
+		printf("[DRIFT] %s: %llu filas, %.1f MB en %.2f s -> %.0f filas/s, %.1f MB/s\n", p->path.string().c_str(),
+			static_cast<unsigned long long>(p->rows), p->bytes / (1024.0 * 1024.0), p->seconds, p->rows_per_second(),
+			p->mb_per_second());
+	}
+
+	vector<FeatureDrift> drift = compare_profiles(train, test, options.psi_bins);
+	vector<const FeatureDrift*> exceeded;
+	for (const FeatureDrift& d : drift) {
+		if (d.psi > cfg.drift_psi_max || (cfg.drift_ks_max > 0.0 && d.ks > cfg.drift_ks_max)) exceeded.push_back(&d);
+	}
+	vector<const FeatureDrift*> top;
+	for (const FeatureDrift& d : drift) top.push_back(&d);
+	sort(top.begin(), top.end(), [](const FeatureDrift* a, const FeatureDrift* b) { return a->psi > b->psi; });
+	if (top.size() > 10) top.resize(10);
+	printf("%-24s %8s %8s %10s %10s\n", "feature", "psi", "ks", "nan_train", "nan_test");
+	for (const FeatureDrift* d : top) {
+		printf("%-24s %8.4f %8.4f %10.4f %10.4f\n", d->name.c_str(), d->psi, d->ks, d->train_missing, d->test_missing);
+	}
+	save_drift_csv(report_csv, drift);
+	bool passed = exceeded.empty();
+	insert_drift_report_sqlite(ctx.run_id, train, test, drift, cfg.drift_psi_max, cfg.drift_ks_max, passed);
+	if (passed) {
+		cout << GREEN << "[DRIFT] " << drift.size() << " features dentro de los umbrales (PSI <= " << cfg.drift_psi_max
+			<< (cfg.drift_ks_max > 0.0 ? ", KS <= " + to_string(cfg.drift_ks_max) : string()) << ")" << RESET << endl;
+		return true;
+	}
+	string names;
+	for (const FeatureDrift* d : exceeded) names += (names.empty() ? "" : ", ") + d->name;
+	bool fail = cfg.drift_action == "fail";
+	cerr << (fail ? RED : YELLOW) << BOLD << (fail ? "[ERROR] " : "[WARN] ") << exceeded.size()
+		<< " features superan el umbral de drift: " << names << " (detalle en " << report_csv.string() << ")" << RESET << endl;
+	return !fail;
+}
+
+// Verificación y benchmark del motor QuickScorer con el modelo final: probabilidades
+// contra las de LightGBM (pred_infer.txt) y tiempos frente al recorrido nodo a nodo
+static void benchmark_predict_engines(RunContext& ctx, const fs::path& model_path, const fs::path& infer_config,
+	const fs::path& cli_predictions) {
+	const RunConfig& cfg = ctx.config;
+	cout << CYAN << BOLD << "\n=== Motor de prediccion: QuickScorer vs recorrido ===" << RESET << endl;
+	LgbmModel model;
+	DenseDataset data;
+	if (!model.load(model_path) || !load_config_dataset(infer_config, data, model.num_features())) {
+		cerr << YELLOW << "[WARN] Benchmark de motores omitido: no se pudo cargar el modelo o los datos" << RESET << endl;
+		return;
+	}
+	int k = model.num_tree_per_iteration();
+	QuickScorer scorer(model);
+	printf("[MOTOR] %zu arboles, %zu por recorrido (mas de 64 hojas) | kernel %s | predict_engine=%s\n",
+		model.trees().size(), scorer.fallback_trees(), scorer.vectorized() ? "AVX2 (4 filas)" : "escalar",
+		cfg.predict_engine.c_str());
+
+	double cli_diff = -1.0;
+	for (PredictEngine engine : { PredictEngine::Traversal, PredictEngine::QuickScorer }) {
+		double diff = compare_with_lightgbm_predictions(predict_proba_engine(model, data, engine, cfg.num_threads), k,
+			cli_predictions);
+		if (engine == PredictEngine::QuickScorer) cli_diff = diff;
+		if (diff < 0.0) {
+			cerr << YELLOW << "[WARN] No se pudo comparar con " << cli_predictions.string() << RESET << endl;
+			break;
+		}
+		printf("%s[MOTOR] %-11s diferencia maxima con LightGBM: %.3g%s\n", diff < 1e-9 ? GREEN : RED,
+			predict_engine_name(engine), diff, RESET);
+	}
+
+	vector<EngineBenchmark> bench = benchmark_engines(model, data);
+	printf("%6s %7s %5s %6s %12s %12s %12s %8s %9s\n", "iter", "arboles", "prof", "hojas", "recorrido ms",
+		"quickscr ms", "escalar ms", "speedup", "dif");
+	for (const EngineBenchmark& b : bench) {
+		printf("%6d %7d %5d %6d %12.3f %12.3f %12.3f %7.2fx %9.2g\n", b.iterations, b.trees, b.max_depth, b.max_leaves,
+			b.traversal_ms, b.quickscorer_ms, b.scalar_ms, b.speedup(), b.max_diff);
+	}
+	if (!bench.empty()) {
+		printf("[MOTOR] %zu filas, un hilo, mejor de varias pasadas\n", bench.front().rows);
+		insert_engine_benchmark_sqlite(ctx.run_id, hash_file_hex(model_path.string()), bench, cli_diff);
+	}
+}
+
+int main(int argc, char* argv[]) {
+	fs::path exe_path = executable_path(argc > 0 ? argv[0] : nullptr).parent_path();
+
+	fs::path fold_dir = exe_path / "folds";
+	fs::path lightgbm_path = exe_path / LIGHTGBM_EXECUTABLE;
+
+	RunConfig run_cfg = load_run_config(exe_path / "run_config.txt", argc, argv);
+	FarmSettings farm_settings;
+	farm_settings.queue_db = run_cfg.queue_db;
+	farm_settings.lease_seconds = run_cfg.lease_seconds;
+	farm_settings.max_attempts = run_cfg.max_attempts;
+	farm_settings.idle_exit_seconds = run_cfg.worker_idle_exit;
+	farm_settings.wait_timeout_seconds = run_cfg.farm_wait_timeout;
+
+	// Worker del farm: sólo atiende la cola, no corre el pipeline
+	if (run_cfg.farm_mode == "worker") {
+		return run_worker(lightgbm_path, farm_settings);
+	}
+
+	// --top N: consulta el leaderboard materializado y termina
+	if (run_cfg.top_n > 0) {
+		ensure_experiment_schema("resultados.db");
+		print_leaderboard(run_cfg.top_n, run_cfg.top_by, "resultados.db");
+		return 0;
+	}
+
+	// Trazas: se exportan a traza_pipeline.json y trazas_fases al terminar main()
+	// Con --resume se reutiliza el run_id para continuar su journal
+	string run_id = run_cfg.resume_run_id.empty() ? generate_run_id() : run_cfg.resume_run_id;
+	TraceSession trace_session(run_id, exe_path / "traza_pipeline.json", "resultados.db");
+	TraceSpan span_pipeline("pipeline", "pipeline");
+	// Resumen de recursos por fase/trabajo y estado final de la corrida al terminar (cualquier
+	// return): 0 = terminada, 4 = abortada (drift), otro código o excepción = fallida
+	struct ResourceSummaryOnExit {
+		const string& id;
+		int exit_code = -1;
+		~ResourceSummaryOnExit() {
+			record_run_end(id, exit_code == 0 ? "terminada" : exit_code == 4 ? "abortada" : "fallida");
+			print_resource_summary(id);
 		}
+	} resource_summary{ run_id };
+	auto finish_run = [&resource_summary](int exit_code) {
+		resource_summary.exit_code = exit_code;
+		return exit_code;
+	};
+	cout << CYAN << "[INFO] Corrida " << run_id << RESET << endl;
+
+	// Esquema de experimentos (migra resultados la primera vez) y alta de la corrida
+	ensure_experiment_schema("resultados.db");
+	record_run_start(run_id, run_cfg.experiment, run_cfg.num_folds, run_cfg.num_repeats, run_cfg.num_classes);
+
+	RunJournal journal("resultados.db", run_id);
+	if (!run_cfg.resume_run_id.empty()) {
+		int done = journal.completed_count();
+		if (done == 0) {
+			cerr << YELLOW << "[WARN] La corrida " << run_id << " no tiene etapas completas en el journal; se ejecuta completa." << RESET << endl;
+		}
+		else {
+			cout << CYAN << "[INFO] Reanudando corrida " << run_id << ": " << done << " etapas completas en el journal" << RESET << endl;
+		}
+	}
+	uint64_t mem_cap = run_cfg.mem_cap_mb > 0 ? run_cfg.mem_cap_mb * 1024 * 1024 : physical_memory_bytes() / 4 * 3;
+	if (mem_cap == 0) mem_cap = 4ull * 1024 * 1024 * 1024;
+	MemoryScheduler scheduler(mem_cap, run_cfg.max_parallel_jobs);
+	// Hashes de contenido memorizados por (ruta, tamaño, mtime): las huellas de etapas
+	// y las claves de datasets no releen los archivos que no cambiaron
+	enable_file_hash_memo("resultados.db");
+	StageCache cache("resultados.db", "cache_etapas", run_cfg.stage_cache);
+	DatasetCache datasets("resultados.db", "cache_datasets", run_cfg.dataset_cache);
+	RunContext ctx{ run_id, lightgbm_path, scheduler, journal, run_cfg, cache, datasets, hash_file_hex(lightgbm_path) };
+	cout << CYAN << "[INFO] Trabajos simultaneos: " << run_cfg.max_parallel_jobs
+		<< " | tope de memoria: " << (mem_cap / (1024 * 1024)) << " MB" << RESET << endl;
+	{
+		string selected;
+		for (const string& stage : all_stages()) {
+			if (stage_selected(run_cfg, stage)) selected += (selected.empty() ? "" : ",") + stage;
+		}
+		cout << CYAN << "[INFO] Etapas: " << selected << " | cache de etapas: " << (cache.enabled() ? "si" : "no")
+			<< " | cache de datasets: " << (datasets.enabled() ? "si" : "no") << RESET << endl;
+	}
+
+	fs::path cfg_train_hold = fold_dir / "config_train_holdout.txt";
+	fs::path cfg_pred_hold = fold_dir / "config_pred_holdout.txt";
+	fs::path y_hold = fold_dir / "y_holdout_valid.txt";
+	bool holdout_available = fs::exists(cfg_train_hold) && fs::exists(cfg_pred_hold) && fs::exists(y_hold);
+
+	// --incremental: sólo continúa el modelo en producción, sin CV ni reentrenamiento completo
+	if (run_cfg.incremental) {
+		return finish_run(run_incremental_retrain(ctx, fold_dir, cfg_pred_hold, y_hold));
+	}
+
+	const int num_folds = run_cfg.num_folds;
+	const int num_repeats = run_cfg.num_repeats;
+	const int num_classes = run_cfg.num_classes;
+	const int num_jobs = num_folds * num_repeats;
+	cout << CYAN << "[INFO] CV: " << num_repeats << "x" << num_folds << " folds | clases: " << num_classes << RESET << endl;
 
-		// Guardar matriz de confusión como CSV
-		ofstream matrix_file((exe_path / ("matriz_confusion_fold_" + to_string(fold) + ".csv")).string());
-		for (int i = 0; i < NUM_CLASSES; ++i) {
-			for (int j = 0; j < NUM_CLASSES; ++j) {
-				matrix_file << matrix[i][j];
-				if (j < NUM_CLASSES - 1) matrix_file << ",";
+	// La repetición 0 usa folds/; la r > 0 usa folds/repeat_<r>/ con los mismos nombres de archivo
+	auto repeat_dir = [&](int r) { return r == 0 ? fold_dir : fold_dir / ("repeat_" + to_string(r)); };
+	// Sufijo de los archivos de salida: "fold_3" o, en repeticiones, "r1_fold_3"
+	auto fold_tag = [](int r, int fold) { return (r == 0 ? string() : "r" + to_string(r) + "_") + "fold_" + to_string(fold); };
+
+	// seeds=...: folds y holdout una vez por semilla, con reporte de varianza; reemplaza
+	// a la evaluación de una sola semilla (sin stacking ni modelo final)
+	if (!run_cfg.seeds.empty()) {
+		if (run_cfg.farm_mode == "coordinator") {
+			cerr << YELLOW << "[WARN] El modo multi-semilla corre local; se ignora --coordinator" << RESET << endl;
+		}
+		vector<SeedJob> seed_jobs;
+		for (int r = 0; r < num_repeats; ++r) {
+			for (int fold = 0; fold < num_folds; ++fold) {
+				fs::path dir = repeat_dir(r);
+				fs::path config_train = dir / ("config_train_fold_" + to_string(fold) + ".txt");
+				fs::path config_pred = dir / ("config_pred_fold_" + to_string(fold) + ".txt");
+				if (!fs::exists(config_train) || !fs::exists(config_pred)) {
+					cerr << YELLOW << "[WARN] Faltan config_train/config_pred del fold " << fold << " en " << dir.string() << RESET << endl;
+					continue;
+				}
+				seed_jobs.push_back({ fold_tag(r, fold), r, fold, config_train, config_pred,
+					dir / ("y_valid_fold_" + to_string(fold) + ".txt") });
 			}
-			matrix_file << "\n";
 		}
-		matrix_file.close();
+		if (holdout_available) seed_jobs.push_back({ "holdout", 0, -1, cfg_train_hold, cfg_pred_hold, y_hold });
+		return finish_run(run_multi_seed(ctx, seed_jobs, fold_dir / "semillas"));
+	}
 
-		// Guardar resultados
-		string conf_str = read_config(config_train);
-		int result_id = insert_result_sqlite(acc, f1, kappa, model_file, config_train, conf_str);
-		if (result_id != -1)
-			insert_predictions_sqlite(y_true, y_pred, result_id);
+	// =============== ENTRENAMIENTO Y PREDICCIÓN ===============
+	// Folds de todas las repeticiones y holdout se lanzan en paralelo; el scheduler decide cuántos corren a la vez.
+	// Estado: 0 = ok, 1 = falló el entrenamiento, 2 = falló la predicción, 3 = faltan archivos
+	// (en holdout se combinan como bits: la predicción se intenta igual)
+	vector<int> fold_status(num_jobs, 0);
+	int holdout_status = 0;
+	vector<StreamedPredictions> fold_streams(num_jobs);
+	StreamedPredictions holdout_stream;
+	if (run_cfg.farm_mode == "coordinator") {
+		// Coordinador: cada fold (y el holdout) es un trabajo de la cola que entrena y
+		// predice en algún worker; las salidas vuelven a las rutas de los configs
+		TraceSpan span_jobs("trabajos_lightgbm", "fase");
+		vector<FarmJob> farm_jobs;
+		vector<int> job_slot;   // posición en fold_status; -1 = holdout
+		// Trabajo resuelto sin despachar: por journal o cache (la predicción se mira después
+		// de restaurar el modelo, que es una de sus entradas) o porque train no está seleccionado
+		auto already_done = [&](const string& tag, const fs::path& config_train, const fs::path& config_pred, int& status) {
+			StageSpec train = lightgbm_stage("entrenar_" + tag, "train", config_train, ctx.lightgbm_hash);
+			if (stage_reused(ctx, train, stage_fingerprint(train))) {
+				StageSpec pred = lightgbm_stage("predecir_" + tag, "predict", config_pred, ctx.lightgbm_hash);
+				if (stage_reused(ctx, pred, stage_fingerprint(pred))) return true;
+			}
+			if (stage_selected(run_cfg, "train")) return false;
+			bool present = lightgbm_outputs_exist(config_train) && lightgbm_outputs_exist(config_pred);
+			if (present) cout << YELLOW << "[SKIP] Trabajo " << tag << " (train) no seleccionado; se usan las salidas existentes" << RESET << endl;
+			else cerr << RED << "[ERROR] Trabajo " << tag << " (train) no seleccionado y sin salidas previas" << RESET << endl;
+			status = present ? 0 : 1;
+			return true;
+		};
+		for (int r = 0; r < num_repeats; ++r) {
+			for (int fold = 0; fold < num_folds; ++fold) {
+				string tag = fold_tag(r, fold);
+				fs::path config_train = repeat_dir(r) / ("config_train_fold_" + to_string(fold) + ".txt");
+				fs::path config_pred = repeat_dir(r) / ("config_pred_fold_" + to_string(fold) + ".txt");
+				if (!fs::exists(config_train) || !fs::exists(config_pred)) {
+					fold_status[r * num_folds + fold] = 3;
+					continue;
+				}
+				if (already_done(tag, config_train, config_pred, fold_status[r * num_folds + fold])) continue;
+				farm_jobs.push_back({ tag, "fold", fold, config_train, config_pred,
+					repeat_dir(r) / ("y_valid_fold_" + to_string(fold) + ".txt") });
+				job_slot.push_back(r * num_folds + fold);
+			}
+		}
+		int holdout_result = 0;
+		if (holdout_available && !already_done("holdout", cfg_train_hold, cfg_pred_hold, holdout_result)) {
+			farm_jobs.push_back({ "holdout", "holdout", -1, cfg_train_hold, cfg_pred_hold, y_hold });
+			job_slot.push_back(-1);
+		}
 
-		// Guardar y_true y y_pred como CSV individuales
-		string y_true_csv = (exe_path / ("y_true_fold_" + to_string(fold) + ".csv")).string();
-		string y_pred_csv = (exe_path / ("y_pred_fold_" + to_string(fold) + ".csv")).string();
-		save_vector_to_csv(y_true_csv, y_true);
-		save_vector_to_csv(y_pred_csv, y_pred);
-		// Guardar combinados en un CSV
-		save_combined_csv((exe_path / ("y_pred_vs_true_fold_" + to_string(fold) + ".csv")).string(), y_true, y_pred);
+		if (holdout_result != 0) holdout_status = 3;
 
-		// Generar gráfico de matriz de confusión
-		fs::path output_img = exe_path / ("conf_matrix_fold_" + to_string(fold) + ".png");
-		fs::path script_plot = exe_path / "scripts" / "plot_confusion_matrix.py";
-		string python_cmd = "python \"" + script_plot.string() + "\" \"" + y_true_csv + "\" \"" + y_pred_csv + "\" \"" + output_img.string() + "\"";
-		cout << "Generando matriz de confusion para fold " << fold << "..." << endl;
-		system(python_cmd.c_str());
+		vector<int> results = farm_run_jobs(run_id, farm_jobs, num_classes, farm_settings);
+		for (size_t i = 0; i < farm_jobs.size(); ++i) {
+			const FarmJob& job = farm_jobs[i];
+			// Mismas etapas del journal (y de la cache) que en la ejecución local
+			StageSpec train = lightgbm_stage("entrenar_" + job.name, "train", job.config_train, ctx.lightgbm_hash);
+			string train_hash = stage_fingerprint(train);
+			journal.begin(train.name, train_hash);
+			journal.finish(train.name, results[i] != 1, "farm");
+			if (results[i] != 1) {
+				cache.store(train, train_hash);
+				StageSpec pred = lightgbm_stage("predecir_" + job.name, "predict", job.config_pred, ctx.lightgbm_hash);
+				string pred_hash = stage_fingerprint(pred);
+				journal.begin(pred.name, pred_hash);
+				journal.finish(pred.name, results[i] == 0, "farm");
+				if (results[i] == 0) cache.store(pred, pred_hash);
+			}
+			if (job_slot[i] >= 0) fold_status[job_slot[i]] = results[i];
+			else holdout_status = results[i] == 1 ? 3 : results[i];
+		}
+	}
+	else {
+		TraceSpan span_jobs("trabajos_lightgbm", "fase");
+		vector<thread> workers;
+		for (int r = 0; r < num_repeats; ++r) {
+			for (int fold = 0; fold < num_folds; ++fold) {
+				workers.emplace_back([&, r, fold] {
+					trace_set_thread_name(fold_tag(r, fold));
+					TraceSpan span_fold("fold", "fold", fold);
+					int& status = fold_status[r * num_folds + fold];
+					fs::path config_train = repeat_dir(r) / ("config_train_fold_" + to_string(fold) + ".txt");
+					fs::path config_pred = repeat_dir(r) / ("config_pred_fold_" + to_string(fold) + ".txt");
+					if (!fs::exists(config_train) || !fs::exists(config_pred)) {
+						status = 3;
+						return;
+					}
+					if (run_lightgbm(ctx, config_train, "lightgbm_train", "entrenar_" + fold_tag(r, fold), "train", fold,
+						nullptr, r) != 0) {
+						status = 1;
+						return;
+					}
+					StreamedPredictions& streamed = fold_streams[r * num_folds + fold];
+					streamed.labels = repeat_dir(r) / ("y_valid_fold_" + to_string(fold) + ".txt");
+					streamed.num_classes = num_classes;
+					if (run_lightgbm(ctx, config_pred, "lightgbm_predict", "predecir_" + fold_tag(r, fold), "predict", fold,
+						&streamed, r) != 0) {
+						status = 2;
+					}
+				});
+			}
+		}
+		if (holdout_available) {
+			workers.emplace_back([&] {
+				trace_set_thread_name("holdout");
+				TraceSpan span_holdout("holdout", "fase");
+				if (run_lightgbm(ctx, cfg_train_hold, "lightgbm_train_holdout", "entrenar_holdout", "train") != 0) holdout_status |= 1;
+				holdout_stream.labels = y_hold;
+				holdout_stream.num_classes = num_classes;
+				if (run_lightgbm(ctx, cfg_pred_hold, "lightgbm_predict_holdout", "predecir_holdout", "predict", -1, &holdout_stream) != 0) holdout_status |= 2;
+			});
+		}
+		for (auto& worker : workers) worker.join();
+	}
+	if (cache.hits() > 0) {
+		printf("%s[CACHE] %d etapas restauradas de cache_etapas/ (%.1f MB) sin volver a correr LightGBM%s\n",
+			GREEN, cache.hits(), cache.restored_bytes() / (1024.0 * 1024.0), RESET);
+	}
+	if (datasets.hits() > 0) {
+		printf("%s[DATASET] %d entrenamientos cargaron binarios de cache_datasets/: ahorro de carga %.2f s%s\n",
+			GREEN, datasets.hits(), datasets.total_saved_seconds(), RESET);
+	}
+
+	// Métricas por fold de todas las repeticiones (para medias y varianzas)
+	vector<double> fold_acc, fold_f1, fold_kappa;
+	vector<vector<double>> repeat_kappa(num_repeats);
+
+	// Archivo global para guardar todas las predicciones
+	ofstream global_csv(exe_path / "predicciones_completas.csv");
+	global_csv << "repeticion,fold,indice,y_true,y_pred\n";
+
+	// Probabilidades out-of-fold por índice original de fila (entrada del stacking)
+	OofBuilder oof_builder(num_classes);
+
+	for (int r = 0; r < num_repeats; ++r) {
+		int64_t oof_offset = 0;
+		bool oof_offset_known = true;
+		for (int fold = 0; fold < num_folds; ++fold) {
+			string tag = fold_tag(r, fold);
+			cout << "\n=== Fold " << fold << (r > 0 ? " (repeticion " + to_string(r) + ")" : "") << " ===" << endl;
+
+			fs::path dir = repeat_dir(r);
+			string valid_labels = (dir / ("y_valid_fold_" + to_string(fold) + ".txt")).string();
+			string model_file = (dir / ("model_fold_" + to_string(fold) + ".txt")).string();
+			string pred_file = (dir / ("predictions_fold_" + to_string(fold) + ".txt")).string();
+			string config_train = (dir / ("config_train_fold_" + to_string(fold) + ".txt")).string();
+
+			// Las filas del fold cuentan para el orden de concatenación aunque el fold falle;
+			// sin etiquetas no se sabe cuántas son y el orden deja de ser confiable
+			vector<int> y_true = read_labels(valid_labels);
+			int64_t fold_offset = oof_offset;
+			oof_offset += static_cast<int64_t>(y_true.size());
+			if (y_true.empty()) oof_offset_known = false;
+
+			int status = fold_status[r * num_folds + fold];
+			if (status == 3) {
+				cerr << YELLOW << "[WARN] Faltan config_train/config_pred del fold " << fold << " en " << dir.string() << RESET << endl;
+				continue;
+			}
+
+			if (status == 1) {
+				cerr << RED << BOLD << "Error en entrenamiento del fold " << fold << RESET << endl;
+				continue;
+			}
+
+			if (status == 2) {
+				cerr << RED << BOLD << "Error en prediccion del fold " << fold << RESET << endl;
+				continue;
+			}
+
+			// Leer resultados (ya en memoria si la predicción se leyó de la FIFO)
+			StreamedPredictions& streamed = fold_streams[r * num_folds + fold];
+			int prob_cols = 0;
+			vector<double> probs;
+			vector<int> y_pred;
+			if (streamed.valid) {
+				prob_cols = streamed.cols;
+				probs = std::move(streamed.probs);
+				y_pred = std::move(streamed.y_pred);
+			}
+			else {
+				probs = read_probabilities(pred_file, prob_cols);
+				y_pred = argmax_classes(probs, prob_cols);
+			}
+
+			if (y_true.size() != y_pred.size()) {
+				cerr << RED << BOLD << "Tamaño inconsistente en fold " << fold << RESET << endl;
+				continue;
+			}
+
+			// Índices originales de las filas de validación (valid_idx_fold_<k>.txt); sin ese
+			// archivo se asume el orden de concatenación de los folds, sólo en la repetición 0
+			if (prob_cols == num_classes) {
+				vector<int64_t> row_idx;
+				fs::path idx_file = dir / ("valid_idx_fold_" + to_string(fold) + ".txt");
+				if (fs::exists(idx_file)) {
+					for (int idx : read_labels(idx_file.string())) row_idx.push_back(idx);
+				}
+				else if (r == 0 && oof_offset_known) {
+					for (size_t i = 0; i < y_true.size(); ++i) row_idx.push_back(fold_offset + static_cast<int64_t>(i));
+				}
+				if (row_idx.size() == y_true.size()) oof_builder.add_fold(row_idx, y_true, probs);
+				else cerr << YELLOW << "[WARN] Fold " << tag << " fuera de la matriz OOF: indices de fila no disponibles" << RESET << endl;
+			}
+
+			TraceSpan span_eval("evaluar_fold", "fase", fold);
+			// Con FIFO la matriz de confusión se armó mientras llegaban las filas
+			vector<vector<int>> matrix = streamed.valid ? std::move(streamed.confusion) : confusion_matrix(y_true, y_pred, num_classes);
+			ConfusionMetrics fold_metrics = metrics_from_confusion(matrix);
+			double acc = fold_metrics.accuracy;
+			double f1 = fold_metrics.f1_macro;
+			double kappa = fold_metrics.kappa;
+			fold_acc.push_back(acc);
+			fold_f1.push_back(f1);
+			fold_kappa.push_back(kappa);
+			repeat_kappa[r].push_back(kappa);
+
+			cout << GREEN << BOLD << "Fold " << fold << " - Accuracy: " << acc << ", F1 macro: " << f1 << ", Kappa: " << kappa << RESET << endl;
+
+			// Agregar al CSV global las predicciones de este fold
+			for (size_t i = 0; i < y_true.size(); ++i) {
+				global_csv << r << "," << fold << "," << i << "," << y_true[i] << "," << y_pred[i] << "\n";
+			}
+
+			// Persistencia (SQLite, CSVs, gráfico): se saltea si ya quedó hecha con estas predicciones
+			string eval_stage = "evaluar_" + tag;
+			// Sin archivo de predicción (FIFO sin copia) la huella sale de las probabilidades en memoria
+			string eval_hash = streamed.valid && !run_cfg.stream_keep_file ? probs_hash(probs, { valid_labels })
+				: files_hash({ pred_file, valid_labels });
+			if (!stage_selected(run_cfg, "evaluate")) {
+				cout << YELLOW << "[SKIP] Etapa " << eval_stage << " (evaluate) no seleccionada; no se persiste" << RESET << endl;
+				continue;
+			}
+			if (journal.completed(eval_stage, eval_hash)) {
+				cout << GREEN << "[RESUME] Etapa " << eval_stage << " ya completa; no se vuelve a persistir" << RESET << endl;
+				continue;
+			}
+			journal.begin(eval_stage, eval_hash);
+
+			// Mostrar matriz de confusión
+			cout << "\nMatriz de confusion fold " << fold << ":" << endl;
+			for (int i = 0; i < num_classes; ++i) {
+				for (int j = 0; j < num_classes; ++j) {
+					cout << matrix[i][j] << "\t";
+				}
+				cout << endl;
+			}
+
+			// Guardar matriz de confusión como CSV
+			ofstream matrix_file((exe_path / ("matriz_confusion_" + tag + ".csv")).string());
+			for (int i = 0; i < num_classes; ++i) {
+				for (int j = 0; j < num_classes; ++j) {
+					matrix_file << matrix[i][j];
+					if (j < num_classes - 1) matrix_file << ",";
+				}
+				matrix_file << "\n";
+			}
+			matrix_file.close();
+
+			// Guardar resultados
+			string conf_str = read_config(config_train);
+			int result_id = insert_result_sqlite(acc, f1, kappa, model_file, config_train, conf_str, y_true, y_pred, run_id);
+			if (result_id != -1) {
+				// El modelo del fold queda en el registro aunque la próxima corrida pise el archivo
+				FoldResultRecord fold_record;
+				fold_record.run_id = run_id;
+				fold_record.repeat = r;
+				fold_record.fold = fold;
+				fold_record.config_path = config_train;
+				fold_record.model_hash = registry_store_model(model_file, { run_id, result_id, config_train, acc, f1, kappa });
+				fold_record.id_resultado = result_id;
+				fold_record.accuracy = acc;
+				fold_record.f1_macro = f1;
+				fold_record.kappa = kappa;
+				record_fold_result(fold_record);
+			}
+
+			// Guardar y_true y y_pred como CSV individuales
+			string y_true_csv = (exe_path / ("y_true_" + tag + ".csv")).string();
+			string y_pred_csv = (exe_path / ("y_pred_" + tag + ".csv")).string();
+			save_vector_to_csv(y_true_csv, y_true);
+			save_vector_to_csv(y_pred_csv, y_pred);
+			// Guardar combinados en un CSV
+			save_combined_csv((exe_path / ("y_pred_vs_true_" + tag + ".csv")).string(), y_true, y_pred);
 
-		// Agregar al CSV global las predicciones de este fold
-		for (size_t i = 0; i < y_true.size(); ++i) {
-			global_csv << fold << "," << i << "," << y_true[i] << "," << y_pred[i] << "\n";
+			// Generar gráfico de matriz de confusión (misma y_true/y_pred que una corrida anterior: sale de la cache)
+			if (stage_selected(run_cfg, "plot")) {
+				StageSpec plot;
+				plot.name = "graficar_" + tag;
+				plot.kind = "plot";
+				plot.inputs = { y_true_csv, y_pred_csv, exe_path / "scripts" / "plot_confusion_matrix.py" };
+				plot.outputs = { exe_path / ("conf_matrix_" + tag + ".png") };
+				run_stage(ctx, plot, [&] {
+					string python_cmd = "python \"" + plot.inputs[2].string() + "\" \"" + y_true_csv + "\" \"" + y_pred_csv
+						+ "\" \"" + plot.outputs[0].string() + "\"";
+					cout << "Generando matriz de confusion para fold " << fold << "..." << endl;
+					return run_child(run_id, python_cmd, "python_matriz_confusion", fold, 0, nullptr, r);
+				});
+			}
+
+			journal.finish(eval_stage, result_id != -1);
 		}
 	}
 
 	global_csv.close();
 
+	OofMatrix oof = oof_builder.build();
+	if (oof.rows() > 0 && save_oof_binary(exe_path / "oof_probabilidades.bin", oof)) {
+		cout << CYAN << "[INFO] Matriz OOF: " << oof.rows() << " filas x " << oof.num_classes
+			<< " clases -> oof_probabilidades.bin" << RESET << endl;
+	}
+
 	// (Nuevo) Reporte de Optuna usando la base que deja el script del profe en 'folds'
 	generate_optuna_report(fold_dir, exe_path);
 
 	// =============== HOLDOUT (20%) ===============
+	// Etiquetas y probabilidades del holdout quedan disponibles para el stacking
+	vector<int> y_true_hold;
+	vector<double> probs_hold;
+	int hold_cols = 0;
 	{
-		fs::path cfg_train_hold = fold_dir / "config_train_holdout.txt";
-		fs::path cfg_pred_hold = fold_dir / "config_pred_holdout.txt";
 		fs::path pred_hold = fold_dir / "predictions_holdout.txt";  // lo genera LightGBM al predecir
-		fs::path y_hold = fold_dir / "y_holdout_valid.txt";
 		fs::path model_hold = fold_dir / "model_holdout.txt";        // lo genera LightGBM al entrenar
 
-		if (!fs::exists(cfg_train_hold) || !fs::exists(cfg_pred_hold) || !fs::exists(y_hold)) {
+		if (!holdout_available) {
 			cerr << YELLOW << "[WARN] Archivos de HOLDOUT no encontrados en " << fold_dir
 				<< ". Generá primero con el script de Python: "
 				<< "config_train_holdout.txt / config_pred_holdout.txt / y_holdout_valid.txt."
@@ -172,32 +1075,48 @@ int main() {
 		else {
 			cout << CYAN << BOLD << "\n=== HOLDOUT (20%) ===" << RESET << endl;
 
-			// Entrenamiento holdout
-			string cmd_train_hold = lightgbm_path.string() + " config=" + cfg_train_hold.string();
-			cout << "[RUN] " << cmd_train_hold << endl;
-			if (system(cmd_train_hold.c_str()) != 0) {
+			// Entrenamiento y predicción holdout ya corrieron junto con los folds
+			if (holdout_status & 1) {
 				cerr << RED << BOLD << "[ERROR] LightGBM falló entrenando HOLDOUT." << RESET << endl;
 			}
-
-			// Predicción holdout
-			string cmd_pred_hold = lightgbm_path.string() + " config=" + cfg_pred_hold.string();
-			cout << "[RUN] " << cmd_pred_hold << endl;
-			if (system(cmd_pred_hold.c_str()) != 0) {
+			if (holdout_status & 2) {
 				cerr << RED << BOLD << "[ERROR] LightGBM falló prediciendo HOLDOUT." << RESET << endl;
 			}
 
 			// Leer y evaluar
-			vector<int> y_true_hold = read_labels(y_hold.string());
-			vector<int> y_pred_hold = read_predicted_classes(pred_hold.string());
+			y_true_hold = read_labels(y_hold.string());
+			vector<int> y_pred_hold;
+			vector<vector<int>> m;
+			if (holdout_stream.valid) {
+				m = std::move(holdout_stream.confusion);
+				hold_cols = holdout_stream.cols;
+				probs_hold = std::move(holdout_stream.probs);
+				y_pred_hold = std::move(holdout_stream.y_pred);
+			}
+			else {
+				probs_hold = read_probabilities(pred_hold.string(), hold_cols);
+				y_pred_hold = argmax_classes(probs_hold, hold_cols);
+				m = confusion_matrix(y_true_hold, y_pred_hold, num_classes);
+			}
+			string hold_hash = holdout_stream.valid && !run_cfg.stream_keep_file ? probs_hash(probs_hold, { y_hold })
+				: files_hash({ pred_hold, y_hold });
 
 			if (y_true_hold.empty() || y_true_hold.size() != y_pred_hold.size()) {
 				cerr << RED << BOLD << "[ERROR] Tamaños inválidos en HOLDOUT: y_true="
 					<< y_true_hold.size() << " y_pred=" << y_pred_hold.size() << RESET << endl;
 			}
+			else if (!stage_selected(run_cfg, "evaluate")) {
+				cout << YELLOW << "[SKIP] Etapa evaluar_holdout (evaluate) no seleccionada; no se persiste" << RESET << endl;
+			}
+			else if (journal.completed("evaluar_holdout", hold_hash)) {
+				cout << GREEN << "[RESUME] Etapa evaluar_holdout ya completa; no se vuelve a persistir" << RESET << endl;
+			}
 			else {
-				double acc_hold = accuracy(y_true_hold, y_pred_hold);
-				double f1_hold = f1_score_macro(y_true_hold, y_pred_hold);
-				double kappa_hold = quadratic_weighted_kappa(y_true_hold, y_pred_hold, NUM_CLASSES);
+				journal.begin("evaluar_holdout", hold_hash);
+				ConfusionMetrics hold_metrics = metrics_from_confusion(m);
+				double acc_hold = hold_metrics.accuracy;
+				double f1_hold = hold_metrics.f1_macro;
+				double kappa_hold = hold_metrics.kappa;
 
 				cout << GREEN << BOLD << "[HOLDOUT] "
 					<< "Acc=" << acc_hold
@@ -206,12 +1125,10 @@ int main() {
 					<< " | n=" << y_true_hold.size() << RESET << endl;
 
 				// Matriz de confusión (CSV)
-				vector<vector<int>> m(NUM_CLASSES, vector<int>(NUM_CLASSES, 0));
-				for (size_t i = 0; i < y_true_hold.size(); ++i) m[y_true_hold[i]][y_pred_hold[i]]++;
 				ofstream mfile((exe_path / "matriz_confusion_holdout.csv").string());
-				for (int i = 0; i < NUM_CLASSES; ++i) {
-					for (int j = 0; j < NUM_CLASSES; ++j) {
-						mfile << m[i][j] << (j + 1 < NUM_CLASSES ? "," : "\n");
+				for (int i = 0; i < num_classes; ++i) {
+					for (int j = 0; j < num_classes; ++j) {
+						mfile << m[i][j] << (j + 1 < num_classes ? "," : "\n");
 					}
 				}
 				mfile.close();
@@ -225,71 +1142,206 @@ int main() {
 				int result_id = insert_result_sqlite(acc_hold, f1_hold, kappa_hold,
 					model_hold.string(),
 					cfg_train_hold.string(),
-					conf_str);
+					conf_str,
+					y_true_hold,
+					y_pred_hold,
+					run_id);
 				if (result_id != -1) {
-					insert_predictions_sqlite(y_true_hold, y_pred_hold, result_id);
+					FoldResultRecord hold_record;
+					hold_record.run_id = run_id;
+					hold_record.kind = "holdout";
+					hold_record.config_path = cfg_train_hold.string();
+					hold_record.model_hash = registry_store_model(model_hold.string(),
+						{ run_id, result_id, cfg_train_hold.string(), acc_hold, f1_hold, kappa_hold });
+					hold_record.id_resultado = result_id;
+					hold_record.accuracy = acc_hold;
+					hold_record.f1_macro = f1_hold;
+					hold_record.kappa = kappa_hold;
+					record_fold_result(hold_record);
+				}
+				journal.finish("evaluar_holdout", result_id != -1);
+			}
+		}
+	}
+
+	// =============== STACKING (meta-modelo sobre OOF) ===============
+	if (run_cfg.stacking && stage_selected(run_cfg, "stacking")) {
+		string stacking_hash = probs_hash(probs_hold, { exe_path / "oof_probabilidades.bin" });
+		if (oof.rows() == 0 || hold_cols != num_classes || y_true_hold.empty()
+			|| y_true_hold.size() * num_classes != probs_hold.size()) {
+			cerr << YELLOW << "[WARN] Stacking omitido: requiere matriz OOF y probabilidades de HOLDOUT con "
+				<< num_classes << " clases." << RESET << endl;
+		}
+		else if (journal.completed("stacking", stacking_hash)) {
+			cout << GREEN << "[RESUME] Etapa stacking ya completa (ver resultados_stacking)" << RESET << endl;
+		}
+		else {
+			journal.begin("stacking", stacking_hash);
+			TraceSpan span_stacking("stacking", "fase");
+			cout << CYAN << BOLD << "\n=== STACKING (regresion logistica multinomial sobre OOF) ===" << RESET << endl;
+			StackingOptions options;
+			options.l2 = run_cfg.stacking_l2;
+			options.num_threads = run_cfg.num_threads;
+			StackingFit fit = train_stacking_model(oof, options);
+			fs::path meta_path = exe_path / "modelo_stacking.txt";
+			save_stacking_model(meta_path, fit.model);
+
+			vector<int> y_base = argmax_classes(probs_hold, num_classes);
+			vector<int> y_meta = argmax_classes(stacking_predict_proba(fit.model, probs_hold), num_classes);
+
+			StackingRecord rec;
+			rec.run_id = run_id;
+			rec.model_path = meta_path.string();
+			rec.oof_rows = oof.rows();
+			rec.num_classes = num_classes;
+			rec.iterations = fit.iterations;
+			rec.l2 = options.l2;
+			rec.oof_logloss = fit.initial_loss;
+			rec.meta_logloss = fit.final_loss;
+			rec.base_acc = accuracy(y_true_hold, y_base);
+			rec.base_f1 = f1_score_macro(y_true_hold, y_base, num_classes);
+			rec.base_kappa = quadratic_weighted_kappa(y_true_hold, y_base, num_classes);
+			rec.meta_acc = accuracy(y_true_hold, y_meta);
+			rec.meta_f1 = f1_score_macro(y_true_hold, y_meta, num_classes);
+			rec.meta_kappa = quadratic_weighted_kappa(y_true_hold, y_meta, num_classes);
+			insert_stacking_result_sqlite(rec);
+
+			cout << GREEN << BOLD << "[STACKING] HOLDOUT base: Acc=" << rec.base_acc << " | F1macro=" << rec.base_f1
+				<< " | Kappa=" << rec.base_kappa << RESET << endl;
+			cout << GREEN << BOLD << "[STACKING] HOLDOUT meta: Acc=" << rec.meta_acc << " | F1macro=" << rec.meta_f1
+				<< " | Kappa=" << rec.meta_kappa << " (" << showpos << rec.meta_kappa - rec.base_kappa << noshowpos
+				<< ")" << RESET << endl;
+			journal.finish("stacking", true);
+		}
+	}
+
+	// =============== IMPORTANCIA POR PERMUTACION (QWK en holdout) ===============
+	if (run_cfg.permutation_importance && holdout_available && stage_selected(run_cfg, "importance")) {
+		fs::path model_hold = fold_dir / "model_holdout.txt";
+		string importance_hash = files_hash({ model_hold, cfg_pred_hold, y_hold }) + "_r" + to_string(run_cfg.permutation_repeats);
+		if (journal.completed("importancia_permutacion", importance_hash)) {
+			cout << GREEN << "[RESUME] Etapa importancia_permutacion ya completa (ver importancia_permutacion.csv)" << RESET << endl;
+		}
+		else {
+			journal.begin("importancia_permutacion", importance_hash);
+			cout << CYAN << BOLD << "\n=== IMPORTANCIA POR PERMUTACION (caida de Kappa en HOLDOUT) ===" << RESET << endl;
+			LgbmModel model;
+			DenseDataset data;
+			vector<int> labels = read_labels(y_hold.string());
+			bool ok = model.load(model_hold) && load_config_dataset(cfg_pred_hold, data);
+			if (ok && labels.size() != data.rows()) {
+				cerr << YELLOW << "[WARN] Importancia omitida: " << labels.size() << " etiquetas y " << data.rows()
+					<< " filas en el dataset de HOLDOUT" << RESET << endl;
+				ok = false;
+			}
+			if (ok) {
+				PermutationOptions options;
+				options.repeats = run_cfg.permutation_repeats;
+				options.num_threads = run_cfg.num_threads;
+				PermutationResult importance = permutation_importance(model, data, labels, num_classes, options);
+				save_permutation_importance_csv(exe_path / "importancia_permutacion.csv", importance);
+				insert_permutation_importance_sqlite(run_id, hash_file_hex(model_hold.string()), importance);
+				printf("[IMPORTANCIA] Kappa base=%.4f | %zu filas x %d features x %d repeticiones en %.2f s (%d hilos)\n",
+					importance.baseline_kappa, importance.rows, model.num_features(), importance.repeats,
+					importance.seconds, importance.threads);
+				for (size_t i = 0; i < importance.features.size() && i < 10; ++i) {
+					const FeatureImportance& fi = importance.features[i];
+					printf("  %-24s caida Kappa %.4f +- %.4f\n", fi.name.c_str(), fi.mean_drop, fi.std_drop);
 				}
 			}
+			journal.finish("importancia_permutacion", ok);
 		}
 	}
 
 	save_best_model();
 	save_best_model_by_kappa();
 
+	MetricSummary acc_sum = summarize_metric(fold_acc);
+	MetricSummary f1_sum = summarize_metric(fold_f1);
+	MetricSummary kappa_sum = summarize_metric(fold_kappa);
 	cout << CYAN << BOLD << "\n==== RESULTADO PROMEDIO ====" << endl;
-	cout << YELLOW << "Accuracy promedio: " << (total_acc / NUM_FOLDS) << endl;
-	cout << YELLOW << "F1 macro promedio: " << (total_f1 / NUM_FOLDS) << endl;
-	cout << YELLOW << "Kappa promedio: " << (total_kappa / NUM_FOLDS) << RESET << endl;
-
-	// Scripts de análisis visual
-	fs::path analysis1 = exe_path / "scripts" / "analysis_results.py";
-	fs::path analysis2 = exe_path / "scripts" / "analysis_results2.py";
+	cout << YELLOW << "Accuracy promedio: " << acc_sum.mean << " (desvio " << acc_sum.stddev << ", n=" << acc_sum.n << ")" << endl;
+	cout << YELLOW << "F1 macro promedio: " << f1_sum.mean << " (desvio " << f1_sum.stddev << ")" << endl;
+	cout << YELLOW << "Kappa promedio: " << kappa_sum.mean << " (desvio " << kappa_sum.stddev << ")" << RESET << endl;
 
-	cout << "\nEjecutando analisis visual en Python..." << endl;
-	system(("python \"" + analysis1.string() + "\"").c_str());
+	// CV repetida: varianza entre repeticiones de la media de Kappa
+	if (num_repeats > 1) {
+		vector<double> repeat_means;
+		for (int r = 0; r < num_repeats; ++r) {
+			if (repeat_kappa[r].empty()) continue;
+			MetricSummary rs = summarize_metric(repeat_kappa[r]);
+			repeat_means.push_back(rs.mean);
+			cout << "  Repeticion " << r << ": Kappa medio " << rs.mean << " (desvio " << rs.stddev << ", n=" << rs.n << ")" << endl;
+		}
+		MetricSummary between = summarize_metric(repeat_means);
+		cout << YELLOW << "Kappa entre repeticiones: media " << between.mean << " | varianza "
+			<< between.stddev * between.stddev << " | min " << between.min << " | max " << between.max << RESET << endl;
+	}
 
-	cout << "\nEjecutando analisis visual completo en Python..." << endl;
-	system(("python \"" + analysis2.string() + "\"").c_str());
+	// Scripts de análisis visual (leen resultados.db, que cambia en cada corrida: no se cachean)
+	if (stage_selected(run_cfg, "plot")) {
+		fs::path analysis1 = exe_path / "scripts" / "analysis_results.py";
+		fs::path analysis2 = exe_path / "scripts" / "analysis_results2.py";
 
-	// Generar gráfico de importancia de variables
-	fs::path script_importance = exe_path / "scripts" / "analyze_feature_importance.py";
-	fs::path output_importance_img = exe_path / "importancia_variables.png";
-	string importance_cmd = "python \"" + script_importance.string() + "\" \"" + fold_dir.string() + "\" \"" + output_importance_img.string() + "\"";
-	cout << "\nGenerando grafico de importancia de variables..." << endl;
-	system(importance_cmd.c_str());
+		cout << "\nEjecutando analisis visual en Python..." << endl;
+		run_child(run_id, "python \"" + analysis1.string() + "\"", "python_analisis_1");
 
-	char user_input;
-	cout << YELLOW << "\n¿Deseas continuar con el entrenamiento final del modelo con todo el dataset? (S/N): " << RESET;
-	cin >> user_input;
+		cout << "\nEjecutando analisis visual completo en Python..." << endl;
+		run_child(run_id, "python \"" + analysis2.string() + "\"", "python_analisis_2");
 
-	if (toupper(user_input) != 'S') {
-		cout << RED << "❌ Proceso de entrenamiento final cancelado por el usuario." << RESET << endl;
-		return 0;
+		// Generar gráfico de importancia de variables (entradas: modelos de los folds)
+		StageSpec importance_plot;
+		importance_plot.name = "graficar_importancia";
+		importance_plot.kind = "plot";
+		importance_plot.inputs.push_back(exe_path / "scripts" / "analyze_feature_importance.py");
+		for (int fold = 0; fold < num_folds; ++fold) {
+			importance_plot.inputs.push_back(fold_dir / ("model_fold_" + to_string(fold) + ".txt"));
+		}
+		importance_plot.outputs = { exe_path / "importancia_variables.png" };
+		run_stage(ctx, importance_plot, [&] {
+			string importance_cmd = "python \"" + importance_plot.inputs[0].string() + "\" \"" + fold_dir.string() + "\" \""
+				+ importance_plot.outputs[0].string() + "\"";
+			cout << "\nGenerando grafico de importancia de variables..." << endl;
+			return run_child(run_id, importance_cmd, "python_importancia");
+		});
 	}
 
-	// --- Entrenamiento final con todo el dataset ---
-	cout << BLUE << BOLD << "\n=== 🚀 Entrenando modelo final con todo el dataset ===" << RESET << endl;
+	// Entrenamiento final, inferencia y SHAP sólo si se seleccionaron (stages=...,final,infer,shap
+	// o final_model=yes); antes se preguntaba S/N por consola
+	if (!stage_selected(run_cfg, "final") && !stage_selected(run_cfg, "infer") && !stage_selected(run_cfg, "shap")) {
+		cout << YELLOW << "\n[INFO] Entrenamiento final no seleccionado (stages=all o final_model=yes para incluirlo)" << RESET << endl;
+		return finish_run(0);
+	}
 
 	string train_all_file = (fold_dir / "train_all.txt").string();
 	string config_final_file = (fold_dir / "config_train_all.txt").string();
+	fs::path infer_cfg = exe_path / "folds" / "config_pred_infer.txt";
 
-	{
-		fs::path bin_cache = fold_dir / "train_all.txt.bin";
-		std::error_code ec;
-		if (fs::exists(bin_cache, ec)) {
-			fs::remove(bin_cache, ec);
-			if (ec) {
-				cerr << YELLOW << "[WARN] No se pudo borrar " << bin_cache.string()
-					<< " (" << ec.message() << ")" << RESET << endl;
-			}
-			else {
-				cout << GREEN << "[OK] Limpiado cache binario: " << bin_cache.string() << RESET << endl;
-			}
+	// Con datos de test corridos respecto de train_all la submission sale mal sin avisar:
+	// se chequea el drift antes de entrenar el modelo final (sólo lee los datos de ambos
+	// configs), así una corrida cancelada no gasta el entrenamiento
+	if (run_cfg.drift_check && stage_selected(run_cfg, "infer") && fs::exists(infer_cfg)
+		&& !check_inference_drift(ctx, config_final_file, infer_cfg, exe_path / "drift_features.csv")) {
+		cerr << RED << BOLD << "❌ Inferencia cancelada por drift (drift_action=warn para sólo avisar)." << RESET << endl;
+		return finish_run(4);
+	}
+
+	// --- Entrenamiento final con todo el dataset ---
+	cout << BLUE << BOLD << "\n=== 🚀 Entrenando modelo final con todo el dataset ===" << RESET << endl;
+
+	// Las curvas de validación de los folds indican dónde habría cortado el early stopping
+	if (run_cfg.train_curves) {
+		IterationAdvice advice = recommend_iterations(load_training_curves_sqlite(run_id, "lightgbm_train"),
+			configured_iterations(config_final_file), num_folds > 1 ? static_cast<double>(num_folds) / (num_folds - 1) : 1.0);
+		if (advice.ok) {
+			print_iteration_advice(advice);
+			insert_iteration_advice_sqlite(run_id, advice);
 		}
 	}
 
-	string final_cmd = lightgbm_path.string() + " config=" + config_final_file;
-	if (system(final_cmd.c_str()) == 0) {
+	// train_all.txt.bin ya no se borra a mano: la cache de datasets quita los .bin viejos
+	// junto al texto y sólo reutiliza binarios cuya clave (contenido + binning) coincide
+	if (run_lightgbm(ctx, config_final_file, "lightgbm_train_final", "entrenar_final", "final") == 0) {
 		cout << GREEN << BOLD << "✅ Modelo final entrenado correctamente: "
 			<< (fold_dir / "model_all.txt").string() << RESET << endl;
 	}
@@ -299,15 +1351,26 @@ int main() {
 
 	fs::path final_model = exe_path / "folds" / "model_all.txt";
 	fs::path final_config = exe_path / "folds" / "config_train_all.txt";
-	save_final_model("resultados.db", final_model.string(), final_config.string());
+	string final_hash = files_hash({ final_model, final_config });
+	if (journal.completed("registrar_final", final_hash)) {
+		cout << GREEN << "[RESUME] Etapa registrar_final ya completa" << RESET << endl;
+	}
+	else {
+		journal.begin("registrar_final", final_hash);
+		save_final_model("resultados.db", final_model.string(), final_config.string(), run_id);
+		journal.finish("registrar_final", true);
+	}
 
 	// INFERENCIA después de entrenar el modelo final
-	fs::path infer_cfg = exe_path / "folds" / "config_pred_infer.txt";
 	if (fs::exists(infer_cfg)) {
 		cout << YELLOW << "\n=== Inferencia final sobre test.csv ===\n";
-		string infer_cmd = lightgbm_path.string() + " config=" + infer_cfg.string();
-		if (system(infer_cmd.c_str()) == 0) {
+		if (run_lightgbm(ctx, infer_cfg, "lightgbm_predict_infer", "inferencia", "infer") == 0) {
 			cout << GREEN << "[OK] Predicciones guardadas en folds/pred_infer.txt\n";
+			// El modelo que generó las predicciones entregadas pasa a producción
+			ModelLineage lineage;
+			lineage.run_id = run_id;
+			lineage.config_path = final_config.string();
+			registry_promote("production", registry_alias_hash("final"), lineage);
 		}
 		else {
 			cerr << RED << BOLD << "❌ Error al entrenar el modelo final." << RESET << endl;
@@ -317,10 +1380,97 @@ int main() {
 		std::cout << "[INFO] No se encontró folds/config_pred_infer.txt — se omite inferencia final.\n";
 	}
 
+	// =============== SHAP del modelo final sobre los datos de inferencia ===============
+	if (run_cfg.shap && stage_selected(run_cfg, "shap") && fs::exists(infer_cfg) && fs::exists(final_model)) {
+		string shap_hash = lightgbm_input_hash(infer_cfg.string()) + "_" + hash_file_hex(final_model)
+			+ "_b" + to_string(run_cfg.shap_background) + "_n" + to_string(run_cfg.shap_max_rows);
+		if (journal.completed("shap", shap_hash)) {
+			cout << GREEN << "[RESUME] Etapa shap ya completa (ver shap_valores.bin)" << RESET << endl;
+		}
+		else {
+			journal.begin("shap", shap_hash);
+			cout << CYAN << BOLD << "\n=== SHAP del modelo final ===" << RESET << endl;
+			LgbmModel model;
+			DenseDataset data, background;
+			bool ok = model.load(final_model) && load_config_dataset(infer_cfg, data, model.num_features());
+			if (ok && run_cfg.shap_max_rows > 0 && data.rows() > static_cast<size_t>(run_cfg.shap_max_rows)) {
+				data.values.resize(static_cast<size_t>(run_cfg.shap_max_rows) * data.num_features);
+			}
+			ShapOptions options;
+			options.num_threads = run_cfg.num_threads;
+			if (ok && run_cfg.shap_background > 0) {
+				if (load_config_dataset(final_config, background)) {
+					options.background = &background;
+					options.max_background = run_cfg.shap_background;
+				}
+				else {
+					cerr << YELLOW << "[WARN] Sin datos de fondo; se usa TreeSHAP path-dependent" << RESET << endl;
+				}
+			}
+			ShapResult shap;
+			if (ok) {
+				shap = compute_shap(model, data, options);
+				ok = shap.rows > 0;
+			}
+			if (ok) {
+				save_shap_binary(exe_path / "shap_valores.bin", shap);
+				save_shap_summary_csv(exe_path / "shap_resumen.csv", shap, model.feature_names());
+				if (run_cfg.shap_csv) save_shap_csv(exe_path / "shap_valores.csv", shap, model.feature_names());
+				printf("[SHAP] %s: %zu filas x %d clases x %d features en %.2f s -> %.0f filas/s (%d hilos)\n",
+					shap.background_rows > 0 ? "interventional" : "path-dependent", shap.rows, shap.num_classes,
+					shap.num_features, shap.seconds, shap.rows_per_second(), shap.threads);
+
+				// Validación contra pred_contrib de LightGBM sobre las primeras filas (mismo algoritmo
+				// sólo en modo path-dependent)
+				double max_diff = -1.0;
+				if (shap.background_rows == 0 && run_cfg.shap_validate && run_cfg.shap_validate_rows > 0) {
+					auto params = read_config_map(infer_cfg.string());
+					string header = config_get(params, { "header", "has_header" }, "false");
+					fs::path sample = fold_dir / "shap_muestra.txt";
+					fs::path contrib = fold_dir / "shap_lightgbm.txt";
+					fs::path contrib_cfg = fold_dir / "config_shap_contrib.txt";
+					{
+						ifstream in(config_get(params, CONFIG_DATA_KEYS));
+						ofstream out(sample);
+						string line;
+						bool skip_header = header == "true" || header == "1";
+						int rows = min(run_cfg.shap_validate_rows, static_cast<int>(shap.rows));
+						for (int written = 0; written < rows && getline(in, line);) {
+							// Las líneas vacías no son filas (el lector en proceso también las salta)
+							if (line.find_first_not_of(" \t\r") == string::npos) continue;
+							out << line << "\n";
+							if (skip_header) skip_header = false;
+							else ++written;
+						}
+						ofstream cfg(contrib_cfg);
+						cfg << "task=predict\ndata=" << sample.generic_string() << "\ninput_model=" << final_model.generic_string()
+							<< "\noutput_result=" << contrib.generic_string() << "\npredict_contrib=true\nheader=" << header << "\n";
+					}
+					if (run_child(run_id, lightgbm_path.string() + " config=" + contrib_cfg.string(), "lightgbm_predict_contrib") == 0) {
+						max_diff = compare_with_pred_contrib(shap, contrib);
+					}
+					if (max_diff < 0.0) {
+						cerr << YELLOW << "[WARN] No se pudo comparar con predict_contrib de LightGBM" << RESET << endl;
+					}
+					else {
+						printf("%s[SHAP] Diferencia maxima con predict_contrib de LightGBM: %.3g%s\n",
+							max_diff < 1e-4 ? GREEN : RED, max_diff, RESET);
+					}
+				}
+				insert_shap_summary_sqlite(run_id, hash_file_hex(final_model), shap, model.feature_names(), max_diff);
+			}
+			journal.finish("shap", ok);
+		}
+	}
+
+	if (run_cfg.predict_bench && fs::exists(final_model) && fs::exists(infer_cfg)) {
+		benchmark_predict_engines(ctx, final_model, infer_cfg, fold_dir / "pred_infer.txt");
+	}
+
 	const std::string pred_path = "folds/pred_infer.txt";
 	if (!fs::exists(pred_path) || fs::file_size(pred_path) == 0) {
 		std::cerr << "[ERROR] La prediccion no genero salida. Revisa el log anterior." << std::endl;
-		return 3;
+		return finish_run(3);
 	}
 
 	try {
@@ -328,15 +1478,15 @@ int main() {
 		string submission_script = (exe_path / "scripts" / "build_kaggle_submission.py").string();
 		if (!fs::exists(submission_script)) {
 			std::cout << "[WARN] No se encontró " << submission_script << " — se omite creación de submission.csv\n";
-			return 0;
+			return finish_run(0);
 		}
 		else
-			system(("python \"" + submission_script + "\"").c_str());
+			run_child(run_id, "python \"" + submission_script + "\"", "python_submission");
 	}
 	catch (...) {
 		std::cout << "[WARN] No se pudo ejecutar build_submission.py automáticamente. "
 			"Ejecuta: python build_submission.py\n";
 	}
 
-	return 0;
+	return finish_run(0);
 }
@@ -1,152 +1,247 @@
 #include "metrics.hpp"
+#include "trace.hpp"
 #include <iostream>
 #include <vector>
+#include <array>
 #include <algorithm>
+#include <type_traits>
+#include <cmath>
+
+namespace {
+	// Despacha k a una instanciacion con K fijo (2..10) o a la generica (K = 0)
+	template <typename F>
+	auto dispatch_classes(int k, F&& f) {
+		switch (k) {
+		case 2: return f(std::integral_constant<int, 2>{});
+		case 3: return f(std::integral_constant<int, 3>{});
+		case 4: return f(std::integral_constant<int, 4>{});
+		case 5: return f(std::integral_constant<int, 5>{});
+		case 6: return f(std::integral_constant<int, 6>{});
+		case 7: return f(std::integral_constant<int, 7>{});
+		case 8: return f(std::integral_constant<int, 8>{});
+		case 9: return f(std::integral_constant<int, 9>{});
+		case 10: return f(std::integral_constant<int, 10>{});
+		default: return f(std::integral_constant<int, 0>{});
+		}
+	}
 
-// Accuracy simple
-double accuracy(const std::vector<int>& y_true, const std::vector<int>& y_pred) {
-	int correct = 0;
-	for (size_t i = 0; i < y_true.size(); ++i)
-		if (y_true[i] == y_pred[i]) correct++;
-	return static_cast<double>(correct) / y_true.size();
-}
+	// Matriz de confusion plana k x k (fila = real, columna = predicha).
+	// Devuelve la cantidad de pares validos.
+	template <int K>
+	long long confusion_kernel(const std::vector<int>& y_true, const std::vector<int>& y_pred, int k_rt, long long* m) {
+		const int k = K > 0 ? K : k_rt;
+		std::fill(m, m + k * k, 0LL);
+		long long total = 0;
+		const size_t n = std::min(y_true.size(), y_pred.size());
+		for (size_t i = 0; i < n; ++i) {
+			unsigned t = static_cast<unsigned>(y_true[i]);
+			unsigned p = static_cast<unsigned>(y_pred[i]);
+			if (t < static_cast<unsigned>(k) && p < static_cast<unsigned>(k)) {
+				m[t * k + p]++;
+				total++;
+			}
+		}
+		return total;
+	}
 
-// F1 macro
-double f1_score_macro(const std::vector<int>& y_true, const std::vector<int>& y_pred) {
-	const int NUM_CLASSES = 5;
-	std::vector<int> tp(NUM_CLASSES, 0), fp(NUM_CLASSES, 0), fn(NUM_CLASSES, 0);
-
-	for (size_t i = 0; i < y_true.size(); ++i) {
-		int true_label = y_true[i];
-		int pred_label = y_pred[i];
-		if (true_label == pred_label)
-			tp[true_label]++;
+	// Construye la matriz (en pila si K es fijo) y aplica fn(m, total)
+	template <int K, typename Fn>
+	auto with_confusion(const std::vector<int>& y_true, const std::vector<int>& y_pred, int k, Fn&& fn) {
+		if constexpr (K > 0) {
+			std::array<long long, K * K> m;
+			long long total = confusion_kernel<K>(y_true, y_pred, k, m.data());
+			return fn(m.data(), total);
+		}
 		else {
-			fp[pred_label]++;
-			fn[true_label]++;
+			std::vector<long long> m(static_cast<size_t>(k) * k);
+			long long total = confusion_kernel<K>(y_true, y_pred, k, m.data());
+			return fn(m.data(), total);
 		}
 	}
 
-	double f1_total = 0.0;
-	for (int i = 0; i < NUM_CLASSES; ++i) {
-		double precision = tp[i] + fp[i] > 0 ? (double)tp[i] / (tp[i] + fp[i]) : 0.0;
-		double recall = tp[i] + fn[i] > 0 ? (double)tp[i] / (tp[i] + fn[i]) : 0.0;
-		double f1 = (precision + recall) > 0 ? 2 * precision * recall / (precision + recall) : 0.0;
-		f1_total += f1;
+	template <int K>
+	double f1_kernel(const long long* m, int k_rt) {
+		const int k = K > 0 ? K : k_rt;
+		double f1_total = 0.0;
+		for (int c = 0; c < k; ++c) {
+			long long tp = m[c * k + c], row = 0, col = 0;
+			for (int j = 0; j < k; ++j) {
+				row += m[c * k + j];
+				col += m[j * k + c];
+			}
+			long long fn = row - tp, fp = col - tp;
+			double precision = tp + fp > 0 ? (double)tp / (tp + fp) : 0.0;
+			double recall = tp + fn > 0 ? (double)tp / (tp + fn) : 0.0;
+			f1_total += (precision + recall) > 0 ? 2 * precision * recall / (precision + recall) : 0.0;
+		}
+		return f1_total / k;
 	}
-	return f1_total / NUM_CLASSES;
-}
 
-// Cohen's Kappa
-double cohen_kappa(const std::vector<int>& y_true, const std::vector<int>& y_pred, int num_classes) {
-	if (y_true.size() != y_pred.size() || y_true.empty()) return 0.0;
-
-	std::vector<std::vector<int>> confusion(num_classes, std::vector<int>(num_classes, 0));
-	std::vector<int> row_totals(num_classes, 0), col_totals(num_classes, 0);
-	int total = 0;
+	template <int K>
+	double cohen_kernel(const long long* m, long long total, int k_rt) {
+		const int k = K > 0 ? K : k_rt;
+		if (total == 0) return 0.0;
+
+		// Acuerdo observado (Po) y esperado (Pe)
+		double po = 0.0, pe = 0.0;
+		for (int i = 0; i < k; ++i) {
+			long long row = 0, col = 0;
+			for (int j = 0; j < k; ++j) {
+				row += m[i * k + j];
+				col += m[j * k + i];
+			}
+			po += m[i * k + i];
+			pe += static_cast<double>(row) * col;
+		}
+		po /= total;
+		pe /= static_cast<double>(total) * total;
+		return (pe < 1.0) ? (po - pe) / (1.0 - pe) : 0.0;
+	}
 
-	for (size_t i = 0; i < y_true.size(); ++i) {
-		int true_label = y_true[i];
-		int pred_label = y_pred[i];
+	// QWK = 1 - sum(W * O) / sum(W * E), W_ij = (i - j)^2 / (K - 1)^2, E = outer(hist_true, hist_pred) / N
+	template <int K>
+	double qwk_kernel(const long long* m, double n, int k_rt) {
+		const int k = K > 0 ? K : k_rt;
+		std::conditional_t<(K > 0), std::array<double, (K > 0 ? K : 1)>, std::vector<double>> hist_true{}, hist_pred{};
+		if constexpr (K == 0) {
+			hist_true.assign(k, 0.0);
+			hist_pred.assign(k, 0.0);
+		}
+		for (int i = 0; i < k; ++i) {
+			for (int j = 0; j < k; ++j) {
+				hist_true[i] += m[i * k + j];
+				hist_pred[j] += m[i * k + j];
+			}
+		}
 
-		// Validar que estn en rango
-		if (true_label < 0 || true_label >= num_classes || pred_label < 0 || pred_label >= num_classes)
-			continue;
+		const double denom_w = (k > 1) ? ((k - 1.0) * (k - 1.0)) : 1.0;
+		double sum_w_o = 0.0, sum_w_e = 0.0;
+		for (int i = 0; i < k; ++i) {
+			for (int j = 0; j < k; ++j) {
+				double diff = static_cast<double>(i - j);
+				double w = (diff * diff) / denom_w;
+				sum_w_o += w * m[i * k + j];
+				sum_w_e += w * (hist_true[i] * hist_pred[j]) / n;
+			}
+		}
 
-		confusion[true_label][pred_label]++;
-		row_totals[true_label]++;
-		col_totals[pred_label]++;
-		total++;
+		// Sin variacion esperada; evita division por cero
+		if (sum_w_e <= 0.0) return 0.0;
+		return 1.0 - (sum_w_o / sum_w_e);
 	}
+} // namespace
 
-	if (total == 0) return 0.0;
-
-	// Acuerdo observado (Po)
-	double po = 0.0;
-	for (int i = 0; i < num_classes; ++i)
-		po += confusion[i][i];
-	po /= total;
+// Accuracy simple
+double accuracy(const std::vector<int>& y_true, const std::vector<int>& y_pred) {
+	TraceSpan span("accuracy", "metricas");
+	int correct = 0;
+	for (size_t i = 0; i < y_true.size(); ++i)
+		if (y_true[i] == y_pred[i]) correct++;
+	return static_cast<double>(correct) / y_true.size();
+}
 
-	// Acuerdo esperado (Pe)
-	double pe = 0.0;
-	for (int i = 0; i < num_classes; ++i)
-		pe += static_cast<double>(row_totals[i]) * col_totals[i];
-	pe /= (total * total);
+// F1 macro
+double f1_score_macro(const std::vector<int>& y_true, const std::vector<int>& y_pred, int num_classes) {
+	TraceSpan span("f1_macro", "metricas");
+	if (num_classes <= 0) return 0.0;
+	return dispatch_classes(num_classes, [&](auto kc) {
+		constexpr int K = decltype(kc)::value;
+		return with_confusion<K>(y_true, y_pred, num_classes, [&](const long long* m, long long) {
+			return f1_kernel<K>(m, num_classes);
+		});
+	});
+}
 
-	return (pe < 1.0) ? (po - pe) / (1.0 - pe) : 0.0;
+// Cohen's Kappa
+double cohen_kappa(const std::vector<int>& y_true, const std::vector<int>& y_pred, int num_classes) {
+	if (y_true.size() != y_pred.size() || y_true.empty() || num_classes <= 0) return 0.0;
+	return dispatch_classes(num_classes, [&](auto kc) {
+		constexpr int K = decltype(kc)::value;
+		return with_confusion<K>(y_true, y_pred, num_classes, [&](const long long* m, long long total) {
+			return cohen_kernel<K>(m, total, num_classes);
+		});
+	});
 }
 
 // Quadratic Weighted Kappa
 double quadratic_weighted_kappa(const std::vector<int>& y_true, const std::vector<int>& y_pred, int num_classes) {
-	if (y_true.size() != y_pred.size() || y_true.empty()) return 0.0;
-
-	const int N = static_cast<int>(y_true.size());
-
-	// Matriz de confusin O (observada)
-	std::vector<std::vector<double>> O(num_classes, std::vector<double>(num_classes, 0.0));
-	// Histogramas por clase
-	std::vector<double> hist_true(num_classes, 0.0), hist_pred(num_classes, 0.0);
-
-	for (size_t i = 0; i < y_true.size(); ++i) {
-		int t = y_true[i];
-		int p = y_pred[i];
-		if (t >= 0 && t < num_classes && p >= 0 && p < num_classes) {
-			O[t][p] += 1.0;
-			hist_true[t] += 1.0;
-			hist_pred[p] += 1.0;
-		}
-	}
+	TraceSpan span("kappa_cuadratico", "metricas");
+	if (y_true.size() != y_pred.size() || y_true.empty() || num_classes <= 0) return 0.0;
+	const double n = static_cast<double>(y_true.size());
+	return dispatch_classes(num_classes, [&](auto kc) {
+		constexpr int K = decltype(kc)::value;
+		return with_confusion<K>(y_true, y_pred, num_classes, [&](const long long* m, long long) {
+			return qwk_kernel<K>(m, n, num_classes);
+		});
+	});
+}
 
-	// Matriz de pesos W_ij = (i - j)^2 / (K - 1)^2
-	const double denom_w = (num_classes > 1) ? ((num_classes - 1.0) * (num_classes - 1.0)) : 1.0;
-	std::vector<std::vector<double>> W(num_classes, std::vector<double>(num_classes, 0.0));
-	for (int i = 0; i < num_classes; ++i) {
-		for (int j = 0; j < num_classes; ++j) {
-			double diff = static_cast<double>(i - j);
-			W[i][j] = (diff * diff) / denom_w;
-		}
-	}
+// Matriz de confusion (fila = real, columna = predicha)
+std::vector<std::vector<int>> confusion_matrix(const std::vector<int>& y_true, const std::vector<int>& y_pred, int num_classes) {
+	std::vector<std::vector<int>> matrix(num_classes, std::vector<int>(num_classes, 0));
+	if (num_classes <= 0) return matrix;
+	dispatch_classes(num_classes, [&](auto kc) {
+		constexpr int K = decltype(kc)::value;
+		return with_confusion<K>(y_true, y_pred, num_classes, [&](const long long* m, long long) {
+			for (int i = 0; i < num_classes; ++i)
+				for (int j = 0; j < num_classes; ++j)
+					matrix[i][j] = static_cast<int>(m[i * num_classes + j]);
+			return 0;
+		});
+	});
+	return matrix;
+}
 
-	// Matriz esperada E = outer(hist_true, hist_pred) / N
-	std::vector<std::vector<double>> E(num_classes, std::vector<double>(num_classes, 0.0));
-	for (int i = 0; i < num_classes; ++i) {
-		for (int j = 0; j < num_classes; ++j) {
-			E[i][j] = (hist_true[i] * hist_pred[j]) / static_cast<double>(N);
+// Metricas desde una matriz ya armada (mismos kernels que desde y_true/y_pred)
+ConfusionMetrics metrics_from_confusion(const std::vector<std::vector<int>>& matrix) {
+	ConfusionMetrics out;
+	const int k = static_cast<int>(matrix.size());
+	if (k <= 0) return out;
+	std::vector<long long> m(static_cast<size_t>(k) * k, 0);
+	long long total = 0, correct = 0;
+	for (int i = 0; i < k; ++i) {
+		for (int j = 0; j < k && j < static_cast<int>(matrix[i].size()); ++j) {
+			m[i * k + j] = matrix[i][j];
+			total += matrix[i][j];
 		}
+		correct += m[i * k + i];
 	}
+	if (total == 0) return out;
+	out.accuracy = static_cast<double>(correct) / total;
+	dispatch_classes(k, [&](auto kc) {
+		constexpr int K = decltype(kc)::value;
+		out.f1_macro = f1_kernel<K>(m.data(), k);
+		out.kappa = qwk_kernel<K>(m.data(), static_cast<double>(total), k);
+		return 0;
+	});
+	return out;
+}
 
-	// Sumas ponderadas
-	double sum_w_o = 0.0;
-	double sum_w_e = 0.0;
+// Imprimir matriz de confusion
+void print_confusion_matrix(const std::vector<int>& y_true, const std::vector<int>& y_pred, int num_classes) {
+	std::vector<std::vector<int>> matrix = confusion_matrix(y_true, y_pred, num_classes);
+	std::cout << "\nMatriz de confusion:\n";
 	for (int i = 0; i < num_classes; ++i) {
 		for (int j = 0; j < num_classes; ++j) {
-			sum_w_o += W[i][j] * O[i][j];
-			sum_w_e += W[i][j] * E[i][j];
+			std::cout << matrix[i][j] << "\t";
 		}
+		std::cout << std::endl;
 	}
-
-	if (sum_w_e <= 0.0) {
-		// Sin variacin esperada; evita divisin por cero
-		return 0.0;
-	}
-
-	// QWK = 1 - (sum(W * O) / sum(W * E))
-	double kappa = 1.0 - (sum_w_o / sum_w_e);
-	return kappa;
 }
 
-// Imprimir matriz de confusin
-void print_confusion_matrix(const std::vector<int>& y_true, const std::vector<int>& y_pred) {
-	const int NUM_CLASSES = 5;
-	std::vector<std::vector<int>> matrix(NUM_CLASSES, std::vector<int>(NUM_CLASSES, 0));
-	for (size_t i = 0; i < y_true.size(); ++i) {
-		matrix[y_true[i]][y_pred[i]]++;
-	}
-	std::cout << "\nMatriz de confusion:\n";
-	for (int i = 0; i < NUM_CLASSES; ++i) {
-		for (int j = 0; j < NUM_CLASSES; ++j) {
-			std::cout << matrix[i][j] << "\t";
-		}
-		std::cout << std::endl;
+// Resumen de una metrica sobre varias corridas
+MetricSummary summarize_metric(const std::vector<double>& values) {
+	MetricSummary s;
+	s.n = static_cast<int>(values.size());
+	if (values.empty()) return s;
+	s.min = *std::min_element(values.begin(), values.end());
+	s.max = *std::max_element(values.begin(), values.end());
+	for (double v : values) s.mean += v;
+	s.mean /= s.n;
+	if (s.n > 1) {
+		double ss = 0.0;
+		for (double v : values) ss += (v - s.mean) * (v - s.mean);
+		s.stddev = std::sqrt(ss / (s.n - 1));
 	}
+	return s;
 }
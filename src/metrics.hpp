@@ -1,12 +1,40 @@
 #pragma once
 #include <vector>
 
+// Las metricas que dependen de la cantidad de clases se despachan en tiempo de
+// ejecucion a kernels especializados para 2..10 clases (matriz en pila y bucles
+// desenrollados por el compilador); otros tamanos usan la version generica.
+// Las etiquetas fuera de [0, num_classes) se descartan.
+
 double accuracy(const std::vector<int>& y_true, const std::vector<int>& y_pred);
 
-double f1_score_macro(const std::vector<int>& y_true, const std::vector<int>& y_pred);
+double f1_score_macro(const std::vector<int>& y_true, const std::vector<int>& y_pred, int num_classes = 5);
 
 double cohen_kappa(const std::vector<int>& y_true, const std::vector<int>& y_pred, int num_classes = 5);
 
 double quadratic_weighted_kappa(const std::vector<int>& y_true, const std::vector<int>& y_pred, int num_classes = 5);
 
-void print_confusion_matrix(const std::vector<int>& y_true, const std::vector<int>& y_pred);
+std::vector<std::vector<int>> confusion_matrix(const std::vector<int>& y_true, const std::vector<int>& y_pred, int num_classes = 5);
+
+void print_confusion_matrix(const std::vector<int>& y_true, const std::vector<int>& y_pred, int num_classes = 5);
+
+// Accuracy, F1 macro y Kappa cuadratico de una matriz de confusion ya armada
+// (ej. acumulada fila a fila mientras se leen las predicciones de la FIFO)
+struct ConfusionMetrics {
+	double accuracy = 0.0;
+	double f1_macro = 0.0;
+	double kappa = 0.0;
+};
+
+ConfusionMetrics metrics_from_confusion(const std::vector<std::vector<int>>& matrix);
+
+// Media, desvio estandar muestral, minimo y maximo de una metrica (folds, repeticiones, semillas)
+struct MetricSummary {
+	int n = 0;
+	double mean = 0.0;
+	double stddev = 0.0;
+	double min = 0.0;
+	double max = 0.0;
+};
+
+MetricSummary summarize_metric(const std::vector<double>& values);
@@ -0,0 +1,280 @@
+#include "model_registry.hpp"
+#include "database.hpp"
+#include "hashing.hpp"
+#include "io_utils.hpp"
+#include "trace.hpp"
+
+#include <sqlite3.h>
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define YELLOW  "\033[33m"
+#define MAGENTA "\033[35m"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	const fs::path REGISTRY_ROOT = "modelos";
+
+	string now_text() {
+		time_t now = time(0);
+		string fecha = string(ctime(&now));
+		fecha.pop_back(); // quitar salto de línea
+		return fecha;
+	}
+
+	// Nombres de archivo que usaban las versiones anteriores (se mantienen como links)
+	const char* legacy_name(const string& alias) {
+		if (alias == "best_f1") return "best_model.txt";
+		if (alias == "best_kappa") return "mejor_modelo_kappa.txt";
+		if (alias == "final") return "modelo_final.txt";
+		return nullptr;
+	}
+
+	// link -> target de forma atómica: hard link (o symlink) temporal + rename.
+	// Sólo si el sistema de archivos no soporta links se cae a una copia.
+	bool link_atomic(const fs::path& target, const fs::path& link) {
+		std::error_code ec;
+		fs::path tmp = link;
+		tmp += ".tmp";
+		fs::remove(tmp, ec);
+		fs::create_hard_link(target, tmp, ec);
+		if (ec) {
+			ec.clear();
+			fs::create_symlink(fs::absolute(target), tmp, ec);
+		}
+		if (ec) {
+			ec.clear();
+			fs::copy_file(target, tmp, fs::copy_options::overwrite_existing, ec);
+			if (ec) return false;
+		}
+		fs::rename(tmp, link, ec);
+		if (ec) {
+			cerr << YELLOW << "[WARN] No se pudo actualizar " << link.string() << ": " << ec.message() << RESET << endl;
+			fs::remove(tmp, ec);
+			return false;
+		}
+		return true;
+	}
+
+	// Mismo tamaño y mismos bytes
+	bool same_content(const fs::path& a, const fs::path& b) {
+		std::error_code ec_a, ec_b;
+		if (fs::file_size(a, ec_a) != fs::file_size(b, ec_b) || ec_a || ec_b) return false;
+		ifstream fa(a, ios::binary), fb(b, ios::binary);
+		if (!fa || !fb) return false;
+		vector<char> ba(1 << 16), bb(1 << 16);
+		while (fa && fb) {
+			fa.read(ba.data(), ba.size());
+			fb.read(bb.data(), bb.size());
+			if (fa.gcount() != fb.gcount() || !equal(ba.begin(), ba.begin() + fa.gcount(), bb.begin())) return false;
+		}
+		return fa.eof() && fb.eof();
+	}
+
+	// Objeto nuevo: hard link al modelo (sin copiar) o copia si el sistema de
+	// archivos no lo permite; temporal + rename para que nunca quede a medias.
+	// LightGBM reescribe el modelo de origen en la próxima corrida, por eso
+	// run_lightgbm borra las salidas antes de lanzarlo y el link no se toca.
+	bool store_object(const fs::path& model_path, const fs::path& object) {
+		std::error_code ec;
+		fs::path tmp = object;
+		tmp += ".tmp";
+		fs::remove(tmp, ec);
+		fs::create_hard_link(model_path, tmp, ec);
+		if (ec) {
+			ec.clear();
+			fs::copy_file(model_path, tmp, fs::copy_options::overwrite_existing, ec);
+		}
+		if (!ec) fs::rename(tmp, object, ec);
+		if (ec) {
+			cerr << YELLOW << "[WARN] No se pudo guardar " << object.string() << ": " << ec.message() << RESET << endl;
+			fs::remove(tmp, ec);
+			return false;
+		}
+		return true;
+	}
+
+	sqlite3* open_registry(const string& db_path) {
+		sqlite3* db;
+		if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
+			cerr << "No se puede abrir la base de datos: " << sqlite3_errmsg(db) << endl;
+			sqlite3_close(db);
+			return nullptr;
+		}
+		sqlite3_busy_timeout(db, 5000);
+		const char* create_sql =
+			"CREATE TABLE IF NOT EXISTS modelos_objetos ("
+			"hash TEXT PRIMARY KEY, ruta TEXT, bytes INTEGER, creado TEXT);"
+			"CREATE TABLE IF NOT EXISTS linaje_modelos ("
+			"id INTEGER PRIMARY KEY AUTOINCREMENT, hash TEXT, fecha TEXT, run_id TEXT, id_resultado INTEGER, "
+			"modelo_origen TEXT, config TEXT, config_hash TEXT, data_hash TEXT, "
+			"accuracy REAL, f1_macro REAL, kappa REAL);"
+			"CREATE INDEX IF NOT EXISTS idx_linaje_hash ON linaje_modelos (hash);"
+			"CREATE TABLE IF NOT EXISTS mejor_modelo ("
+			"id INTEGER PRIMARY KEY, modelo TEXT, id_resultado INTEGER, es_final INTEGER DEFAULT 0, configuracion TEXT);";
+		sqlite3_exec(db, create_sql, nullptr, nullptr, nullptr);
+		// mejor_modelo pasa de una sola fila (id = 1) a historial de promociones
+		ensure_column(db, "mejor_modelo", "alias", "TEXT");
+		ensure_column(db, "mejor_modelo", "hash", "TEXT");
+		ensure_column(db, "mejor_modelo", "hash_anterior", "TEXT");
+		ensure_column(db, "mejor_modelo", "run_id", "TEXT");
+		ensure_column(db, "mejor_modelo", "fecha", "TEXT");
+		return db;
+	}
+
+	void bind_metric(sqlite3_stmt* stmt, int index, double value) {
+		if (value < 0.0) sqlite3_bind_null(stmt, index);
+		else sqlite3_bind_double(stmt, index, value);
+	}
+} // namespace
+
+fs::path registry_object_path(const string& hash) {
+	return REGISTRY_ROOT / "objects" / (hash + ".txt");
+}
+
+fs::path registry_alias_path(const string& alias) {
+	return REGISTRY_ROOT / (alias + ".txt");
+}
+
+string registry_store_model(const string& model_path, const ModelLineage& lineage, const string& db_path) {
+	TraceSpan span("registro_guardar_modelo", "registro");
+	string hash = sha256_file_hex(model_path);
+	if (hash.empty()) {
+		cerr << YELLOW << "[WARN] No se pudo leer el modelo " << model_path << " para el registro" << RESET << endl;
+		return string();
+	}
+
+	// Única copia del modelo: sólo si el contenido es nuevo. Un objeto existente se
+	// compara byte a byte antes de reutilizarlo; si difiere (objeto dañado) se reemplaza
+	fs::path object = registry_object_path(hash);
+	std::error_code ec;
+	bool present = fs::exists(object);
+	if (present && !same_content(model_path, object)) {
+		cerr << YELLOW << "[WARN] El objeto " << object.string() << " no coincide con " << model_path
+			<< "; se reemplaza" << RESET << endl;
+		present = false;
+	}
+	if (!present) {
+		fs::create_directories(object.parent_path(), ec);
+		if (!store_object(model_path, object)) return string();
+	}
+
+	// Linaje: hash del config y del dataset de entrenamiento que referencia
+	string config_hash, data_hash;
+	if (!lineage.config_path.empty()) {
+		config_hash = hash_file_hex(lineage.config_path);
+		string data = config_get(read_config_map(lineage.config_path), CONFIG_DATA_KEYS);
+		if (!data.empty()) data_hash = hash_file_hex(data);
+	}
+
+	sqlite3* db = open_registry(db_path);
+	if (!db) return hash;
+	sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr);
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO modelos_objetos (hash, ruta, bytes, creado) VALUES (?, ?, ?, ?);",
+		-1, &stmt, nullptr) == SQLITE_OK) {
+		string fecha = now_text();
+		sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, object.generic_string().c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(fs::file_size(object, ec)));
+		sqlite3_bind_text(stmt, 4, fecha.c_str(), -1, SQLITE_STATIC);
+		sqlite3_step(stmt);
+		sqlite3_finalize(stmt);
+	}
+	if (sqlite3_prepare_v2(db, "INSERT INTO linaje_modelos (hash, fecha, run_id, id_resultado, modelo_origen, config, "
+		"config_hash, data_hash, accuracy, f1_macro, kappa) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);",
+		-1, &stmt, nullptr) == SQLITE_OK) {
+		string fecha = now_text();
+		sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 3, lineage.run_id.c_str(), -1, SQLITE_STATIC);
+		if (lineage.id_resultado >= 0) sqlite3_bind_int(stmt, 4, lineage.id_resultado);
+		else sqlite3_bind_null(stmt, 4);
+		sqlite3_bind_text(stmt, 5, model_path.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 6, lineage.config_path.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 7, config_hash.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 8, data_hash.c_str(), -1, SQLITE_STATIC);
+		bind_metric(stmt, 9, lineage.accuracy);
+		bind_metric(stmt, 10, lineage.f1_macro);
+		bind_metric(stmt, 11, lineage.kappa);
+		sqlite3_step(stmt);
+		sqlite3_finalize(stmt);
+	}
+	if (lineage.id_resultado >= 0) {
+		ensure_column(db, "resultados", "modelo_hash", "TEXT");
+		if (sqlite3_prepare_v2(db, "UPDATE resultados SET modelo_hash = ? WHERE id = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+			sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int(stmt, 2, lineage.id_resultado);
+			sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+		}
+	}
+	sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+	sqlite3_close(db);
+	return hash;
+}
+
+string registry_alias_hash(const string& alias, const string& db_path) {
+	sqlite3* db = open_registry(db_path);
+	if (!db) return string();
+	string hash;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "SELECT hash FROM mejor_modelo WHERE alias = ? ORDER BY id DESC LIMIT 1;",
+		-1, &stmt, nullptr) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, alias.c_str(), -1, SQLITE_STATIC);
+		if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0)) {
+			hash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+		}
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+	return hash;
+}
+
+bool registry_promote(const string& alias, const string& hash, const ModelLineage& lineage, const string& db_path) {
+	TraceSpan span("registro_promover", "registro");
+	fs::path object = registry_object_path(hash);
+	if (hash.empty() || !fs::exists(object)) {
+		cerr << YELLOW << "[WARN] No se puede promover " << alias << ": objeto " << hash << " inexistente" << RESET << endl;
+		return false;
+	}
+	string previous = registry_alias_hash(alias, db_path);
+	if (previous == hash && fs::exists(registry_alias_path(alias))) return true;
+
+	if (!link_atomic(object, registry_alias_path(alias))) return false;
+	if (const char* legacy = legacy_name(alias)) link_atomic(object, legacy);
+
+	sqlite3* db = open_registry(db_path);
+	if (!db) return false;
+	bool ok = false;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db, "INSERT INTO mejor_modelo (modelo, id_resultado, es_final, configuracion, alias, hash, "
+		"hash_anterior, run_id, fecha) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);", -1, &stmt, nullptr) == SQLITE_OK) {
+		string fecha = now_text();
+		string object_str = object.generic_string();
+		sqlite3_bind_text(stmt, 1, object_str.c_str(), -1, SQLITE_STATIC);
+		if (lineage.id_resultado >= 0) sqlite3_bind_int(stmt, 2, lineage.id_resultado);
+		else sqlite3_bind_null(stmt, 2);
+		sqlite3_bind_int(stmt, 3, alias == "final" || alias == "production" ? 1 : 0);
+		sqlite3_bind_text(stmt, 4, lineage.config_path.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 5, alias.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 6, hash.c_str(), -1, SQLITE_STATIC);
+		if (previous.empty()) sqlite3_bind_null(stmt, 7);
+		else sqlite3_bind_text(stmt, 7, previous.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 8, lineage.run_id.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 9, fecha.c_str(), -1, SQLITE_STATIC);
+		ok = sqlite3_step(stmt) == SQLITE_DONE;
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+	cout << MAGENTA << "[REGISTRO] " << alias << " -> " << hash
+		<< (previous.empty() ? "" : " (antes " + previous + ")") << RESET << endl;
+	return ok;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <filesystem>
+#include <string>
+
+// Registro de modelos direccionado por contenido (carpeta modelos/):
+//   modelos/objects/<hash>.txt   cada modelo se guarda una sola vez, por hash de contenido
+//   modelos/<alias>.txt          best_f1, best_kappa, final, production: hard link al objeto
+// Promover un alias crea un link temporal y lo renombra sobre el anterior, así
+// el cambio es atómico y no copia el modelo. Tablas en resultados.db:
+//   modelos_objetos   hash, ruta y tamaño de cada objeto
+//   linaje_modelos    de dónde salió cada modelo: corrida, config, hash de config y datos, métricas
+//   mejor_modelo      historial de promociones de cada alias
+
+// Origen y métricas de un modelo (métricas < 0 = no disponibles)
+struct ModelLineage {
+	std::string run_id;
+	int id_resultado = -1;
+	std::string config_path;
+	double accuracy = -1.0;
+	double f1_macro = -1.0;
+	double kappa = -1.0;
+};
+
+// Guarda el modelo en el registro (si el contenido ya existía no se vuelve a copiar)
+// y registra su linaje; si id_resultado >= 0 anota el hash en resultados.modelo_hash.
+// Devuelve el hash o "" si no se pudo leer el modelo.
+std::string registry_store_model(const std::string& model_path, const ModelLineage& lineage,
+	const std::string& db_path = "resultados.db");
+
+// Apunta el alias al objeto con ese hash y agrega la promoción al historial.
+// No hace nada si el alias ya apuntaba a ese hash.
+bool registry_promote(const std::string& alias, const std::string& hash, const ModelLineage& lineage,
+	const std::string& db_path = "resultados.db");
+
+// Hash al que apunta hoy el alias ("" si nunca se promovió)
+std::string registry_alias_hash(const std::string& alias, const std::string& db_path = "resultados.db");
+
+std::filesystem::path registry_object_path(const std::string& hash);
+
+std::filesystem::path registry_alias_path(const std::string& alias);
@@ -0,0 +1,155 @@
+#include "multi_seed.hpp"
+#include "io_utils.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define YELLOW  "\033[33m"
+#define CYAN    "\033[36m"
+#define BOLD    "\033[1m"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	void print_row(const string& label, const MetricSummary& acc, const MetricSummary& f1, const MetricSummary& kappa,
+		const SeedScore* ensemble) {
+		printf("%-12s %3d  %.4f±%.4f  %.4f±%.4f  %.4f±%.4f  [%.4f, %.4f]", label.c_str(), kappa.n,
+			acc.mean, acc.stddev, f1.mean, f1.stddev, kappa.mean, kappa.stddev, kappa.min, kappa.max);
+		if (ensemble) printf("  %.4f", ensemble->kappa);
+		printf("\n");
+	}
+} // namespace
+
+SeedVariant write_seed_variant(const SeedJob& job, const fs::path& dir, int seed, int threads) {
+	SeedVariant v;
+	std::error_code ec;
+	fs::create_directories(dir, ec);
+	v.config_train = dir / ("config_train_" + job.tag + ".txt");
+	v.config_pred = dir / ("config_pred_" + job.tag + ".txt");
+	v.model = dir / ("model_" + job.tag + ".txt");
+	v.predictions = dir / ("predictions_" + job.tag + ".txt");
+	string s = to_string(seed);
+	vector<ConfigOverride> train = {
+		{ { "seed", "random_seed", "random_state" }, s },
+		{ { "bagging_seed", "bagging_fraction_seed" }, s },
+		{ { "feature_fraction_seed" }, s },
+		{ CONFIG_OUTPUT_MODEL_KEYS, v.model.generic_string() },
+	};
+	vector<ConfigOverride> pred = {
+		{ CONFIG_INPUT_MODEL_KEYS, v.model.generic_string() },
+		{ CONFIG_RESULT_KEYS, v.predictions.generic_string() },
+	};
+	if (threads > 0) {
+		train.push_back({ CONFIG_THREAD_KEYS, to_string(threads) });
+		pred.push_back({ CONFIG_THREAD_KEYS, to_string(threads) });
+	}
+	v.ok = write_config_overrides(job.config_train, v.config_train, train)
+		&& write_config_overrides(job.config_pred, v.config_pred, pred);
+	return v;
+}
+
+int seed_threads_per_job(int thread_budget, int max_parallel_jobs) {
+	int budget = thread_budget > 0 ? thread_budget : static_cast<int>(thread::hardware_concurrency());
+	return max(1, budget / max(1, max_parallel_jobs));
+}
+
+vector<double> average_probabilities(const vector<const vector<double>*>& members) {
+	if (members.empty()) return {};
+	size_t size = members.front()->size();
+	for (const vector<double>* m : members) {
+		if (m->size() != size) return {};
+	}
+	vector<double> avg(size, 0.0);
+	for (const vector<double>* m : members) {
+		for (size_t i = 0; i < size; ++i) avg[i] += (*m)[i];
+	}
+	double scale = 1.0 / members.size();
+	for (double& v : avg) v *= scale;
+	return avg;
+}
+
+bool save_probabilities(const fs::path& path, const vector<double>& probs, int num_classes) {
+	TraceSpan span("guardar_probabilidades", "io");
+	std::error_code ec;
+	if (path.has_parent_path()) fs::create_directories(path.parent_path(), ec);
+	ofstream out(path);
+	if (!out || num_classes <= 0) return false;
+	char buf[32];
+	for (size_t i = 0; i < probs.size(); ++i) {
+		snprintf(buf, sizeof(buf), "%.17g", probs[i]);
+		out << buf << ((i + 1) % num_classes == 0 ? "\n" : "\t");
+	}
+	return static_cast<bool>(out);
+}
+
+void print_seed_summary(const vector<SeedScore>& scores, const vector<SeedScore>& ensemble, const vector<int>& seeds) {
+	cout << CYAN << BOLD << "\n==== RESULTADOS POR SEMILLA (" << seeds.size() << " semillas) ====" << RESET << endl;
+	printf("%-12s %3s  %-13s  %-13s  %-13s  %-16s%s\n", "trabajo", "n", "accuracy", "f1 macro", "kappa", "kappa [min, max]",
+		ensemble.empty() ? "" : "  ensemble");
+
+	// Por trabajo, en el orden en que aparecen
+	vector<string> tags;
+	map<string, vector<const SeedScore*>> by_tag;
+	for (const SeedScore& s : scores) {
+		if (by_tag[s.tag].empty()) tags.push_back(s.tag);
+		by_tag[s.tag].push_back(&s);
+	}
+	auto summarize = [](const vector<const SeedScore*>& rows, double SeedScore::* field) {
+		vector<double> values;
+		for (const SeedScore* r : rows) values.push_back(r->*field);
+		return summarize_metric(values);
+	};
+	for (const string& tag : tags) {
+		const auto& rows = by_tag[tag];
+		const SeedScore* ens = nullptr;
+		for (const SeedScore& e : ensemble) {
+			if (e.tag == tag) ens = &e;
+		}
+		print_row(tag, summarize(rows, &SeedScore::accuracy), summarize(rows, &SeedScore::f1_macro),
+			summarize(rows, &SeedScore::kappa), ens);
+	}
+
+	// Global: todos los pares (semilla, fold) y, aparte, la media de folds de cada semilla,
+	// que es lo que cambia entre corridas completas con distinta semilla
+	vector<const SeedScore*> folds;
+	map<int, vector<double>> seed_kappa;
+	for (const SeedScore& s : scores) {
+		if (s.fold < 0) continue;
+		folds.push_back(&s);
+		seed_kappa[s.seed].push_back(s.kappa);
+	}
+	if (folds.empty()) return;
+	MetricSummary kappa = summarize(folds, &SeedScore::kappa);
+	cout << YELLOW << "\nFolds x semillas (n=" << kappa.n << "): accuracy " << summarize(folds, &SeedScore::accuracy).mean
+		<< " | F1 macro " << summarize(folds, &SeedScore::f1_macro).mean << " | Kappa " << kappa.mean
+		<< " (desvio " << kappa.stddev << ", min " << kappa.min << ", max " << kappa.max << ")" << RESET << endl;
+	vector<double> seed_means;
+	for (int seed : seeds) {
+		if (seed_kappa[seed].empty()) continue;
+		MetricSummary s = summarize_metric(seed_kappa[seed]);
+		seed_means.push_back(s.mean);
+		cout << "  Semilla " << seed << ": Kappa medio " << s.mean << " (desvio " << s.stddev << ", n=" << s.n << ")" << endl;
+	}
+	MetricSummary between = summarize_metric(seed_means);
+	cout << YELLOW << "Kappa entre semillas: media " << between.mean << " | desvio " << between.stddev
+		<< " | min " << between.min << " | max " << between.max << RESET << endl;
+	vector<double> ens_kappa;
+	for (const SeedScore& e : ensemble) {
+		if (e.fold >= 0) ens_kappa.push_back(e.kappa);
+	}
+	if (!ens_kappa.empty()) {
+		MetricSummary ens = summarize_metric(ens_kappa);
+		cout << YELLOW << "Ensemble de semillas: Kappa medio " << ens.mean << " (desvio " << ens.stddev << ", n=" << ens.n
+			<< ")" << RESET << endl;
+	}
+}
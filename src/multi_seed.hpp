@@ -0,0 +1,60 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Evaluación multi-semilla (seeds=11,23,42 o --seeds 11,23,42): cada fold y el
+// holdout se entrenan una vez por semilla con variantes de sus configs en
+// folds/semillas/seed_<s>/ (seed, bagging_seed y feature_fraction_seed = s).
+// Las variantes corren en paralelo bajo el scheduler y reparten un presupuesto
+// de hilos; se reporta media/desvío/mín/máx de cada métrica por fold y en total
+// y, opcionalmente, el ensemble que promedia las probabilidades de las semillas.
+
+// Un fold (o el holdout, fold = -1) con sus configs originales
+struct SeedJob {
+	std::string tag;              // "fold_3", "r1_fold_3" o "holdout"
+	int repeat = 0;
+	int fold = -1;
+	std::filesystem::path config_train;
+	std::filesystem::path config_pred;
+	std::filesystem::path labels;
+};
+
+// Configs derivados de un trabajo para una semilla
+struct SeedVariant {
+	bool ok = false;
+	std::filesystem::path config_train;
+	std::filesystem::path config_pred;
+	std::filesystem::path model;
+	std::filesystem::path predictions;
+};
+
+// Escribe en dir los configs de la semilla: el de entrenamiento con las semillas,
+// num_threads = threads y output_model en dir; el de predicción con input_model
+// apuntando a ese modelo y output_result en dir
+SeedVariant write_seed_variant(const SeedJob& job, const std::filesystem::path& dir, int seed, int threads);
+
+// Hilos por proceso LightGBM para que max_parallel_jobs procesos simultáneos no
+// superen el presupuesto (0 = hardware_concurrency)
+int seed_threads_per_job(int thread_budget, int max_parallel_jobs);
+
+// Métricas de un trabajo con una semilla; seed = -1: ensemble de semillas
+struct SeedScore {
+	int seed = -1;
+	int repeat = 0;
+	int fold = -1;                // -1 = holdout
+	std::string tag;
+	double accuracy = 0.0;
+	double f1_macro = 0.0;
+	double kappa = 0.0;
+};
+
+// Promedio fila a fila de probabilidades con la misma forma; vacío si no coinciden
+std::vector<double> average_probabilities(const std::vector<const std::vector<double>*>& members);
+
+// Probabilidades en el formato de output_result de LightGBM (una fila por línea, tabuladas)
+bool save_probabilities(const std::filesystem::path& path, const std::vector<double>& probs, int num_classes);
+
+// Tabla por fold (media ± desvío, mín, máx entre semillas y ensemble) y resumen global
+void print_seed_summary(const std::vector<SeedScore>& scores, const std::vector<SeedScore>& ensemble,
+	const std::vector<int>& seeds);
@@ -0,0 +1,78 @@
+#include "oof_store.hpp"
+#include "trace.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	const char OOF_MAGIC[4] = { 'O', 'O', 'F', '1' };
+}
+
+void OofBuilder::add_fold(const vector<int64_t>& indices, const vector<int>& labels, const vector<double>& probs) {
+	for (size_t i = 0; i < indices.size(); ++i) {
+		if (labels[i] < 0 || labels[i] >= num_classes_) continue;
+		Entry& e = rows_[indices[i]];
+		if (e.sum.empty()) e.sum.assign(num_classes_, 0.0);
+		e.label = labels[i];
+		e.count++;
+		for (int c = 0; c < num_classes_; ++c) e.sum[c] += probs[i * num_classes_ + c];
+	}
+}
+
+OofMatrix OofBuilder::build() const {
+	OofMatrix oof;
+	oof.num_classes = num_classes_;
+	oof.row_index.reserve(rows_.size());
+	oof.labels.reserve(rows_.size());
+	oof.probs.reserve(rows_.size() * num_classes_);
+	for (const auto& [index, e] : rows_) {
+		oof.row_index.push_back(index);
+		oof.labels.push_back(e.label);
+		for (int c = 0; c < num_classes_; ++c) oof.probs.push_back(static_cast<float>(e.sum[c] / e.count));
+	}
+	return oof;
+}
+
+bool save_oof_binary(const fs::path& path, const OofMatrix& oof) {
+	TraceSpan span("guardar_oof", "io");
+	ofstream out(path, ios::binary);
+	if (!out) {
+		cerr << "No se pudo escribir " << path.string() << endl;
+		return false;
+	}
+	uint32_t classes = static_cast<uint32_t>(oof.num_classes);
+	uint64_t rows = oof.rows();
+	out.write(OOF_MAGIC, sizeof(OOF_MAGIC));
+	out.write(reinterpret_cast<const char*>(&classes), sizeof(classes));
+	out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+	out.write(reinterpret_cast<const char*>(oof.row_index.data()), rows * sizeof(int64_t));
+	vector<int32_t> labels(oof.labels.begin(), oof.labels.end());
+	out.write(reinterpret_cast<const char*>(labels.data()), rows * sizeof(int32_t));
+	out.write(reinterpret_cast<const char*>(oof.probs.data()), oof.probs.size() * sizeof(float));
+	return static_cast<bool>(out);
+}
+
+bool load_oof_binary(const fs::path& path, OofMatrix& oof) {
+	TraceSpan span("leer_oof", "io");
+	ifstream in(path, ios::binary);
+	char magic[4];
+	uint32_t classes = 0;
+	uint64_t rows = 0;
+	if (!in.read(magic, sizeof(magic)) || memcmp(magic, OOF_MAGIC, sizeof(magic)) != 0) return false;
+	if (!in.read(reinterpret_cast<char*>(&classes), sizeof(classes))) return false;
+	if (!in.read(reinterpret_cast<char*>(&rows), sizeof(rows))) return false;
+
+	oof.num_classes = static_cast<int>(classes);
+	oof.row_index.resize(rows);
+	vector<int32_t> labels(rows);
+	oof.probs.resize(rows * classes);
+	in.read(reinterpret_cast<char*>(oof.row_index.data()), rows * sizeof(int64_t));
+	in.read(reinterpret_cast<char*>(labels.data()), rows * sizeof(int32_t));
+	in.read(reinterpret_cast<char*>(oof.probs.data()), oof.probs.size() * sizeof(float));
+	oof.labels.assign(labels.begin(), labels.end());
+	return static_cast<bool>(in);
+}
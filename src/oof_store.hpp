@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <vector>
+
+// Matriz out-of-fold (OOF): probabilidades de cada fila del train predichas por el
+// modelo del fold que NO la vio, indexadas por el índice original de la fila.
+// Se guarda en binario compacto (oof_probabilidades.bin):
+//   "OOF1" | uint32 clases | uint64 filas | int64 índice[filas] | int32 etiqueta[filas] | float prob[filas x clases]
+struct OofMatrix {
+	int num_classes = 0;
+	std::vector<int64_t> row_index;
+	std::vector<int> labels;
+	std::vector<float> probs;   // contiguo, fila por fila
+
+	size_t rows() const { return row_index.size(); }
+	const float* row(size_t i) const { return probs.data() + i * num_classes; }
+};
+
+// Acumula las predicciones de cada fold; si una fila aparece en varias
+// repeticiones de CV se promedian sus probabilidades.
+class OofBuilder {
+public:
+	explicit OofBuilder(int num_classes) : num_classes_(num_classes) {}
+
+	// probs: filas x num_classes (row-major), alineado con indices y labels
+	void add_fold(const std::vector<int64_t>& indices, const std::vector<int>& labels,
+		const std::vector<double>& probs);
+
+	OofMatrix build() const;
+
+private:
+	struct Entry {
+		int label = 0;
+		int count = 0;
+		std::vector<double> sum;
+	};
+	int num_classes_;
+	std::map<int64_t, Entry> rows_;
+};
+
+bool save_oof_binary(const std::filesystem::path& path, const OofMatrix& oof);
+
+bool load_oof_binary(const std::filesystem::path& path, OofMatrix& oof);
@@ -1,9 +1,12 @@
 #include "optuna_report.hpp"
+#include "trace.hpp"
 
 #include <sqlite3.h>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <cmath>
 #include <vector>
 #include <string>
 #include <limits>
@@ -208,6 +211,7 @@ namespace {
 } // namespace
 
 bool generate_optuna_report(const fs::path& folds_dir, const fs::path& out_dir) {
+	TraceSpan span("optuna_reporte", "sqlite");
 	fs::path db_path = folds_dir / "optuna_study.db";
 	if (!fs::exists(db_path)) {
 		std::cerr << YELLOW << "[WARN] No se encontr " << db_path << ". Copi la carpeta 'folds' del Python." << RESET << std::endl;
@@ -0,0 +1,142 @@
+#include "permutation_importance.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <thread>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	// Clase predicha a partir del puntaje crudo: argmax en multiclase; con una
+	// sola salida, umbral 0.5 (binario) o redondeo acotado (regresión ordinal)
+	int predicted_class(const LgbmModel& model, const double* raw, double* scratch, int num_classes) {
+		int k = model.num_tree_per_iteration();
+		if (k > 1) return static_cast<int>(max_element(raw, raw + k) - raw);
+		scratch[0] = raw[0];
+		model.raw_to_output(scratch);
+		string name = model.objective().substr(0, model.objective().find(' '));
+		if (name == "binary" || name == "cross_entropy" || name == "xentropy") return scratch[0] >= 0.5 ? 1 : 0;
+		return min(num_classes - 1, max(0, static_cast<int>(lround(scratch[0]))));
+	}
+
+	int resolve_threads(int requested, size_t tasks) {
+		int threads = requested > 0 ? requested : static_cast<int>(thread::hardware_concurrency());
+		return static_cast<int>(min<size_t>(max(1, threads), max<size_t>(1, tasks)));
+	}
+} // namespace
+
+PermutationResult permutation_importance(const LgbmModel& model, const DenseDataset& data,
+	const vector<int>& labels, int num_classes, const PermutationOptions& options) {
+	TraceSpan span("importancia_permutacion", "modelo");
+	auto start = chrono::steady_clock::now();
+	PermutationResult result;
+	size_t n = data.rows();
+	int k = model.num_tree_per_iteration();
+	int num_features = model.num_features();
+	const vector<LgbmTree>& trees = model.trees();
+	result.rows = n;
+	result.repeats = max(1, options.repeats);
+	if (n == 0 || labels.size() != n || data.num_features < num_features) return result;
+
+	// Puntaje crudo y clase de la predicción sin permutar (en paralelo por bloques de filas)
+	vector<double> base_raw(n * k);
+	vector<int> base_pred(n);
+	{
+		int threads = resolve_threads(options.num_threads, max<size_t>(1, n / 256));
+		auto work = [&](int t) {
+			double scratch[1];
+			for (size_t i = n * t / threads; i < n * (t + 1) / threads; ++i) {
+				model.predict_raw(data.row(i), base_raw.data() + i * k);
+				base_pred[i] = predicted_class(model, base_raw.data() + i * k, scratch, num_classes);
+			}
+		};
+		vector<thread> pool;
+		for (int t = 1; t < threads; ++t) pool.emplace_back(work, t);
+		work(0);
+		for (auto& th : pool) th.join();
+	}
+	result.baseline_kappa = quadratic_weighted_kappa(labels, base_pred, num_classes);
+
+	// Una tarea por (feature, repetición); las features sin splits no cambian la predicción
+	vector<vector<int>> by_feature = model.trees_by_feature();
+	vector<pair<int, int>> tasks;
+	for (int f = 0; f < num_features; ++f) {
+		if (by_feature[f].empty()) continue;
+		for (int r = 0; r < result.repeats; ++r) tasks.emplace_back(f, r);
+	}
+	vector<double> drops(static_cast<size_t>(num_features) * result.repeats, 0.0);
+	// Con average_output (random forest) el puntaje es el promedio de las
+	// iteraciones: cada diferencia por árbol se escala igual que en predict_raw
+	double tree_scale = model.average_output() ? 1.0 / static_cast<double>(trees.size() / k) : 1.0;
+	result.threads = resolve_threads(options.num_threads, tasks.size());
+
+	atomic<size_t> next{ 0 };
+	auto worker = [&]() {
+		// Buffers propios del hilo: fila permutada, puntaje, predicciones y permutación
+		vector<double> row(data.num_features);
+		vector<double> raw(k);
+		vector<int> y_pred(n);
+		vector<size_t> perm(n);
+		double scratch[1];
+		for (size_t task = next++; task < tasks.size(); task = next++) {
+			auto [f, r] = tasks[task];
+			const vector<int>& used = by_feature[f];
+			iota(perm.begin(), perm.end(), size_t{ 0 });
+			mt19937_64 rng(options.seed ^ (static_cast<uint64_t>(f) * 0x9E3779B97F4A7C15ull + static_cast<uint64_t>(r) + 1));
+			shuffle(perm.begin(), perm.end(), rng);
+
+			for (size_t i = 0; i < n; ++i) {
+				const double* original = data.row(i);
+				copy(original, original + data.num_features, row.begin());
+				row[f] = data.row(perm[i])[f];
+				copy(base_raw.begin() + i * k, base_raw.begin() + (i + 1) * k, raw.begin());
+				for (int t : used) raw[t % k] += (trees[t].predict(row.data()) - trees[t].predict(original)) * tree_scale;
+				y_pred[i] = predicted_class(model, raw.data(), scratch, num_classes);
+			}
+			drops[static_cast<size_t>(f) * result.repeats + r] =
+				result.baseline_kappa - quadratic_weighted_kappa(labels, y_pred, num_classes);
+		}
+	};
+	vector<thread> pool;
+	for (int t = 1; t < result.threads; ++t) pool.emplace_back(worker);
+	worker();
+	for (auto& th : pool) th.join();
+
+	const vector<string>& names = model.feature_names();
+	for (int f = 0; f < num_features; ++f) {
+		FeatureImportance fi;
+		fi.feature = f;
+		fi.name = names[f];
+		fi.trees_using = static_cast<int>(by_feature[f].size());
+		if (fi.trees_using > 0) {
+			MetricSummary s = summarize_metric(vector<double>(drops.begin() + static_cast<size_t>(f) * result.repeats,
+				drops.begin() + static_cast<size_t>(f + 1) * result.repeats));
+			fi.mean_drop = s.mean;
+			fi.std_drop = s.stddev;
+		}
+		result.features.push_back(fi);
+	}
+	stable_sort(result.features.begin(), result.features.end(),
+		[](const FeatureImportance& a, const FeatureImportance& b) { return a.mean_drop > b.mean_drop; });
+	result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+bool save_permutation_importance_csv(const fs::path& path, const PermutationResult& result) {
+	ofstream file(path);
+	if (!file) return false;
+	file << "feature,nombre,caida_kappa_media,caida_kappa_std,arboles,repeticiones,kappa_base\n";
+	for (const FeatureImportance& fi : result.features) {
+		file << fi.feature << "," << fi.name << "," << fi.mean_drop << "," << fi.std_drop << ","
+			<< fi.trees_using << "," << result.repeats << "," << result.baseline_kappa << "\n";
+	}
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "lgbm_model.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Importancia por permutación medida en QWK: para cada feature y repetición se
+// baraja la columna y se mide cuánto cae el Kappa respecto de la predicción
+// original. El modelo y los datos se cargan una vez en memoria; cada hilo arma
+// la fila permutada en su propio buffer y sólo reevalúa los árboles que usan
+// la feature (el resto del puntaje se toma de la predicción base).
+struct PermutationOptions {
+	int repeats = 5;
+	int num_threads = 0;           // 0 = hardware_concurrency
+	uint64_t seed = 42;
+};
+
+struct FeatureImportance {
+	int feature = 0;
+	std::string name;
+	double mean_drop = 0.0;        // kappa_base - kappa_permutado, promedio de repeticiones
+	double std_drop = 0.0;
+	int trees_using = 0;           // árboles con algún split en la feature
+};
+
+struct PermutationResult {
+	double baseline_kappa = 0.0;
+	size_t rows = 0;
+	int repeats = 0;
+	int threads = 0;
+	double seconds = 0.0;
+	std::vector<FeatureImportance> features;   // ordenadas por caída media descendente
+};
+
+// labels: etiquetas enteras 0..num_classes-1 (mismas filas que data)
+PermutationResult permutation_importance(const LgbmModel& model, const DenseDataset& data,
+	const std::vector<int>& labels, int num_classes, const PermutationOptions& options);
+
+bool save_permutation_importance_csv(const std::filesystem::path& path, const PermutationResult& result);
@@ -0,0 +1,170 @@
+#include "prediction_stream.hpp"
+#include "io_utils.hpp"
+#include "trace.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	string process_tag() {
+#ifdef _WIN32
+		return to_string(GetCurrentProcessId());
+#else
+		return to_string(getpid());
+#endif
+	}
+} // namespace
+
+PredictionStream::PredictionStream(string name) : name_(std::move(name)) {
+}
+
+PredictionStream::~PredictionStream() {
+	if (reader_.joinable()) finish();
+	std::error_code ec;
+#ifdef _WIN32
+	if (pipe_) CloseHandle(static_cast<HANDLE>(pipe_));
+#else
+	if (!fifo_.empty()) fs::remove(fifo_, ec);
+#endif
+	if (!config_.empty()) fs::remove(config_, ec);
+}
+
+bool PredictionStream::start(const fs::path& config, const fs::path& tee_path, RowCallback on_row) {
+	tee_path_ = tee_path;
+	on_row_ = std::move(on_row);
+	string base = "petfinder_" + process_tag() + "_" + name_;
+
+#ifdef _WIN32
+	fifo_ = "\\\\.\\pipe\\" + base;
+	HANDLE pipe = CreateNamedPipeA(fifo_.string().c_str(), PIPE_ACCESS_INBOUND,
+		PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT, 1, 0, 1 << 16, 0, nullptr);
+	if (pipe == INVALID_HANDLE_VALUE) {
+		cerr << "No se pudo crear el pipe " << fifo_.string() << " (error " << GetLastError() << ")" << endl;
+		fifo_.clear();
+		return false;
+	}
+	pipe_ = pipe;
+#else
+	fifo_ = fs::temp_directory_path() / (base + ".fifo");
+	std::error_code ec;
+	fs::remove(fifo_, ec);
+	if (mkfifo(fifo_.c_str(), 0600) != 0) {
+		cerr << "No se pudo crear la FIFO " << fifo_.string() << ": " << strerror(errno) << endl;
+		fifo_.clear();
+		return false;
+	}
+#endif
+
+	// Config derivado: igual al original pero con output_result en la FIFO
+	config_ = fs::temp_directory_path() / (base + "_config.txt");
+	if (!write_config_overrides(config, config_, { { CONFIG_RESULT_KEYS, fifo_.string() } })) return false;
+
+	reader_ = thread(&PredictionStream::read_loop, this);
+	return true;
+}
+
+void PredictionStream::read_loop() {
+	trace_set_thread_name("lector_" + name_);
+	TraceSpan span("leer_predicciones_stream", "io");
+	ofstream tee;
+	if (!tee_path_.empty()) tee.open(tee_path_, ios::binary);
+	vector<char> buffer(1 << 16);
+
+#ifdef _WIN32
+	HANDLE pipe = static_cast<HANDLE>(pipe_);
+	// Bloquea hasta que LightGBM (o finish) abre el pipe como cliente
+	if (ConnectNamedPipe(pipe, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED) {
+		DWORD read = 0;
+		while (ReadFile(pipe, buffer.data(), static_cast<DWORD>(buffer.size()), &read, nullptr) && read > 0) {
+			if (tee) tee.write(buffer.data(), read);
+			parse(buffer.data(), read);
+		}
+	}
+	DisconnectNamedPipe(pipe);
+#else
+	// open() bloquea hasta que LightGBM (o finish) abre la FIFO para escribir
+	int fd;
+	while ((fd = open(fifo_.c_str(), O_RDONLY)) < 0 && errno == EINTR) {}
+	if (fd >= 0) {
+		ssize_t n;
+		while ((n = read(fd, buffer.data(), buffer.size())) > 0 || (n < 0 && errno == EINTR)) {
+			if (n <= 0) continue;
+			if (tee) tee.write(buffer.data(), n);
+			parse(buffer.data(), static_cast<size_t>(n));
+		}
+		close(fd);
+	}
+#endif
+	if (!pending_.empty()) parse_line();
+	done_ = true;
+}
+
+void PredictionStream::parse(const char* data, size_t size) {
+	const char* end = data + size;
+	while (data < end) {
+		const char* newline = static_cast<const char*>(memchr(data, '\n', end - data));
+		if (!newline) {
+			pending_.append(data, end);
+			return;
+		}
+		pending_.append(data, newline);
+		parse_line();
+		data = newline + 1;
+	}
+}
+
+void PredictionStream::parse_line() {
+	row_.clear();
+	const char* p = pending_.c_str();
+	char* end = nullptr;
+	for (double value = strtod(p, &end); end != p; value = strtod(p, &end)) {
+		row_.push_back(value);
+		p = end;
+	}
+	pending_.clear();
+	if (row_.empty()) return;
+	int cols = static_cast<int>(row_.size());
+	if (cols_ == 0) cols_ = cols;
+	if (cols != cols_) {
+		ok_ = false;
+		return;
+	}
+	values_.insert(values_.end(), row_.begin(), row_.end());
+	if (on_row_) on_row_(row_.data(), cols);
+}
+
+bool PredictionStream::finish() {
+	if (!reader_.joinable()) return false;
+	auto t0 = chrono::steady_clock::now();
+	// Si el proceso nunca abrió la FIFO el lector sigue bloqueado en open/Connect:
+	// se abre y cierra desde acá como escritor para que vea fin de archivo
+	while (!done_) {
+#ifdef _WIN32
+		HANDLE client = CreateFileA(fifo_.string().c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+		if (client != INVALID_HANDLE_VALUE) CloseHandle(client);
+#else
+		int fd = open(fifo_.c_str(), O_WRONLY | O_NONBLOCK);
+		if (fd >= 0) close(fd);
+#endif
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	reader_.join();
+	drain_ms_ = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+	if (!ok_) cerr << "Filas con distinta cantidad de columnas en las predicciones de " << name_ << endl;
+	return ok_ && cols_ > 0;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Predicciones de LightGBM leídas de una FIFO mientras el proceso las escribe.
+//   POSIX:   mkfifo en el directorio temporal
+//   Windows: named pipe \\.\pipe\petfinder_<pid>_<nombre>
+// Se escribe un config derivado con output_result apuntando a la FIFO y un hilo
+// lector parsea cada fila de probabilidades apenas llega: cuando LightGBM termina
+// las predicciones ya están en memoria y no se escribe archivo, salvo que se pida
+// una copia (tee_path).
+class PredictionStream {
+public:
+	// values: columnas de la fila (probabilidades por clase)
+	using RowCallback = std::function<void(const double* values, int cols)>;
+
+	explicit PredictionStream(std::string name);
+	~PredictionStream();
+
+	PredictionStream(const PredictionStream&) = delete;
+	PredictionStream& operator=(const PredictionStream&) = delete;
+
+	// Crea la FIFO, escribe el config derivado y lanza el lector
+	bool start(const std::filesystem::path& config, const std::filesystem::path& tee_path = {},
+		RowCallback on_row = nullptr);
+
+	// Config para LightGBM (output_result = FIFO)
+	const std::filesystem::path& config() const { return config_; }
+
+	// Llamar cuando el proceso terminó: si nunca abrió la FIFO (falló antes de
+	// predecir) se abre desde acá para que el lector vea fin de archivo. Espera al
+	// lector y devuelve true si todas las filas tuvieron la misma cantidad de columnas.
+	bool finish();
+
+	int cols() const { return cols_; }
+	size_t rows() const { return cols_ > 0 ? values_.size() / cols_ : 0; }
+	std::vector<double>& values() { return values_; }
+	// Milisegundos entre el fin del proceso y el fin del lector
+	double drain_ms() const { return drain_ms_; }
+
+private:
+	void read_loop();
+	void parse(const char* data, size_t size);
+	void parse_line();
+
+	std::string name_;
+	std::filesystem::path fifo_;
+	std::filesystem::path config_;
+	std::filesystem::path tee_path_;
+	RowCallback on_row_;
+	std::thread reader_;
+	std::atomic<bool> done_{ false };
+	bool ok_ = true;
+	int cols_ = 0;
+	std::string pending_;
+	std::vector<double> row_;
+	std::vector<double> values_;
+	double drain_ms_ = 0.0;
+#ifdef _WIN32
+	void* pipe_ = nullptr;
+#endif
+};
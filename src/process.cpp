@@ -0,0 +1,278 @@
+#include "process.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+	double elapsed_ms(chrono::steady_clock::time_point t0) {
+		return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+	}
+
+	// Arma líneas a partir de los bloques leídos del pipe; cada línea completa se
+	// imprime (los hijos de varios folds comparten la consola) y se pasa al callback
+	class LineSplitter {
+	public:
+		explicit LineSplitter(const LineCallback& on_line) : on_line_(on_line) {}
+		~LineSplitter() { flush(); }
+
+		void feed(const char* data, size_t size) {
+			for (size_t i = 0; i < size; ++i) {
+				if (data[i] == '\n') emit();
+				else if (data[i] != '\r') pending_ += data[i];
+			}
+		}
+
+		void flush() {
+			if (!pending_.empty()) emit();
+		}
+
+	private:
+		void emit() {
+			{
+				static mutex console_mtx;
+				lock_guard<mutex> lock(console_mtx);
+				cout << pending_ << '\n' << std::flush;
+			}
+			on_line_(pending_);
+			pending_.clear();
+		}
+
+		const LineCallback& on_line_;
+		string pending_;
+	};
+
+#ifndef _WIN32
+	// Lee rchar/wchar de /proc/<pid>/io (incluye a los hijos ya cosechados por el proceso)
+	void read_proc_io(pid_t pid, ProcessStats& stats) {
+		ifstream io("/proc/" + to_string(pid) + "/io");
+		string key;
+		uint64_t value;
+		while (io >> key >> value) {
+			if (key == "rchar:") stats.io_read_bytes = value;
+			else if (key == "wchar:") stats.io_write_bytes = value;
+		}
+	}
+#endif
+} // namespace
+
+#ifdef _WIN32
+
+ProcessStats run_process(const string& cmd, const LineCallback& on_line) {
+	ProcessStats stats;
+	auto t0 = chrono::steady_clock::now();
+
+	// Job Object para contabilizar también a los procesos que lance el hijo
+	HANDLE job = CreateJobObjectA(nullptr, nullptr);
+
+	STARTUPINFOEXA si{};
+	si.StartupInfo.cb = sizeof(si);
+	PROCESS_INFORMATION pi{};
+	vector<char> cmdline(cmd.begin(), cmd.end());
+	cmdline.push_back('\0');
+	DWORD flags = CREATE_SUSPENDED;
+	BOOL inherit = FALSE;
+
+	// Captura de salida: el extremo de escritura del pipe se hereda sólo a este hijo
+	// (lista explícita de handles), así los procesos que otros hilos lanzan a la vez
+	// no lo mantienen abierto y la lectura termina cuando este hijo sale
+	HANDLE read_pipe = nullptr, write_pipe = nullptr;
+	vector<char> attr_buffer;
+	if (on_line) {
+		SECURITY_ATTRIBUTES sa{ sizeof(sa), nullptr, TRUE };
+		SIZE_T attr_size = 0;
+		InitializeProcThreadAttributeList(nullptr, 1, 0, &attr_size);
+		attr_buffer.resize(attr_size);
+		auto attrs = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attr_buffer.data());
+		if (CreatePipe(&read_pipe, &write_pipe, &sa, 0)
+			&& SetHandleInformation(read_pipe, HANDLE_FLAG_INHERIT, 0)
+			&& InitializeProcThreadAttributeList(attrs, 1, 0, &attr_size)
+			&& UpdateProcThreadAttribute(attrs, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST, &write_pipe, sizeof(HANDLE),
+				nullptr, nullptr)) {
+			si.lpAttributeList = attrs;
+			si.StartupInfo.dwFlags |= STARTF_USESTDHANDLES;
+			si.StartupInfo.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+			si.StartupInfo.hStdOutput = write_pipe;
+			si.StartupInfo.hStdError = write_pipe;
+			flags |= EXTENDED_STARTUPINFO_PRESENT;
+			inherit = TRUE;
+		}
+		else {
+			cerr << "No se pudo capturar la salida (error " << GetLastError() << "): " << cmd << endl;
+			if (read_pipe) CloseHandle(read_pipe);
+			if (write_pipe) CloseHandle(write_pipe);
+			read_pipe = write_pipe = nullptr;
+		}
+	}
+
+	bool launched = CreateProcessA(nullptr, cmdline.data(), nullptr, nullptr, inherit, flags,
+		nullptr, nullptr, &si.StartupInfo, &pi);
+	if (si.lpAttributeList) DeleteProcThreadAttributeList(si.lpAttributeList);
+	if (write_pipe) CloseHandle(write_pipe);
+	if (!launched) {
+		cerr << "No se pudo lanzar el proceso (error " << GetLastError() << "): " << cmd << endl;
+		if (read_pipe) CloseHandle(read_pipe);
+		if (job) CloseHandle(job);
+		return stats;
+	}
+	if (job) AssignProcessToJobObject(job, pi.hProcess);
+	ResumeThread(pi.hThread);
+	if (read_pipe) {
+		LineSplitter lines(on_line);
+		char buffer[4096];
+		DWORD read = 0;
+		while (ReadFile(read_pipe, buffer, sizeof(buffer), &read, nullptr) && read > 0) lines.feed(buffer, read);
+		CloseHandle(read_pipe);
+	}
+	WaitForSingleObject(pi.hProcess, INFINITE);
+	stats.wall_ms = elapsed_ms(t0);
+
+	DWORD code = 0;
+	GetExitCodeProcess(pi.hProcess, &code);
+	stats.exit_code = static_cast<int>(code);
+
+	JOBOBJECT_BASIC_AND_IO_ACCOUNTING_INFORMATION acct{};
+	if (job && QueryInformationJobObject(job, JobObjectBasicAndIoAccountingInformation, &acct, sizeof(acct), nullptr)) {
+		stats.user_ms = acct.BasicInfo.TotalUserTime.QuadPart / 1.0e4; // unidades de 100 ns
+		stats.sys_ms = acct.BasicInfo.TotalKernelTime.QuadPart / 1.0e4;
+		stats.io_read_bytes = acct.IoInfo.ReadTransferCount;
+		stats.io_write_bytes = acct.IoInfo.WriteTransferCount;
+	}
+	else {
+		FILETIME created, exited, kernel, user;
+		if (GetProcessTimes(pi.hProcess, &created, &exited, &kernel, &user)) {
+			ULARGE_INTEGER k{}, u{};
+			k.LowPart = kernel.dwLowDateTime; k.HighPart = kernel.dwHighDateTime;
+			u.LowPart = user.dwLowDateTime; u.HighPart = user.dwHighDateTime;
+			stats.user_ms = u.QuadPart / 1.0e4;
+			stats.sys_ms = k.QuadPart / 1.0e4;
+		}
+		IO_COUNTERS io{};
+		if (GetProcessIoCounters(pi.hProcess, &io)) {
+			stats.io_read_bytes = io.ReadTransferCount;
+			stats.io_write_bytes = io.WriteTransferCount;
+		}
+	}
+
+	PROCESS_MEMORY_COUNTERS pmc{};
+	if (GetProcessMemoryInfo(pi.hProcess, &pmc, sizeof(pmc))) {
+		stats.peak_rss_bytes = pmc.PeakWorkingSetSize;
+	}
+	JOBOBJECT_EXTENDED_LIMIT_INFORMATION ext{};
+	if (job && QueryInformationJobObject(job, JobObjectExtendedLimitInformation, &ext, sizeof(ext), nullptr)) {
+		// Si el trabajo real lo hizo un descendiente (lanzador de python), usar el pico del job
+		if (ext.PeakProcessMemoryUsed > stats.peak_rss_bytes) stats.peak_rss_bytes = ext.PeakProcessMemoryUsed;
+	}
+
+	CloseHandle(pi.hThread);
+	CloseHandle(pi.hProcess);
+	if (job) CloseHandle(job);
+	return stats;
+}
+
+uint64_t physical_memory_bytes() {
+	MEMORYSTATUSEX status{};
+	status.dwLength = sizeof(status);
+	return GlobalMemoryStatusEx(&status) ? status.ullTotalPhys : 0;
+}
+
+filesystem::path executable_path(const char* argv0) {
+	char buffer[MAX_PATH];
+	DWORD size = GetModuleFileNameA(NULL, buffer, MAX_PATH);
+	if (size > 0 && size < MAX_PATH) return filesystem::path(string(buffer, size));
+	std::error_code ec;
+	return argv0 ? filesystem::absolute(argv0, ec) : filesystem::path();
+}
+
+#else
+
+ProcessStats run_process(const string& cmd, const LineCallback& on_line) {
+	ProcessStats stats;
+	auto t0 = chrono::steady_clock::now();
+
+	// O_CLOEXEC: los hijos que otros hilos lanzan a la vez no heredan el pipe
+	int fds[2] = { -1, -1 };
+	if (on_line && pipe2(fds, O_CLOEXEC) != 0) {
+		cerr << "No se pudo capturar la salida: " << cmd << endl;
+		fds[0] = fds[1] = -1;
+	}
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		cerr << "No se pudo lanzar el proceso: " << cmd << endl;
+		if (fds[0] >= 0) {
+			close(fds[0]);
+			close(fds[1]);
+		}
+		return stats;
+	}
+	if (pid == 0) {
+		if (fds[1] >= 0) {
+			dup2(fds[1], STDOUT_FILENO);
+			dup2(fds[1], STDERR_FILENO);
+		}
+		execl("/bin/sh", "sh", "-c", cmd.c_str(), static_cast<char*>(nullptr));
+		_exit(127);
+	}
+	if (fds[0] >= 0) {
+		close(fds[1]);
+		LineSplitter lines(on_line);
+		char buffer[4096];
+		ssize_t n;
+		while ((n = read(fds[0], buffer, sizeof(buffer))) > 0 || (n < 0 && errno == EINTR)) {
+			if (n > 0) lines.feed(buffer, static_cast<size_t>(n));
+		}
+		close(fds[0]);
+	}
+
+	// Esperar sin cosechar para poder leer /proc/<pid>/io del zombie
+	siginfo_t info{};
+	while (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) != 0 && errno == EINTR) {}
+	stats.wall_ms = elapsed_ms(t0);
+	read_proc_io(pid, stats);
+
+	int status = 0;
+	struct rusage ru{};
+	while (wait4(pid, &status, 0, &ru) < 0 && errno == EINTR) {}
+	stats.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+	stats.user_ms = ru.ru_utime.tv_sec * 1000.0 + ru.ru_utime.tv_usec / 1000.0;
+	stats.sys_ms = ru.ru_stime.tv_sec * 1000.0 + ru.ru_stime.tv_usec / 1000.0;
+	stats.peak_rss_bytes = static_cast<uint64_t>(ru.ru_maxrss) * 1024; // Linux: KB
+	return stats;
+}
+
+uint64_t physical_memory_bytes() {
+	long pages = sysconf(_SC_PHYS_PAGES);
+	long page_size = sysconf(_SC_PAGE_SIZE);
+	return (pages > 0 && page_size > 0) ? static_cast<uint64_t>(pages) * page_size : 0;
+}
+
+filesystem::path executable_path(const char* argv0) {
+	std::error_code ec;
+	filesystem::path self = filesystem::read_symlink("/proc/self/exe", ec);
+	if (!ec && !self.empty()) return self;
+	// Sin /proc (macOS, BSD): argv[0] relativo al directorio de trabajo
+	if (!argv0) return filesystem::path();
+	filesystem::path path = filesystem::absolute(argv0, ec);
+	filesystem::path canonical = filesystem::weakly_canonical(path, ec);
+	return ec ? path : canonical;
+}
+
+#endif
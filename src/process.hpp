@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+// Recursos consumidos por un proceso hijo (LightGBM o Python).
+// - Windows: el hijo corre dentro de un Job Object, así que CPU e I/O incluyen
+//   a sus descendientes (ej. el lanzador de python); memoria = pico de working set.
+// - POSIX: rusage de wait4 y /proc/<pid>/io antes de cosechar al hijo.
+struct ProcessStats {
+	int exit_code = -1;
+	double wall_ms = 0.0;
+	double user_ms = 0.0;
+	double sys_ms = 0.0;
+	uint64_t peak_rss_bytes = 0;
+	uint64_t io_read_bytes = 0;
+	uint64_t io_write_bytes = 0;
+};
+
+// Recibe cada línea de salida del hijo (stdout y stderr), sin el salto de línea
+using LineCallback = std::function<void(const std::string&)>;
+
+// Ejecuta cmd (misma sintaxis que system()) y espera a que termine.
+// exit_code = -1 si no se pudo lanzar el proceso.
+// Con on_line la salida del hijo pasa por un pipe: cada línea se reenvía a la
+// consola y a on_line, en el hilo que llama, mientras el hijo corre.
+ProcessStats run_process(const std::string& cmd, const LineCallback& on_line = nullptr);
+
+// Memoria física total del equipo en bytes (0 si no se puede determinar)
+uint64_t physical_memory_bytes();
+
+// Ruta absoluta del ejecutable en curso (GetModuleFileName en Windows,
+// /proc/self/exe en Linux); si no se puede, argv0 resuelto contra el cwd
+std::filesystem::path executable_path(const char* argv0);
+
+// Nombre del binario de LightGBM que se busca junto al ejecutable
+#ifdef _WIN32
+inline constexpr const char* LIGHTGBM_EXECUTABLE = "lightgbm.exe";
+#else
+inline constexpr const char* LIGHTGBM_EXECUTABLE = "lightgbm";
+#endif
@@ -0,0 +1,103 @@
+#pragma once
+#include "lgbm_model.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Motor de evaluación QuickScorer (Lucchese et al.) para puntuar lotes con un
+// modelo cargado de model_*.txt. En lugar de recorrer cada árbol nodo a nodo,
+// cada árbol es un bitvector de hojas (orden izquierda a derecha) y cada nodo
+// interno una máscara que borra las hojas de su subárbol izquierdo. Por feature,
+// los nodos numéricos se ordenan por umbral: para un valor x, los nodos "falsos"
+// (x > umbral, la fila va a la derecha) son un prefijo de esa lista y se aplican
+// con un AND; la hoja de salida es el bit más bajo que queda en 1.
+// Con AVX2 (V-QuickScorer) se evalúan 4 filas a la vez comparando los umbrales
+// contra un vector de 4 doubles; sin AVX2 se usa el mismo algoritmo fila a fila.
+// Los splits categóricos y los valores faltantes/cero se resuelven nodo a nodo con
+// la lógica de LgbmTree::next_node, y los árboles de más de 64 hojas por recorrido,
+// así que el resultado es idéntico al del predictor por recorrido.
+
+enum class PredictEngine { Auto, Traversal, QuickScorer };
+
+// auto | traversal | quickscorer
+bool parse_predict_engine(const std::string& text, PredictEngine& engine);
+const char* predict_engine_name(PredictEngine engine);
+
+class QuickScorer {
+public:
+	// allow_avx2 = false fuerza el kernel escalar (para compararlos)
+	explicit QuickScorer(const LgbmModel& model, bool allow_avx2 = true);
+
+	const LgbmModel& model() const { return model_; }
+	size_t bitvector_trees() const { return slot_tree_.size(); }
+	size_t fallback_trees() const { return model_.trees().size() - slot_tree_.size(); }
+	// true si el procesador tiene AVX2 y se usa el kernel de 4 filas
+	bool vectorized() const { return avx2_; }
+
+	// Puntajes crudos de count filas (row-major, stride valores por fila);
+	// out: count x num_tree_per_iteration
+	void predict_raw(const double* rows, size_t count, int stride, double* out) const;
+
+private:
+	// Nodos de todos los árboles que parten por una feature
+	struct FeatureNodes {
+		// Numéricos, ordenados por umbral
+		std::vector<double> thresholds;
+		std::vector<uint32_t> slots;
+		std::vector<uint64_t> masks;
+		std::vector<int> nodes;
+		// Categóricos, evaluados con next_node en cada fila
+		std::vector<uint32_t> cat_slots;
+		std::vector<uint64_t> cat_masks;
+		std::vector<int> cat_nodes;
+		bool zero_missing = false;      // algún nodo con missing_type zero
+	};
+
+	// Evalúa nodo a nodo (next_node) los nodos de fn para una fila (lane de lanes)
+	void apply_direct(const FeatureNodes& fn, double value, bool numeric, uint64_t* leaves, int lanes, int lane) const;
+	bool is_special(const FeatureNodes& fn, double value) const;
+	// Suma las hojas de salida (y los árboles por recorrido) en el orden de los árboles
+	void accumulate(const uint64_t* leaves, int lanes, int lane, const double* row, double* out) const;
+	void score_scalar(const double* row, uint64_t* leaves, double* out) const;
+	void score_avx2(const double* rows, int stride, uint64_t* leaves, double* out) const;
+
+	const LgbmModel& model_;
+	bool avx2_ = false;
+	std::vector<FeatureNodes> features_;
+	std::vector<int> active_;             // features con algún nodo
+	std::vector<int> tree_slot_;          // árbol -> slot de bitvector (-1 = por recorrido)
+	std::vector<int> slot_tree_;          // slot -> árbol
+	std::vector<double> slot_leaves_;     // slot x 64: valor de la hoja por posición de bit
+};
+
+// Probabilidades (filas x clases) con el motor elegido; Auto usa QuickScorer si
+// la mayoría de los árboles entra en bitvectors de 64 hojas
+std::vector<double> predict_proba_engine(const LgbmModel& model, const DenseDataset& data, PredictEngine engine,
+	int num_threads = 0);
+
+// Una celda del benchmark: modelo recortado a iterations iteraciones y max_depth niveles
+struct EngineBenchmark {
+	int iterations = 0;
+	int trees = 0;
+	int max_depth = 0;                    // profundidad del modelo recortado
+	int max_leaves = 0;
+	size_t rows = 0;
+	size_t fallback_trees = 0;
+	bool vectorized = false;              // kernel AVX2 de 4 filas
+	double traversal_ms = 0.0;            // mejor tiempo de varias pasadas
+	double quickscorer_ms = 0.0;          // QuickScorer (AVX2 si está disponible)
+	double scalar_ms = 0.0;               // QuickScorer fila a fila
+	double max_diff = 0.0;                // máxima diferencia de puntaje crudo contra el recorrido
+	double speedup() const { return quickscorer_ms > 0.0 ? traversal_ms / quickscorer_ms : 0.0; }
+};
+
+// Compara ambos motores (un hilo, para medir el kernel) sobre una grilla de
+// iteraciones x profundidades derivada del modelo
+std::vector<EngineBenchmark> benchmark_engines(const LgbmModel& model, const DenseDataset& data);
+
+// Máxima diferencia absoluta contra las probabilidades de output_result de
+// LightGBM; -1 si no son comparables
+double compare_with_lightgbm_predictions(const std::vector<double>& probs, int num_classes,
+	const std::filesystem::path& predictions);
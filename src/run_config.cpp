@@ -0,0 +1,167 @@
+#include "run_config.hpp"
+#include "io_utils.hpp"
+#include "quickscorer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define YELLOW  "\033[33m"
+#define CYAN    "\033[36m"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	// Aplica una clave; devuelve false si no se reconoce o el valor es inválido
+	bool apply_key(RunConfig& cfg, const string& key, const string& value) {
+		try {
+			if (key == "max_parallel_jobs") cfg.max_parallel_jobs = max(1, stoi(value));
+			else if (key == "mem_cap_mb") cfg.mem_cap_mb = stoull(value);
+			else if (key == "num_folds") cfg.num_folds = max(1, stoi(value));
+			else if (key == "num_repeats") cfg.num_repeats = max(1, stoi(value));
+			else if (key == "num_classes") cfg.num_classes = max(2, stoi(value));
+			else if (key == "num_threads") cfg.num_threads = max(0, stoi(value));
+			else if (key == "stacking") cfg.stacking = stoi(value) != 0;
+			else if (key == "stacking_l2") cfg.stacking_l2 = max(0.0, stod(value));
+			else if (key == "stages") {
+				set<string> stages;
+				stringstream ss(value);
+				string stage;
+				while (getline(ss, stage, ',')) {
+					if (stage == "all") stages.insert(all_stages().begin(), all_stages().end());
+					else if (find(all_stages().begin(), all_stages().end(), stage) != all_stages().end()) stages.insert(stage);
+					else if (!stage.empty()) return false;
+				}
+				cfg.stages = stages;
+			}
+			else if (key == "final_model") {
+				if (value != "yes" && value != "no") return false;
+				cfg.final_model = value;
+			}
+			else if (key == "stage_cache") cfg.stage_cache = stoi(value) != 0;
+			else if (key == "dataset_cache") cfg.dataset_cache = stoi(value) != 0;
+			else if (key == "incremental") cfg.incremental = stoi(value) != 0;
+			else if (key == "incremental_data") cfg.incremental_data = value;
+			else if (key == "incremental_iterations") cfg.incremental_iterations = max(1, stoi(value));
+			else if (key == "incremental_tolerance") cfg.incremental_tolerance = max(0.0, stod(value));
+			else if (key == "drift_check") cfg.drift_check = stoi(value) != 0;
+			else if (key == "drift_psi_max") cfg.drift_psi_max = max(0.0, stod(value));
+			else if (key == "drift_ks_max") cfg.drift_ks_max = max(0.0, stod(value));
+			else if (key == "drift_action") {
+				if (value != "fail" && value != "warn") return false;
+				cfg.drift_action = value;
+			}
+			else if (key == "seeds") {
+				vector<int> seeds;
+				stringstream ss(value);
+				string seed;
+				while (getline(ss, seed, ',')) {
+					if (seed.empty()) continue;
+					int s = stoi(seed);
+					if (find(seeds.begin(), seeds.end(), s) == seeds.end()) seeds.push_back(s);
+				}
+				cfg.seeds = seeds;
+			}
+			else if (key == "seed_ensemble") cfg.seed_ensemble = stoi(value) != 0;
+			else if (key == "seed_thread_budget") cfg.seed_thread_budget = max(0, stoi(value));
+			else if (key == "train_curves") cfg.train_curves = stoi(value) != 0;
+			else if (key == "train_progress_seconds") cfg.train_progress_seconds = max(0.0, stod(value));
+			else if (key == "stream_predictions") cfg.stream_predictions = stoi(value) != 0;
+			else if (key == "stream_keep_file") cfg.stream_keep_file = stoi(value) != 0;
+			else if (key == "resume") cfg.resume_run_id = value;
+			else if (key == "farm_mode") {
+				if (value != "coordinator" && value != "worker" && !value.empty()) return false;
+				cfg.farm_mode = value;
+			}
+			else if (key == "queue_db") cfg.queue_db = value;
+			else if (key == "lease_seconds") cfg.lease_seconds = max(3, stoi(value));
+			else if (key == "max_attempts") cfg.max_attempts = max(1, stoi(value));
+			else if (key == "worker_idle_exit") cfg.worker_idle_exit = max(0, stoi(value));
+			else if (key == "farm_wait_timeout") cfg.farm_wait_timeout = max(0, stoi(value));
+			else if (key == "permutation_importance") cfg.permutation_importance = stoi(value) != 0;
+			else if (key == "permutation_repeats") cfg.permutation_repeats = max(1, stoi(value));
+			else if (key == "shap") cfg.shap = stoi(value) != 0;
+			else if (key == "shap_background") cfg.shap_background = max(0, stoi(value));
+			else if (key == "shap_max_rows") cfg.shap_max_rows = max(0, stoi(value));
+			else if (key == "shap_csv") cfg.shap_csv = stoi(value) != 0;
+			else if (key == "shap_validate") cfg.shap_validate = stoi(value) != 0;
+			else if (key == "shap_validate_rows") cfg.shap_validate_rows = max(0, stoi(value));
+			else if (key == "predict_engine") {
+				PredictEngine engine;
+				if (!parse_predict_engine(value, engine)) return false;
+				cfg.predict_engine = value;
+			}
+			else if (key == "predict_bench") cfg.predict_bench = stoi(value) != 0;
+			else if (key == "experiment") cfg.experiment = value;
+			else if (key == "top") cfg.top_n = max(0, stoi(value));
+			else if (key == "top_by") {
+				if (value != "kappa" && value != "f1" && value != "holdout") return false;
+				cfg.top_by = value;
+			}
+			else return false;
+		}
+		catch (const exception&) {
+			return false;
+		}
+		return true;
+	}
+} // namespace
+
+const vector<string>& all_stages() {
+	static const vector<string> stages = { "train", "predict", "evaluate", "plot", "stacking", "importance",
+		"final", "infer", "shap" };
+	return stages;
+}
+
+bool stage_selected(const RunConfig& cfg, const string& stage) {
+	return cfg.stages.count(stage) > 0;
+}
+
+RunConfig load_run_config(const fs::path& config_file, int argc, char* argv[]) {
+	RunConfig cfg;
+	map<string, string> params;
+	if (fs::exists(config_file)) {
+		params = read_config_map(config_file.string());
+		cout << CYAN << "[INFO] Configuracion de corrida: " << config_file.string() << RESET << endl;
+	}
+
+	// Los argumentos clave=valor tienen prioridad sobre el archivo
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if ((arg == "--resume" || arg == "--top" || arg == "--stages" || arg == "--seeds") && i + 1 < argc) {
+			params[arg.substr(2)] = argv[++i];
+			continue;
+		}
+		if (arg == "--coordinator" || arg == "--worker") {
+			params["farm_mode"] = arg.substr(2);
+			continue;
+		}
+		if (arg == "--incremental") {
+			params["incremental"] = "1";
+			continue;
+		}
+		size_t eq = arg.find('=');
+		if (eq == string::npos) continue;
+		params[arg.substr(0, eq)] = arg.substr(eq + 1);
+	}
+
+	for (const auto& [key, value] : params) {
+		if (!apply_key(cfg, key, value)) {
+			cerr << YELLOW << "[WARN] Parametro de corrida ignorado: " << key << "=" << value << RESET << endl;
+		}
+	}
+
+	// final_model se aplica después de stages (el orden del archivo no importa)
+	for (const char* stage : { "final", "infer", "shap" }) {
+		if (cfg.final_model == "yes") cfg.stages.insert(stage);
+		else if (cfg.final_model == "no") cfg.stages.erase(stage);
+	}
+	// El reentrenamiento incremental reemplaza a la etapa final
+	if (cfg.incremental) cfg.stages.insert("final");
+	return cfg;
+}
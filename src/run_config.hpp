@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <vector>
+
+// Parámetros de la corrida (no de LightGBM).
+// Se leen de run_config.txt junto al ejecutable (clave=valor, igual que los
+// config de LightGBM) y luego se pisan con argumentos clave=valor de la línea
+// de comandos, ej.: PetFinderLGBM.exe max_parallel_jobs=3 mem_cap_mb=6000
+// Además: PetFinderLGBM.exe --resume 20250314_153012 (equivale a resume=<run_id>),
+// --coordinator y --worker (equivalen a farm_mode=coordinator / farm_mode=worker),
+// --top 20 (equivale a top=20: imprime las mejores corridas y termina),
+// --stages train,predict,evaluate (equivale a stages=...: etapas a ejecutar),
+// --incremental (equivale a incremental=1) y --seeds 11,23,42 (equivale a seeds=...).
+struct RunConfig {
+	int max_parallel_jobs = 1;   // trabajos LightGBM simultáneos (folds + holdout)
+	uint64_t mem_cap_mb = 0;     // tope de memoria proyectada; 0 = 75% de la RAM física
+	int num_folds = 5;           // folds por repetición
+	int num_repeats = 1;         // repeticiones de CV; la r > 0 usa folds/repeat_<r>/
+	int num_classes = 5;         // clases de AdoptionSpeed (u otro esquema de etiquetas)
+	int num_threads = 0;         // hilos para el cómputo en proceso; 0 = hardware_concurrency
+	bool stacking = true;        // meta-modelo sobre las probabilidades OOF, evaluado en holdout
+	double stacking_l2 = 1e-3;   // regularización L2 del meta-modelo
+	// Etapas a ejecutar (stages=train,predict,... o stages=all). Las no seleccionadas
+	// reutilizan las salidas que ya existen (o las de la cache de etapas).
+	std::set<std::string> stages = { "train", "predict", "evaluate", "plot", "stacking", "importance" };
+	std::string final_model;     // yes: agrega final, infer y shap a stages; no: los quita
+	bool stage_cache = true;     // reutiliza salidas de etapas con la misma huella de entradas (cache_etapas/)
+	bool train_curves = true;    // guarda las métricas por iteración de cada entrenamiento y recomienda num_iterations
+	double train_progress_seconds = 2.0;  // cada cuánto imprimir el progreso de cada entrenamiento; 0 = nunca
+	bool stream_predictions = false;  // predicciones de folds y holdout por FIFO, parseadas mientras LightGBM escribe
+	bool stream_keep_file = false;    // con stream_predictions, además copia las predicciones a output_result
+	bool dataset_cache = true;   // datasets binarios de LightGBM por clave de datos + binning (cache_datasets/)
+	bool incremental = false;    // continúa el modelo final en producción en lugar de reentrenarlo desde cero
+	std::string incremental_data;  // datos para la continuación; "" = data de config_train_all.txt (combinado)
+	int incremental_iterations = 50;  // árboles extra sobre el modelo base
+	double incremental_tolerance = 0.0;  // caída de QWK en holdout tolerada para promover el candidato
+	bool drift_check = true;     // antes de la inferencia compara train_all con los datos de test (PSI y KS por feature)
+	double drift_psi_max = 0.25; // PSI máximo tolerado por feature
+	double drift_ks_max = 0.0;   // KS máximo tolerado por feature; 0 = sin límite
+	std::string drift_action = "fail";  // fail: no corre la inferencia si se supera un umbral; warn: sólo avisa
+	std::vector<int> seeds;      // seeds=11,23,42: evalúa folds y holdout una vez por semilla (modo multi-semilla)
+	bool seed_ensemble = true;   // con seeds, además evalúa el promedio de probabilidades de las semillas
+	int seed_thread_budget = 0;  // hilos repartidos entre los LightGBM simultáneos del modo multi-semilla; 0 = hardware_concurrency
+	std::string resume_run_id;   // --resume <run_id>: retoma una corrida desde su journal
+	std::string farm_mode;       // "" = local, "coordinator" (--coordinator) o "worker" (--worker)
+	std::string queue_db = "cola_trabajos.db";  // cola compartida entre coordinador y workers
+	int lease_seconds = 60;      // duración del lease; el worker lo renueva cada lease/3
+	int max_attempts = 3;        // intentos por trabajo de la cola
+	int worker_idle_exit = 0;    // el worker termina tras N s sin trabajos; 0 = nunca
+	int farm_wait_timeout = 600; // el coordinador abandona tras N s sin workers activos; 0 = nunca
+	bool permutation_importance = true;  // importancia por permutación (QWK) en holdout
+	int permutation_repeats = 5; // permutaciones por feature
+	bool shap = true;            // SHAP del modelo final sobre los datos de inferencia
+	int shap_background = 0;     // 0 = TreeSHAP path-dependent; N = interventional con N filas de train_all
+	int shap_max_rows = 0;       // filas a explicar; 0 = todas
+	bool shap_csv = false;       // además del binario, valores SHAP en CSV
+	bool shap_validate = false;  // compara los SHAP con predict_contrib de LightGBM (lanza otro proceso)
+	int shap_validate_rows = 200;  // filas comparadas con shap_validate=1
+	std::string predict_engine = "auto";  // predictor en proceso: auto | traversal | quickscorer
+	bool predict_bench = false;  // verifica QuickScorer contra pred_infer.txt y lo compara con el recorrido
+	std::string experiment = "default";  // etiqueta de la corrida en la tabla corridas
+	int top_n = 0;               // --top N: imprime el leaderboard y termina
+	std::string top_by = "kappa";  // orden del leaderboard: kappa | f1 | holdout
+};
+
+// Todas las etapas, en orden de ejecución
+const std::vector<std::string>& all_stages();
+
+bool stage_selected(const RunConfig& cfg, const std::string& stage);
+
+RunConfig load_run_config(const std::filesystem::path& config_file, int argc, char* argv[]);
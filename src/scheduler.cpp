@@ -0,0 +1,161 @@
+#include "scheduler.hpp"
+#include "io_utils.hpp"
+
+#include <sqlite3.h>
+#include <cstdio>
+#include <iostream>
+#include <map>
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define YELLOW  "\033[33m"
+#define BLUE    "\033[34m"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	const double MB = 1024.0 * 1024.0;
+	const uint64_t BASE_PROCESS_BYTES = 80ull * 1024 * 1024; // LightGBM en vacío + modelo
+	const double HISTORY_MARGIN = 1.15;
+
+	uint64_t file_size_or_zero(const string& path) {
+		std::error_code ec;
+		uint64_t size = path.empty() ? 0 : fs::file_size(path, ec);
+		return ec ? 0 : size;
+	}
+
+	// Consulta de un solo valor REAL sobre recursos_procesos (0 si no hay historial)
+	double query_history(const string& db_path, const char* sql, const string& phase, uint64_t data_bytes) {
+		sqlite3* db;
+		if (sqlite3_open_v2(db_path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+			sqlite3_close(db);
+			return 0.0;
+		}
+		double value = 0.0;
+		sqlite3_stmt* stmt;
+		if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+			sqlite3_bind_text(stmt, 1, phase.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(data_bytes));
+			if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+				value = sqlite3_column_double(stmt, 0);
+			}
+			sqlite3_finalize(stmt);
+		}
+		sqlite3_close(db);
+		return value;
+	}
+
+	// Pico de la misma fase con un dataset del mismo tamaño (mismo trabajo en otra corrida)
+	const char* SAME_JOB_SQL = "SELECT MAX(peak_rss_mb) * 1048576.0 FROM recursos_procesos "
+		"WHERE fase = ?1 AND data_bytes = ?2 AND exit_code = 0;";
+
+	// Memoria por byte de dataset por encima de la base, últimas 20 corridas de la fase
+	const char* PER_BYTE_SQL = "SELECT AVG(MAX(peak_rss_mb * 1048576.0 - ?2, 0) / data_bytes) FROM ("
+		"SELECT peak_rss_mb, data_bytes FROM recursos_procesos "
+		"WHERE fase = ?1 AND exit_code = 0 AND data_bytes > 0 ORDER BY id DESC LIMIT 20);";
+} // namespace
+
+MemoryScheduler::Ticket::Ticket(Ticket&& other) noexcept
+	: owner_(other.owner_), bytes_(other.bytes_) {
+	other.owner_ = nullptr;
+}
+
+MemoryScheduler::Ticket& MemoryScheduler::Ticket::operator=(Ticket&& other) noexcept {
+	if (this != &other) {
+		if (owner_) owner_->release(bytes_);
+		owner_ = other.owner_;
+		bytes_ = other.bytes_;
+		other.owner_ = nullptr;
+	}
+	return *this;
+}
+
+MemoryScheduler::Ticket::~Ticket() {
+	if (owner_) owner_->release(bytes_);
+}
+
+MemoryScheduler::MemoryScheduler(uint64_t cap_bytes, int max_jobs, string db_path)
+	: cap_bytes_(cap_bytes), max_jobs_(max(1, max_jobs)), db_path_(std::move(db_path)) {
+}
+
+JobEstimate MemoryScheduler::estimate(const string& phase, const fs::path& config_path) const {
+	JobEstimate est;
+	auto params = read_config_map(config_path.string());
+	string data = config_get(params, CONFIG_DATA_KEYS);
+	est.data_bytes = file_size_or_zero(data);
+
+	if (est.data_bytes > 0) {
+		double same_job = query_history(db_path_, SAME_JOB_SQL, phase, est.data_bytes);
+		if (same_job > 0.0) {
+			est.memory_bytes = static_cast<uint64_t>(same_job * HISTORY_MARGIN);
+			est.from_history = true;
+			return est;
+		}
+		double per_byte = query_history(db_path_, PER_BYTE_SQL, phase, BASE_PROCESS_BYTES);
+		if (per_byte > 0.0) {
+			est.memory_bytes = BASE_PROCESS_BYTES + static_cast<uint64_t>(per_byte * est.data_bytes * HISTORY_MARGIN);
+			est.from_history = true;
+			return est;
+		}
+	}
+
+	// Heurística sin historial: texto parseado + matriz binned (1 byte por valor con
+	// max_bin <= 255, 2 bytes por encima); ~7 bytes de texto por valor.
+	double size = static_cast<double>(est.data_bytes);
+	if (phase.find("predict") != string::npos) {
+		string model = config_get(params, CONFIG_INPUT_MODEL_KEYS);
+		est.memory_bytes = BASE_PROCESS_BYTES + static_cast<uint64_t>(0.5 * size + 2.0 * file_size_or_zero(model));
+	}
+	else {
+		int max_bin = 255;
+		try { max_bin = stoi(config_get(params, { "max_bin", "max_bins" }, "255")); }
+		catch (const exception&) {}
+		double bin_bytes = max_bin <= 16 ? 0.5 : (max_bin <= 256 ? 1.0 : 2.0);
+		est.memory_bytes = BASE_PROCESS_BYTES + static_cast<uint64_t>(size + (size / 7.0) * bin_bytes);
+	}
+	return est;
+}
+
+MemoryScheduler::Ticket MemoryScheduler::admit(const string& job_name, const JobEstimate& estimate) {
+	unique_lock<mutex> lock(mtx_);
+	uint64_t my_turn = next_ticket_++;
+	uint64_t bytes = estimate.memory_bytes;
+
+	auto fits = [&] {
+		if (running_ >= max_jobs_) return false;
+		// Un trabajo más grande que el tope sólo entra solo
+		return running_ == 0 || in_use_ + bytes <= cap_bytes_;
+	};
+
+	bool queued = !(my_turn == serving_ && fits());
+	if (queued) {
+		printf(YELLOW "[ADMISION] %s en cola: estimado %.0f MB (%s), en uso %.0f/%.0f MB, trabajos %d/%d" RESET "\n",
+			job_name.c_str(), bytes / MB, estimate.from_history ? "historial" : "heuristica",
+			in_use_ / MB, cap_bytes_ / MB, running_, max_jobs_);
+		cv_.wait(lock, [&] { return my_turn == serving_ && fits(); });
+	}
+
+	if (bytes > cap_bytes_) {
+		printf(YELLOW "[ADMISION] %s excede el tope (%.0f > %.0f MB); se ejecuta sin concurrencia" RESET "\n",
+			job_name.c_str(), bytes / MB, cap_bytes_ / MB);
+	}
+	in_use_ += bytes;
+	running_++;
+	serving_++;
+	printf(BLUE "[ADMISION] %s admitido%s: estimado %.0f MB (%s, dataset %.1f MB), en uso %.0f/%.0f MB" RESET "\n",
+		job_name.c_str(), queued ? " tras espera" : "", bytes / MB,
+		estimate.from_history ? "historial" : "heuristica", estimate.data_bytes / MB,
+		in_use_ / MB, cap_bytes_ / MB);
+	cv_.notify_all();
+	return Ticket(this, bytes);
+}
+
+void MemoryScheduler::release(uint64_t bytes) {
+	{
+		lock_guard<mutex> lock(mtx_);
+		in_use_ -= bytes;
+		running_--;
+	}
+	cv_.notify_all();
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+// Control de admisión por memoria para trabajos LightGBM concurrentes
+// (folds, holdout, modelo final, trials de tuning).
+//
+// La memoria de cada trabajo se estima a partir del dataset referenciado por
+// su config (data=), max_bin y el historial de corridas previas guardado en
+// recursos_procesos (pico de memoria por byte de dataset para la misma fase).
+// admit() bloquea mientras la memoria proyectada supere el tope o se haya
+// alcanzado el máximo de trabajos simultáneos; los pedidos se atienden en orden FIFO.
+// Un trabajo que por sí solo excede el tope se admite únicamente con la cola vacía.
+
+struct JobEstimate {
+	uint64_t data_bytes = 0;
+	uint64_t memory_bytes = 0;
+	bool from_history = false;
+};
+
+class MemoryScheduler {
+public:
+	// Reserva de memoria de un trabajo admitido; se libera al destruirse
+	class Ticket {
+	public:
+		Ticket() = default;
+		Ticket(Ticket&& other) noexcept;
+		Ticket& operator=(Ticket&& other) noexcept;
+		~Ticket();
+
+	private:
+		friend class MemoryScheduler;
+		Ticket(MemoryScheduler* owner, uint64_t bytes) : owner_(owner), bytes_(bytes) {}
+		MemoryScheduler* owner_ = nullptr;
+		uint64_t bytes_ = 0;
+	};
+
+	MemoryScheduler(uint64_t cap_bytes, int max_jobs, std::string db_path = "resultados.db");
+
+	// Estima la memoria del trabajo descrito por config_path para la fase dada
+	JobEstimate estimate(const std::string& phase, const std::filesystem::path& config_path) const;
+
+	// Bloquea hasta que el trabajo entra en el presupuesto
+	Ticket admit(const std::string& job_name, const JobEstimate& estimate);
+
+	uint64_t cap_bytes() const { return cap_bytes_; }
+
+private:
+	void release(uint64_t bytes);
+
+	std::mutex mtx_;
+	std::condition_variable cv_;
+	uint64_t cap_bytes_;
+	int max_jobs_;
+	std::string db_path_;
+	uint64_t in_use_ = 0;
+	int running_ = 0;
+	uint64_t next_ticket_ = 0;
+	uint64_t serving_ = 0;
+};
@@ -0,0 +1,252 @@
+#include "stacking.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	const double MIN_PROB = 1e-7;
+
+	inline double log_prob(double p) { return log(max(p, MIN_PROB)); }
+
+	double dot(const vector<double>& a, const vector<double>& b) {
+		double s = 0.0;
+		for (size_t i = 0; i < a.size(); ++i) s += a[i] * b[i];
+		return s;
+	}
+
+	// z = W * f + b para una fila; devuelve el log-sum-exp y deja softmax en z
+	double softmax_row(const double* w, const double* f, int k, double* z) {
+		for (int c = 0; c < k; ++c) {
+			const double* wc = w + c * (k + 1);
+			double v = wc[k];
+			for (int j = 0; j < k; ++j) v += wc[j] * f[j];
+			z[c] = v;
+		}
+		double zmax = *max_element(z, z + k);
+		double sum = 0.0;
+		for (int c = 0; c < k; ++c) {
+			z[c] = exp(z[c] - zmax);
+			sum += z[c];
+		}
+		for (int c = 0; c < k; ++c) z[c] /= sum;
+		return zmax + log(sum);
+	}
+
+	// Pérdida (log-loss medio + L2) y gradiente, repartiendo las filas entre hilos
+	class Objective {
+	public:
+		Objective(const OofMatrix& oof, double l2, int num_threads)
+			: k_(oof.num_classes), n_(oof.rows()), l2_(l2), labels_(oof.labels) {
+			features_.resize(oof.probs.size());
+			for (size_t i = 0; i < oof.probs.size(); ++i) features_[i] = log_prob(oof.probs[i]);
+			// Bloques de al menos 512 filas: con menos el costo de lanzar hilos domina
+			size_t max_useful = max<size_t>(1, n_ / 512);
+			threads_ = static_cast<int>(min<size_t>(max(1, num_threads), max_useful));
+		}
+
+		int threads() const { return threads_; }
+
+		// Término L2 sobre los pesos (el sesgo no se regulariza)
+		double penalty(const vector<double>& w) const {
+			double sum = 0.0;
+			for (int c = 0; c < k_; ++c) {
+				for (int j = 0; j < k_; ++j) sum += w[c * (k_ + 1) + j] * w[c * (k_ + 1) + j];
+			}
+			return 0.5 * l2_ * sum;
+		}
+
+		double operator()(const vector<double>& w, vector<double>& grad) const {
+			size_t dim = w.size();
+			vector<vector<double>> partial_grad(threads_, vector<double>(dim, 0.0));
+			vector<double> partial_loss(threads_, 0.0);
+
+			auto work = [&](int t) {
+				size_t begin = n_ * t / threads_;
+				size_t end = n_ * (t + 1) / threads_;
+				vector<double> z(k_);
+				vector<double>& g = partial_grad[t];
+				double loss = 0.0;
+				for (size_t i = begin; i < end; ++i) {
+					const double* f = features_.data() + i * k_;
+					double lse = softmax_row(w.data(), f, k_, z.data());
+					int y = labels_[i];
+					const double* wy = w.data() + y * (k_ + 1);
+					double zy = wy[k_];
+					for (int j = 0; j < k_; ++j) zy += wy[j] * f[j];
+					loss += lse - zy;
+					z[y] -= 1.0;
+					for (int c = 0; c < k_; ++c) {
+						double* gc = g.data() + c * (k_ + 1);
+						for (int j = 0; j < k_; ++j) gc[j] += z[c] * f[j];
+						gc[k_] += z[c];
+					}
+				}
+				partial_loss[t] = loss;
+			};
+
+			vector<thread> pool;
+			for (int t = 1; t < threads_; ++t) pool.emplace_back(work, t);
+			work(0);
+			for (auto& th : pool) th.join();
+
+			grad.assign(dim, 0.0);
+			double loss = 0.0;
+			for (int t = 0; t < threads_; ++t) {
+				loss += partial_loss[t];
+				for (size_t d = 0; d < dim; ++d) grad[d] += partial_grad[t][d];
+			}
+			double inv_n = 1.0 / static_cast<double>(n_);
+			loss *= inv_n;
+			for (size_t d = 0; d < dim; ++d) grad[d] *= inv_n;
+
+			for (int c = 0; c < k_; ++c) {
+				for (int j = 0; j < k_; ++j) grad[c * (k_ + 1) + j] += l2_ * w[c * (k_ + 1) + j];
+			}
+			return loss + penalty(w);
+		}
+
+	private:
+		int k_;
+		size_t n_;
+		double l2_;
+		int threads_ = 1;
+		const vector<int>& labels_;
+		vector<double> features_;
+	};
+} // namespace
+
+StackingFit train_stacking_model(const OofMatrix& oof, const StackingOptions& options) {
+	TraceSpan span("stacking_lbfgs", "stacking");
+	StackingFit fit;
+	const int k = oof.num_classes;
+	fit.model.num_classes = k;
+	if (k < 2 || oof.rows() == 0) return fit;
+
+	int num_threads = options.num_threads > 0 ? options.num_threads : static_cast<int>(thread::hardware_concurrency());
+	Objective objective(oof, options.l2, num_threads);
+
+	// Punto de partida: identidad sobre las log-probabilidades (softmax(log p) = p),
+	// así la primera pérdida es la del modelo base y L-BFGS sólo puede recalibrar.
+	vector<double> x(k * (k + 1), 0.0);
+	for (int c = 0; c < k; ++c) x[c * (k + 1) + c] = 1.0;
+
+	vector<double> g;
+	double f = objective(x, g);
+	// Las pérdidas informadas son log-loss puro (sin L2), comparables entre sí
+	fit.initial_loss = f - objective.penalty(x);
+
+	deque<vector<double>> s_hist, y_hist;
+	deque<double> rho_hist;
+	vector<double> d(x.size()), x_new(x.size()), g_new;
+
+	int iter = 0;
+	for (; iter < options.max_iterations; ++iter) {
+		// Dirección por recursión de dos lazos
+		d = g;
+		vector<double> alpha(s_hist.size());
+		for (int m = static_cast<int>(s_hist.size()) - 1; m >= 0; --m) {
+			alpha[m] = rho_hist[m] * dot(s_hist[m], d);
+			for (size_t i = 0; i < d.size(); ++i) d[i] -= alpha[m] * y_hist[m][i];
+		}
+		double gamma = s_hist.empty() ? 1.0 / max(1.0, sqrt(dot(g, g)))
+			: dot(s_hist.back(), y_hist.back()) / dot(y_hist.back(), y_hist.back());
+		for (double& v : d) v *= gamma;
+		for (size_t m = 0; m < s_hist.size(); ++m) {
+			double beta = rho_hist[m] * dot(y_hist[m], d);
+			for (size_t i = 0; i < d.size(); ++i) d[i] += s_hist[m][i] * (alpha[m] - beta);
+		}
+		for (double& v : d) v = -v;
+
+		double slope = dot(g, d);
+		if (slope >= 0.0) {
+			// Dirección no descendente: se reinicia la memoria y se usa el gradiente
+			s_hist.clear(); y_hist.clear(); rho_hist.clear();
+			for (size_t i = 0; i < d.size(); ++i) d[i] = -g[i];
+			slope = -dot(g, g);
+		}
+
+		// Búsqueda lineal con backtracking (Armijo)
+		double step = 1.0;
+		double f_new = f;
+		bool accepted = false;
+		for (int ls = 0; ls < 40; ++ls) {
+			for (size_t i = 0; i < x.size(); ++i) x_new[i] = x[i] + step * d[i];
+			f_new = objective(x_new, g_new);
+			if (f_new <= f + 1e-4 * step * slope) {
+				accepted = true;
+				break;
+			}
+			step *= 0.5;
+		}
+		if (!accepted) break;
+
+		vector<double> s(x.size()), y(x.size());
+		for (size_t i = 0; i < x.size(); ++i) {
+			s[i] = x_new[i] - x[i];
+			y[i] = g_new[i] - g[i];
+		}
+		double sy = dot(s, y);
+		if (sy > 1e-12) {
+			s_hist.push_back(std::move(s));
+			y_hist.push_back(std::move(y));
+			rho_hist.push_back(1.0 / sy);
+			if (static_cast<int>(s_hist.size()) > options.history) {
+				s_hist.pop_front(); y_hist.pop_front(); rho_hist.pop_front();
+			}
+		}
+
+		bool converged = f - f_new <= options.tolerance * max(1.0, fabs(f));
+		x.swap(x_new);
+		g.swap(g_new);
+		f = f_new;
+		if (converged) {
+			++iter;
+			break;
+		}
+	}
+
+	fit.final_loss = f - objective.penalty(x);
+	fit.model.weights = std::move(x);
+	fit.iterations = iter;
+	printf("[STACKING] L-BFGS: %d iteraciones, %d hilos, log-loss %.5f -> %.5f\n",
+		iter, objective.threads(), fit.initial_loss, fit.final_loss);
+	return fit;
+}
+
+vector<double> stacking_predict_proba(const StackingModel& model, const vector<double>& probs) {
+	const int k = model.num_classes;
+	vector<double> out(probs.size());
+	vector<double> f(k);
+	for (size_t i = 0; i + k <= probs.size(); i += k) {
+		for (int j = 0; j < k; ++j) f[j] = log_prob(probs[i + j]);
+		softmax_row(model.weights.data(), f.data(), k, out.data() + i);
+	}
+	return out;
+}
+
+bool save_stacking_model(const fs::path& path, const StackingModel& model) {
+	ofstream out(path);
+	if (!out) {
+		cerr << "No se pudo escribir " << path.string() << endl;
+		return false;
+	}
+	// Una fila por clase: pesos sobre log p_0..log p_{k-1} y sesgo al final
+	out << "num_classes=" << model.num_classes << "\n";
+	out << setprecision(17);
+	for (int c = 0; c < model.num_classes; ++c) {
+		for (int j = 0; j <= model.num_classes; ++j) {
+			out << model.weights[c * (model.num_classes + 1) + j] << (j < model.num_classes ? " " : "\n");
+		}
+	}
+	return static_cast<bool>(out);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "oof_store.hpp"
+
+#include <filesystem>
+#include <vector>
+
+// Meta-modelo de segundo nivel: regresión logística multinomial sobre las
+// log-probabilidades OOF de LightGBM, entrenada con L-BFGS (gradiente
+// calculado en paralelo por bloques de filas).
+struct StackingModel {
+	int num_classes = 0;
+	std::vector<double> weights;   // clases x (clases + 1); la última columna es el sesgo
+};
+
+struct StackingOptions {
+	double l2 = 1e-3;              // regularización sobre los pesos (no sobre el sesgo)
+	int max_iterations = 200;
+	int history = 10;              // pares (s, y) que guarda L-BFGS
+	double tolerance = 1e-7;       // mejora relativa mínima de la pérdida
+	int num_threads = 0;           // 0 = hardware_concurrency
+};
+
+struct StackingFit {
+	StackingModel model;
+	int iterations = 0;
+	double initial_loss = 0.0;     // log-loss de las probabilidades OOF sin recalibrar
+	double final_loss = 0.0;       // log-loss del meta-modelo (sin el término L2)
+};
+
+StackingFit train_stacking_model(const OofMatrix& oof, const StackingOptions& options);
+
+// probs: filas x clases (row-major), devuelve las probabilidades recalibradas
+std::vector<double> stacking_predict_proba(const StackingModel& model, const std::vector<double>& probs);
+
+bool save_stacking_model(const std::filesystem::path& path, const StackingModel& model);
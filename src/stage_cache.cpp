@@ -0,0 +1,209 @@
+#include "stage_cache.hpp"
+#include "hashing.hpp"
+#include "journal.hpp"
+#include "trace.hpp"
+
+#include <sqlite3.h>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <random>
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define YELLOW  "\033[33m"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	string now_text() {
+		time_t now = time(0);
+		string fecha = string(ctime(&now));
+		fecha.pop_back(); // quitar salto de línea
+		return fecha;
+	}
+
+	sqlite3* open_cache(const string& db_path) {
+		sqlite3* db;
+		if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
+			cerr << "No se puede abrir la base de datos: " << sqlite3_errmsg(db) << endl;
+			sqlite3_close(db);
+			return nullptr;
+		}
+		sqlite3_busy_timeout(db, 5000);
+		sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS cache_etapas ("
+			"huella TEXT NOT NULL, "
+			"salida TEXT NOT NULL, "
+			"hash TEXT NOT NULL, "
+			"bytes INTEGER, "
+			"etapa TEXT, "
+			"tipo TEXT, "
+			"creado TEXT, "
+			"usos INTEGER DEFAULT 0, "
+			"ultimo_uso TEXT, "
+			"PRIMARY KEY (huella, salida));", nullptr, nullptr, nullptr);
+		return db;
+	}
+
+	// Copia a destino pasando por un temporal propio, así nunca queda un archivo a medias
+	// y dos trabajos que guardan el mismo objeto a la vez no se pisan el temporal
+	bool copy_atomic(const fs::path& from, const fs::path& to) {
+		std::error_code ec;
+		if (to.has_parent_path()) fs::create_directories(to.parent_path(), ec);
+		fs::path tmp = to;
+		tmp += ".tmp" + to_string(random_device{}());
+		fs::copy_file(from, tmp, fs::copy_options::overwrite_existing, ec);
+		if (!ec) fs::rename(tmp, to, ec);
+		if (ec) {
+			cerr << YELLOW << "[WARN] No se pudo copiar " << from.string() << " a " << to.string()
+				<< ": " << ec.message() << RESET << endl;
+			fs::remove(tmp, ec);
+			return false;
+		}
+		return true;
+	}
+} // namespace
+
+string stage_fingerprint(const StageSpec& spec) {
+	TraceSpan span("hash_entradas", "io");
+	Fnv1a h;
+	h.update(spec.kind);
+	for (const auto& input : spec.inputs) {
+		h.update(input.generic_string());
+		if (!h.update_file(input)) h.update("<sin archivo>");
+	}
+	for (const auto& output : spec.outputs) h.update(output.generic_string());
+	h.update(spec.extra);
+	return h.hex();
+}
+
+bool stage_outputs_exist(const StageSpec& spec) {
+	for (const auto& output : spec.outputs) {
+		if (!fs::exists(output)) return false;
+	}
+	return true;
+}
+
+StageSpec lightgbm_stage(const string& name, const string& kind, const fs::path& config, const string& extra) {
+	StageSpec spec;
+	spec.name = name;
+	spec.kind = kind;
+	spec.inputs.push_back(config);
+	for (const fs::path& input : lightgbm_inputs(config)) spec.inputs.push_back(input);
+	spec.outputs = lightgbm_outputs(config);
+	spec.extra = extra;
+	return spec;
+}
+
+StageCache::StageCache(string db_path, fs::path root, bool enabled)
+	: db_path_(std::move(db_path)), root_(std::move(root)), enabled_(enabled) {
+}
+
+bool StageCache::restore(const StageSpec& spec, const string& fingerprint) {
+	if (!enabled_ || spec.outputs.empty()) return false;
+	TraceSpan span("cache_restaurar", "cache");
+
+	// El lock cubre sólo el índice; los artefactos se copian fuera de él
+	map<string, string> objects;
+	{
+		lock_guard<mutex> lock(mtx_);
+		sqlite3* db = open_cache(db_path_);
+		if (!db) return false;
+		sqlite3_stmt* stmt;
+		if (sqlite3_prepare_v2(db, "SELECT salida, hash FROM cache_etapas WHERE huella = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+			sqlite3_bind_text(stmt, 1, fingerprint.c_str(), -1, SQLITE_STATIC);
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				objects[reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))] =
+					reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+			}
+			sqlite3_finalize(stmt);
+		}
+		sqlite3_close(db);
+	}
+
+	// Todas las salidas tienen que estar en la cache antes de tocar ninguna
+	bool ok = true;
+	for (const auto& output : spec.outputs) {
+		auto it = objects.find(output.generic_string());
+		if (it == objects.end() || !fs::exists(root_ / "objects" / it->second)) ok = false;
+	}
+	uint64_t bytes = 0;
+	for (size_t i = 0; ok && i < spec.outputs.size(); ++i) {
+		const fs::path& output = spec.outputs[i];
+		fs::path object = root_ / "objects" / objects[output.generic_string()];
+		// Si el archivo actual ya es ese objeto no hace falta copiarlo
+		if (!(fs::exists(output) && hash_file_hex(output) == objects[output.generic_string()])) {
+			ok = copy_atomic(object, output);
+		}
+		std::error_code ec;
+		if (ok) bytes += fs::file_size(output, ec);
+	}
+	if (!ok) return false;
+
+	lock_guard<mutex> lock(mtx_);
+	sqlite3* db = open_cache(db_path_);
+	sqlite3_stmt* stmt;
+	if (db && sqlite3_prepare_v2(db, "UPDATE cache_etapas SET usos = usos + 1, ultimo_uso = ? WHERE huella = ?;",
+		-1, &stmt, nullptr) == SQLITE_OK) {
+		string fecha = now_text();
+		sqlite3_bind_text(stmt, 1, fecha.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(stmt, 2, fingerprint.c_str(), -1, SQLITE_STATIC);
+		sqlite3_step(stmt);
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_close(db);
+	++hits_;
+	restored_bytes_ += bytes;
+	return true;
+}
+
+bool StageCache::store(const StageSpec& spec, const string& fingerprint) {
+	if (!enabled_ || spec.outputs.empty()) return false;
+	TraceSpan span("cache_guardar", "cache");
+
+	// Objetos primero (sólo los de contenido nuevo), fuera del lock; las filas después,
+	// con el lock y en una transacción
+	vector<pair<string, uint64_t>> hashes;
+	for (const auto& output : spec.outputs) {
+		string hash = hash_file_hex(output);
+		if (hash.empty()) return false;
+		fs::path object = root_ / "objects" / hash;
+		if (!fs::exists(object) && !copy_atomic(output, object)) return false;
+		std::error_code ec;
+		hashes.emplace_back(hash, fs::file_size(output, ec));
+	}
+
+	lock_guard<mutex> lock(mtx_);
+	sqlite3* db = open_cache(db_path_);
+	if (!db) return false;
+	bool ok = sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK;
+	sqlite3_stmt* stmt;
+	if (ok && sqlite3_prepare_v2(db, "INSERT INTO cache_etapas (huella, salida, hash, bytes, etapa, tipo, creado) "
+		"VALUES (?, ?, ?, ?, ?, ?, ?) "
+		"ON CONFLICT(huella, salida) DO UPDATE SET hash = excluded.hash, bytes = excluded.bytes, "
+		"etapa = excluded.etapa, creado = excluded.creado;", -1, &stmt, nullptr) == SQLITE_OK) {
+		string fecha = now_text();
+		for (size_t i = 0; ok && i < spec.outputs.size(); ++i) {
+			string salida = spec.outputs[i].generic_string();
+			sqlite3_bind_text(stmt, 1, fingerprint.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, salida.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_text(stmt, 3, hashes[i].first.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int64(stmt, 4, static_cast<sqlite3_int64>(hashes[i].second));
+			sqlite3_bind_text(stmt, 5, spec.name.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 6, spec.kind.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 7, fecha.c_str(), -1, SQLITE_TRANSIENT);
+			ok = sqlite3_step(stmt) == SQLITE_DONE;
+			sqlite3_reset(stmt);
+		}
+		sqlite3_finalize(stmt);
+	}
+	else {
+		ok = false;
+	}
+	if (!ok) cerr << "Error en cache_etapas (" << spec.name << "): " << sqlite3_errmsg(db) << endl;
+	sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+	sqlite3_close(db);
+	if (ok) ++stores_;
+	return ok;
+}
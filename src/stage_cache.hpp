@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Etapa del pipeline declarada por sus entradas y salidas. La huella es el hash
+// FNV-1a de la ruta y el contenido de cada entrada (más extra: parámetros que no
+// son archivos, ej. el binario de LightGBM); si ya hay salidas guardadas con esa
+// huella la etapa no se ejecuta y se restauran sus artefactos.
+struct StageSpec {
+	std::string name;                              // etapa del journal, ej. entrenar_fold_3
+	std::string kind;                              // train, predict, evaluate, plot, final, infer...
+	std::vector<std::filesystem::path> inputs;
+	std::vector<std::filesystem::path> outputs;
+	std::string extra;
+	// false: sus salidas no quedan en disco (predicción por FIFO sin copia), así que
+	// ni la cache ni --resume pueden reutilizarla y se corre siempre
+	bool reusable = true;
+};
+
+std::string stage_fingerprint(const StageSpec& spec);
+
+bool stage_outputs_exist(const StageSpec& spec);
+
+// Etapa LightGBM: entradas = config + data/valid/input_model, salidas = output_model/output_result
+StageSpec lightgbm_stage(const std::string& name, const std::string& kind, const std::filesystem::path& config,
+	const std::string& extra = "");
+
+// Cache de salidas de etapas entre corridas (carpeta cache_etapas/):
+//   cache_etapas/objects/<hash>   cada artefacto una sola vez, por hash de contenido
+// Tabla cache_etapas de resultados.db: huella -> (salida, hash del artefacto).
+// Al restaurar se copia el objeto (no link): LightGBM reescribe sus salidas en el
+// lugar y pisaría el objeto compartido.
+class StageCache {
+public:
+	StageCache(std::string db_path = "resultados.db", std::filesystem::path root = "cache_etapas", bool enabled = true);
+
+	bool enabled() const { return enabled_; }
+
+	// Copia a spec.outputs los artefactos guardados con esa huella; false si falta alguno
+	bool restore(const StageSpec& spec, const std::string& fingerprint);
+
+	// Guarda las salidas (ya existentes) de la etapa bajo la huella
+	bool store(const StageSpec& spec, const std::string& fingerprint);
+
+	int hits() const { return hits_; }
+	int stores() const { return stores_; }
+	uint64_t restored_bytes() const { return restored_bytes_; }
+
+private:
+	std::string db_path_;
+	std::filesystem::path root_;
+	bool enabled_;
+	int hits_ = 0;
+	int stores_ = 0;
+	uint64_t restored_bytes_ = 0;
+	std::mutex mtx_;   // índice (tabla cache_etapas) y contadores; las copias van sin lock
+};
@@ -0,0 +1,262 @@
+#include "trace.hpp"
+
+#include <sqlite3.h>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define RED     "\033[31m"
+#define GREEN   "\033[32m"
+#define YELLOW  "\033[33m"
+#define CYAN    "\033[36m"
+#define BOLD    "\033[1m"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	struct TraceEvent {
+		string name;
+		const char* category;
+		int64_t ts_us;
+		int64_t dur_us;
+		int fold;
+	};
+
+	// Buffer por hilo: solo su dueño escribe; el lock sólo se disputa al exportar.
+	struct ThreadBuffer {
+		int tid;
+		string thread_name;
+		mutex mtx;
+		vector<TraceEvent> events;
+	};
+
+	struct TraceRegistry {
+		mutex mtx;
+		vector<shared_ptr<ThreadBuffer>> buffers;
+		chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+	};
+
+	TraceRegistry& registry() {
+		static TraceRegistry reg;
+		return reg;
+	}
+
+	ThreadBuffer& local_buffer() {
+		thread_local shared_ptr<ThreadBuffer> buf;
+		if (!buf) {
+			buf = make_shared<ThreadBuffer>();
+			buf->events.reserve(256);
+			TraceRegistry& reg = registry();
+			lock_guard<mutex> lock(reg.mtx);
+			buf->tid = static_cast<int>(reg.buffers.size());
+			buf->thread_name = (buf->tid == 0) ? "main" : "hilo_" + to_string(buf->tid);
+			reg.buffers.push_back(buf);
+		}
+		return *buf;
+	}
+
+	int64_t now_us() {
+		return chrono::duration_cast<chrono::microseconds>(
+			chrono::steady_clock::now() - registry().epoch).count();
+	}
+
+	// Copia de todos los eventos (con el tid del buffer de origen)
+	struct Snapshot {
+		vector<pair<int, TraceEvent>> events;
+		vector<pair<int, string>> threads;
+	};
+
+	Snapshot snapshot() {
+		Snapshot snap;
+		TraceRegistry& reg = registry();
+		lock_guard<mutex> lock(reg.mtx);
+		for (const auto& buf : reg.buffers) {
+			lock_guard<mutex> buf_lock(buf->mtx);
+			snap.threads.emplace_back(buf->tid, buf->thread_name);
+			for (const auto& ev : buf->events) snap.events.emplace_back(buf->tid, ev);
+		}
+		return snap;
+	}
+
+	struct PhaseSummary {
+		string category;
+		int calls = 0;
+		double total_ms = 0.0;
+		double max_ms = 0.0;
+	};
+
+	map<string, PhaseSummary> summarize(const Snapshot& snap) {
+		map<string, PhaseSummary> out;
+		for (const auto& [tid, ev] : snap.events) {
+			PhaseSummary& s = out[ev.name];
+			s.category = ev.category;
+			double ms = ev.dur_us / 1000.0;
+			s.calls++;
+			s.total_ms += ms;
+			s.max_ms = max(s.max_ms, ms);
+		}
+		return out;
+	}
+
+	string json_escape(const string& s) {
+		ostringstream o;
+		for (char c : s) {
+			switch (c) {
+			case '\"': o << "\\\""; break;
+			case '\\': o << "\\\\"; break;
+			case '\n': o << "\\n"; break;
+			case '\r': o << "\\r"; break;
+			case '\t': o << "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					o << "\\u" << hex << setw(4) << setfill('0') << int(c) << dec;
+				}
+				else o << c;
+			}
+		}
+		return o.str();
+	}
+} // namespace
+
+TraceSpan::TraceSpan(string name, const char* category, int fold)
+	: name_(std::move(name)), category_(category), fold_(fold), start_us_(now_us()) {
+}
+
+TraceSpan::~TraceSpan() {
+	int64_t end_us = now_us();
+	ThreadBuffer& buf = local_buffer();
+	lock_guard<mutex> lock(buf.mtx);
+	buf.events.push_back({ std::move(name_), category_, start_us_, end_us - start_us_, fold_ });
+}
+
+void trace_set_thread_name(const string& name) {
+	ThreadBuffer& buf = local_buffer();
+	lock_guard<mutex> lock(buf.mtx);
+	buf.thread_name = name;
+}
+
+bool trace_export_chrome(const fs::path& out_json) {
+	Snapshot snap = snapshot();
+	ofstream out(out_json);
+	if (!out) {
+		cerr << YELLOW << "[WARN] No se pudo escribir la traza en " << out_json.string() << RESET << endl;
+		return false;
+	}
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (const auto& [tid, name] : snap.threads) {
+		out << (first ? "" : ",\n")
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+			<< ",\"args\":{\"name\":\"" << json_escape(name) << "\"}}";
+		first = false;
+	}
+	for (const auto& [tid, ev] : snap.events) {
+		out << (first ? "" : ",\n")
+			<< "{\"name\":\"" << json_escape(ev.name) << "\",\"cat\":\"" << ev.category
+			<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+			<< ",\"ts\":" << ev.ts_us << ",\"dur\":" << ev.dur_us;
+		if (ev.fold >= 0) out << ",\"args\":{\"fold\":" << ev.fold << "}";
+		out << "}";
+		first = false;
+	}
+	out << "\n]}\n";
+	return true;
+}
+
+void trace_print_summary() {
+	auto phases = summarize(snapshot());
+	if (phases.empty()) return;
+
+	vector<pair<string, PhaseSummary>> rows(phases.begin(), phases.end());
+	sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) { return a.second.total_ms > b.second.total_ms; });
+
+	cout << CYAN << BOLD << "\n==== TIEMPOS POR FASE ====" << RESET << endl;
+	cout << left << setw(34) << "fase" << setw(10) << "categoria" << right << setw(8) << "n"
+		<< setw(14) << "total(ms)" << setw(12) << "media(ms)" << setw(12) << "max(ms)" << endl;
+	cout << fixed << setprecision(1);
+	for (const auto& [name, s] : rows) {
+		cout << left << setw(34) << name << setw(10) << s.category << right << setw(8) << s.calls
+			<< setw(14) << s.total_ms << setw(12) << (s.total_ms / s.calls) << setw(12) << s.max_ms << endl;
+	}
+	cout << defaultfloat << setprecision(6);
+}
+
+bool trace_save_summary_sqlite(const string& db_path, const string& run_id) {
+	auto phases = summarize(snapshot());
+	if (phases.empty()) return true;
+
+	sqlite3* db;
+	if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
+		cerr << "No se puede abrir la base de datos: " << sqlite3_errmsg(db) << endl;
+		sqlite3_close(db);
+		return false;
+	}
+
+	const char* create_sql = "CREATE TABLE IF NOT EXISTS trazas_fases ("
+		"id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		"run_id TEXT, "
+		"fecha TEXT, "
+		"fase TEXT, "
+		"categoria TEXT, "
+		"llamadas INTEGER, "
+		"total_ms REAL, "
+		"media_ms REAL, "
+		"max_ms REAL);";
+	sqlite3_exec(db, create_sql, nullptr, nullptr, nullptr);
+
+	time_t now = time(0);
+	string fecha = string(ctime(&now));
+	fecha.pop_back(); // quitar salto de línea
+
+	sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+	const char* insert_sql = "INSERT INTO trazas_fases (run_id, fecha, fase, categoria, llamadas, total_ms, media_ms, max_ms) "
+		"VALUES (?, ?, ?, ?, ?, ?, ?, ?);";
+	sqlite3_stmt* stmt;
+	bool ok = sqlite3_prepare_v2(db, insert_sql, -1, &stmt, nullptr) == SQLITE_OK;
+	if (ok) {
+		for (const auto& [name, s] : phases) {
+			sqlite3_bind_text(stmt, 1, run_id.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, fecha.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, name.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 4, s.category.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int(stmt, 5, s.calls);
+			sqlite3_bind_double(stmt, 6, s.total_ms);
+			sqlite3_bind_double(stmt, 7, s.total_ms / s.calls);
+			sqlite3_bind_double(stmt, 8, s.max_ms);
+			if (sqlite3_step(stmt) != SQLITE_DONE) {
+				cerr << "Error insertando traza: " << sqlite3_errmsg(db) << endl;
+				ok = false;
+			}
+			sqlite3_reset(stmt);
+		}
+		sqlite3_finalize(stmt);
+	}
+	sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+	sqlite3_close(db);
+	return ok;
+}
+
+TraceSession::TraceSession(string run_id, fs::path out_json, string db_path)
+	: run_id_(std::move(run_id)), out_json_(std::move(out_json)), db_path_(std::move(db_path)) {
+	trace_set_thread_name("main");
+}
+
+TraceSession::~TraceSession() {
+	trace_print_summary();
+	if (trace_export_chrome(out_json_)) {
+		cout << GREEN << "[OK] Traza exportada: " << out_json_.string() << RESET << endl;
+	}
+	trace_save_summary_sqlite(db_path_, run_id_);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Trazas por fase del pipeline.
+//
+// Cada TraceSpan mide un bloque (fold, entrenamiento, prediccion, SQLite,
+// scripts Python, ...) y lo guarda en un buffer propio del hilo, por lo que
+// folds concurrentes e hilos en segundo plano no compiten por un lock.
+// Al cerrar la corrida se exporta:
+// - traza_pipeline.json: formato Chrome trace-event (chrome://tracing / Perfetto)
+// - tabla trazas_fases en resultados.db: resumen por fase (llamadas, total, media, max)
+//
+// Uso:
+//   { TraceSpan span("lightgbm_train", "proceso", fold); ...trabajo... }
+
+class TraceSpan {
+public:
+	TraceSpan(std::string name, const char* category = "fase", int fold = -1);
+	~TraceSpan();
+
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+	std::string name_;
+	const char* category_;
+	int fold_;
+	int64_t start_us_;
+};
+
+// Nombre legible del hilo actual en la traza (ej. "main", "fold_2").
+void trace_set_thread_name(const std::string& name);
+
+// Exporta todos los eventos registrados hasta el momento como JSON Chrome trace-event.
+bool trace_export_chrome(const std::filesystem::path& out_json);
+
+// Persiste el resumen por fase en la tabla trazas_fases de db_path.
+bool trace_save_summary_sqlite(const std::string& db_path, const std::string& run_id);
+
+// Imprime en consola la tabla resumen por fase.
+void trace_print_summary();
+
+// Sesión de trazado de una corrida: al destruirse (cualquier return de main)
+// exporta el JSON, imprime el resumen y lo guarda en SQLite.
+class TraceSession {
+public:
+	TraceSession(std::string run_id, std::filesystem::path out_json, std::string db_path);
+	~TraceSession();
+
+	TraceSession(const TraceSession&) = delete;
+	TraceSession& operator=(const TraceSession&) = delete;
+
+private:
+	std::string run_id_;
+	std::filesystem::path out_json_;
+	std::string db_path_;
+};
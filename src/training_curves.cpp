@@ -0,0 +1,248 @@
+#include "training_curves.hpp"
+#include "io_utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+// Códigos ANSI para color
+#define RESET   "\033[0m"
+#define GREEN   "\033[32m"
+#define YELLOW  "\033[33m"
+#define CYAN    "\033[36m"
+#define BOLD    "\033[1m"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	string trim(const string& s) {
+		size_t b = s.find_first_not_of(" \t\r\n");
+		if (b == string::npos) return string();
+		size_t e = s.find_last_not_of(" \t\r\n");
+		return s.substr(b, e - b + 1);
+	}
+
+	double seconds_between(chrono::steady_clock::time_point a, chrono::steady_clock::time_point b) {
+		return chrono::duration<double>(b - a).count();
+	}
+} // namespace
+
+bool metric_higher_is_better(const string& metric) {
+	for (const char* prefix : { "auc", "ndcg", "map", "average_precision" }) {
+		if (metric.rfind(prefix, 0) == 0) return true;
+	}
+	return false;
+}
+
+int TrainingCurve::best_iteration() const {
+	int best = 0;
+	bool higher = higher_is_better();
+	for (size_t i = 0; i < values.size(); ++i) {
+		if (std::isnan(values[i])) continue;
+		if (best == 0 || (higher ? values[i] > values[best - 1] : values[i] < values[best - 1])) best = static_cast<int>(i) + 1;
+	}
+	return best;
+}
+
+bool parse_iteration_metric(const string& line, int& iteration, string& dataset, string& metric, double& value) {
+	size_t pos = line.find("Iteration:");
+	if (pos == string::npos) return false;
+	const char* start = line.c_str() + pos + 10;
+	char* end = nullptr;
+	long it = strtol(start, &end, 10);
+	if (end == start || it <= 0 || *end != ',') return false;
+	string rest = end + 1;
+	size_t colon = rest.rfind(" : ");
+	if (colon == string::npos) return false;
+	string head = trim(rest.substr(0, colon));
+	size_t space = head.find(' ');
+	if (space == string::npos) return false;
+	const char* number = rest.c_str() + colon + 3;
+	char* number_end = nullptr;
+	double v = strtod(number, &number_end);
+	if (number_end == number) return false;
+	iteration = static_cast<int>(it);
+	dataset = head.substr(0, space);
+	metric = trim(head.substr(space + 1));
+	value = v;
+	return !metric.empty();
+}
+
+int configured_iterations(const fs::path& config) {
+	auto params = read_config_map(config.string());
+	string value = config_get(params, CONFIG_ITERATION_KEYS, "100");
+	int iterations = atoi(value.c_str());
+	return iterations > 0 ? iterations : 100;
+}
+
+TrainingMonitor::TrainingMonitor(const string& stage, int fold, int total_iterations, double progress_seconds)
+	: stage_(stage), fold_(fold), total_(total_iterations), progress_seconds_(progress_seconds) {}
+
+void TrainingMonitor::on_line(const string& line) {
+	int iteration;
+	string dataset, metric;
+	double value;
+	if (parse_iteration_metric(line, iteration, dataset, metric, value)) {
+		TrainingCurve* curve = nullptr;
+		for (TrainingCurve& c : curves_) {
+			if (c.dataset == dataset && c.metric == metric) curve = &c;
+		}
+		if (!curve) {
+			curves_.push_back(TrainingCurve());
+			curve = &curves_.back();
+			curve->stage = stage_;
+			curve->fold = fold_;
+			curve->dataset = dataset;
+			curve->metric = metric;
+		}
+		if (curve->values.size() < static_cast<size_t>(iteration)) {
+			curve->values.resize(iteration, numeric_limits<float>::quiet_NaN());
+		}
+		curve->values[iteration - 1] = static_cast<float>(value);
+		note_iteration(iteration);
+		return;
+	}
+	// Sin conjuntos de validación LightGBM sólo informa "finished iteration N"
+	size_t pos = line.find("finished iteration ");
+	if (pos != string::npos) {
+		int it = atoi(line.c_str() + pos + 19);
+		if (it > 0) note_iteration(it);
+	}
+}
+
+void TrainingMonitor::note_iteration(int iteration) {
+	auto now = chrono::steady_clock::now();
+	if (!started_) {
+		started_ = true;
+		first_ = now;
+		last_print_ = now;
+		first_iteration_ = iteration;
+	}
+	iterations_ = max(iterations_, iteration);
+	last_iteration_ = now;
+	if (progress_seconds_ > 0.0 && seconds_between(last_print_, now) >= progress_seconds_) {
+		print_progress(false);
+		last_print_ = now;
+	}
+}
+
+double TrainingMonitor::seconds() const {
+	return started_ ? seconds_between(first_, last_iteration_) : 0.0;
+}
+
+double TrainingMonitor::iterations_per_second() const {
+	double s = seconds();
+	return s > 0.0 ? (iterations_ - first_iteration_) / s : 0.0;
+}
+
+void TrainingMonitor::finish() {
+	if (started_ && progress_seconds_ > 0.0) print_progress(true);
+}
+
+void TrainingMonitor::print_progress(bool final_line) {
+	double rate = iterations_per_second();
+	string metric;
+	for (const TrainingCurve& c : curves_) {
+		// La primera métrica de validación (o la de training si no hay validación)
+		if (!metric.empty() && c.dataset == "training") continue;
+		if (c.values.empty() || std::isnan(c.values.back())) continue;
+		char buf[128];
+		if (final_line) {
+			int best = c.best_iteration();
+			snprintf(buf, sizeof(buf), " | %s %s mejor %.5g en la iteracion %d", c.dataset.c_str(), c.metric.c_str(),
+				c.values[best - 1], best);
+		}
+		else {
+			snprintf(buf, sizeof(buf), " | %s %s %.5g", c.dataset.c_str(), c.metric.c_str(), c.values.back());
+		}
+		metric = buf;
+		if (c.dataset != "training") break;
+	}
+	if (final_line) {
+		printf("[PROGRESO] %s: %d iteraciones en %.1f s (%.1f it/s)%s\n", stage_.c_str(), iterations_, seconds(), rate,
+			metric.c_str());
+		return;
+	}
+	double eta = rate > 0.0 ? max(0, total_ - iterations_) / rate : 0.0;
+	printf("[PROGRESO] %s: iteracion %d/%d (%.0f%%) | %.1f it/s | ETA %.1f s%s\n", stage_.c_str(), iterations_, total_,
+		total_ > 0 ? 100.0 * iterations_ / total_ : 0.0, rate, eta, metric.c_str());
+}
+
+double IterationAdvice::degradation() const {
+	if (best_value == 0.0) return 0.0;
+	return (metric_higher_is_better(metric) ? best_value - last_value : last_value - best_value) / fabs(best_value);
+}
+
+IterationAdvice recommend_iterations(const vector<TrainingCurve>& curves, int configured, double data_scale) {
+	IterationAdvice advice;
+	advice.configured = configured;
+	advice.data_scale = data_scale;
+	// Referencia: la primera métrica del primer conjunto de validación
+	for (const TrainingCurve& c : curves) {
+		if (c.dataset != "training" && !c.values.empty()) {
+			advice.dataset = c.dataset;
+			advice.metric = c.metric;
+			break;
+		}
+	}
+	if (advice.metric.empty()) return advice;
+
+	vector<const TrainingCurve*> selected;
+	size_t common = numeric_limits<size_t>::max();
+	for (const TrainingCurve& c : curves) {
+		if (c.dataset != advice.dataset || c.metric != advice.metric || c.values.empty()) continue;
+		selected.push_back(&c);
+		common = min(common, c.values.size());
+		advice.fold_best.push_back(c.best_iteration());
+	}
+	// Curva media sobre las iteraciones que tienen todas las curvas
+	vector<double> mean(common, 0.0);
+	vector<int> counts(common, 0);
+	for (const TrainingCurve* c : selected) {
+		for (size_t i = 0; i < common; ++i) {
+			if (std::isnan(c->values[i])) continue;
+			mean[i] += c->values[i];
+			counts[i]++;
+		}
+	}
+	bool higher = selected.front()->higher_is_better();
+	for (size_t i = 0; i < common; ++i) {
+		if (counts[i] == 0) continue;
+		mean[i] /= counts[i];
+		if (advice.best_iteration == 0 || (higher ? mean[i] > advice.best_value : mean[i] < advice.best_value)) {
+			advice.best_iteration = static_cast<int>(i) + 1;
+			advice.best_value = mean[i];
+		}
+		advice.last_iteration = static_cast<int>(i) + 1;
+		advice.last_value = mean[i];
+	}
+	if (advice.best_iteration == 0) return advice;
+	advice.curves = static_cast<int>(selected.size());
+	advice.recommended = max(1, static_cast<int>(lround(advice.best_iteration * data_scale)));
+	advice.ok = true;
+	return advice;
+}
+
+void print_iteration_advice(const IterationAdvice& advice) {
+	cout << CYAN << BOLD << "\n==== CURVAS DE VALIDACION (" << advice.dataset << " " << advice.metric << ", "
+		<< advice.curves << " entrenamientos) ====" << RESET << endl;
+	printf("Curva media: mejor %.5f en la iteracion %d | iteracion %d: %.5f (%+.2f%%)\n", advice.best_value,
+		advice.best_iteration, advice.last_iteration, advice.last_value, 100.0 * advice.degradation());
+	string folds;
+	for (int b : advice.fold_best) folds += " " + to_string(b);
+	printf("Mejor iteracion por entrenamiento:%s\n", folds.c_str());
+	if (advice.degradation() > 0.01) {
+		cout << YELLOW << "[AVISO] La validacion empeora despues de la iteracion " << advice.best_iteration
+			<< ": las iteraciones restantes sobreajustan" << RESET << endl;
+	}
+	else if (advice.best_iteration == advice.last_iteration) {
+		cout << YELLOW << "[AVISO] La curva media sigue mejorando en la ultima iteracion: num_iterations podria subir" << RESET << endl;
+	}
+	printf("%s[EARLY STOPPING] num_iterations del modelo final: %d -> recomendado %d (iteracion %d x %.2f por el tamano de train_all)%s\n",
+		advice.recommended == advice.configured ? GREEN : YELLOW, advice.configured, advice.recommended,
+		advice.best_iteration, advice.data_scale, RESET);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Curvas de entrenamiento de LightGBM: las líneas "Iteration:N, valid_1
+// multi_logloss : 0.85" que imprime cada proceso se parsean a medida que llegan
+// (por el callback de run_child), con una línea de progreso periódica por
+// trabajo (iteraciones/s y ETA). Las curvas se guardan en SQLite como float32 y,
+// antes del modelo final, las de validación de los folds dan una recomendación
+// de num_iterations (mínimo de la curva media, como haría el early stopping).
+
+// auc, ndcg, map y average_precision se maximizan; el resto de las métricas se minimiza
+bool metric_higher_is_better(const std::string& metric);
+
+// Una métrica sobre un conjunto (training, valid_1, ...) por iteración
+struct TrainingCurve {
+	std::string stage;                 // etapa (entrenar_fold_3, entrenar_final, ...)
+	int fold = -1;
+	std::string dataset;
+	std::string metric;
+	std::vector<float> values;         // values[i] = iteración i + 1 (NaN si no se informó)
+
+	bool higher_is_better() const { return metric_higher_is_better(metric); }
+	int best_iteration() const;        // 1-based; 0 si no hay valores
+};
+
+// Parsea "Iteration:N, <conjunto> <métrica> : <valor>" (false si la línea no es de métricas)
+bool parse_iteration_metric(const std::string& line, int& iteration, std::string& dataset, std::string& metric,
+	double& value);
+
+// num_iterations del config (o sus alias); 100 si no está, como LightGBM
+int configured_iterations(const std::filesystem::path& config);
+
+// Recibe la salida de un entrenamiento mientras corre
+class TrainingMonitor {
+public:
+	// progress_seconds: cada cuánto imprimir la línea de progreso (0 = nunca)
+	TrainingMonitor(const std::string& stage, int fold, int total_iterations, double progress_seconds);
+
+	void on_line(const std::string& line);
+	// Última línea de progreso con el total
+	void finish();
+
+	const std::string& stage() const { return stage_; }
+	const std::vector<TrainingCurve>& curves() const { return curves_; }
+	int iterations() const { return iterations_; }
+	double seconds() const;            // desde la primera iteración informada
+	double iterations_per_second() const;
+
+private:
+	void note_iteration(int iteration);
+	void print_progress(bool final_line);
+
+	std::string stage_;
+	int fold_;
+	int total_;
+	double progress_seconds_;
+	int iterations_ = 0;
+	int first_iteration_ = 0;
+	bool started_ = false;
+	std::chrono::steady_clock::time_point first_;
+	std::chrono::steady_clock::time_point last_iteration_;
+	std::chrono::steady_clock::time_point last_print_;
+	std::vector<TrainingCurve> curves_;
+};
+
+// Recomendación de num_iterations para el modelo final a partir de las curvas de
+// validación de los folds (primera métrica del primer conjunto de validación)
+struct IterationAdvice {
+	bool ok = false;
+	std::string dataset;
+	std::string metric;
+	int curves = 0;                    // folds (y semillas/repeticiones) promediados
+	int configured = 0;                // num_iterations del config final
+	int best_iteration = 0;            // mínimo (o máximo) de la curva media
+	double best_value = 0.0;
+	double last_value = 0.0;           // curva media en la última iteración común
+	int last_iteration = 0;
+	double data_scale = 1.0;           // filas de train_all / filas de un fold de entrenamiento
+	int recommended = 0;               // best_iteration x data_scale
+	std::vector<int> fold_best;        // mejor iteración de cada curva
+	// Empeoramiento relativo de la última iteración respecto del mejor valor (sobreajuste)
+	double degradation() const;
+};
+
+IterationAdvice recommend_iterations(const std::vector<TrainingCurve>& curves, int configured, double data_scale);
+
+void print_iteration_advice(const IterationAdvice& advice);
@@ -0,0 +1,359 @@
+#include "tree_shap.hpp"
+#include "io_utils.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <thread>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+	// ---- TreeSHAP path-dependent (mismo algoritmo que Tree::TreeSHAP de LightGBM) ----
+	struct PathElement {
+		int feature_index;
+		double zero_fraction;
+		double one_fraction;
+		double pweight;
+	};
+
+	void extend_path(PathElement* path, int depth, double zero_fraction, double one_fraction, int feature_index) {
+		path[depth].feature_index = feature_index;
+		path[depth].zero_fraction = zero_fraction;
+		path[depth].one_fraction = one_fraction;
+		path[depth].pweight = depth == 0 ? 1.0 : 0.0;
+		for (int i = depth - 1; i >= 0; i--) {
+			path[i + 1].pweight += one_fraction * path[i].pweight * (i + 1) / static_cast<double>(depth + 1);
+			path[i].pweight = zero_fraction * path[i].pweight * (depth - i) / static_cast<double>(depth + 1);
+		}
+	}
+
+	void unwind_path(PathElement* path, int depth, int path_index) {
+		const double one_fraction = path[path_index].one_fraction;
+		const double zero_fraction = path[path_index].zero_fraction;
+		double next_one_portion = path[depth].pweight;
+		for (int i = depth - 1; i >= 0; --i) {
+			if (one_fraction != 0) {
+				const double tmp = path[i].pweight;
+				path[i].pweight = next_one_portion * (depth + 1) / static_cast<double>((i + 1) * one_fraction);
+				next_one_portion = tmp - path[i].pweight * zero_fraction * (depth - i) / static_cast<double>(depth + 1);
+			}
+			else {
+				path[i].pweight = (path[i].pweight * (depth + 1)) / static_cast<double>(zero_fraction * (depth - i));
+			}
+		}
+		for (int i = path_index; i < depth; ++i) {
+			path[i].feature_index = path[i + 1].feature_index;
+			path[i].zero_fraction = path[i + 1].zero_fraction;
+			path[i].one_fraction = path[i + 1].one_fraction;
+		}
+	}
+
+	double unwound_path_sum(const PathElement* path, int depth, int path_index) {
+		const double one_fraction = path[path_index].one_fraction;
+		const double zero_fraction = path[path_index].zero_fraction;
+		double next_one_portion = path[depth].pweight;
+		double total = 0.0;
+		for (int i = depth - 1; i >= 0; --i) {
+			if (one_fraction != 0) {
+				const double tmp = next_one_portion * (depth + 1) / static_cast<double>((i + 1) * one_fraction);
+				total += tmp;
+				next_one_portion = path[i].pweight - tmp * zero_fraction * ((depth - i) / static_cast<double>(depth + 1));
+			}
+			else {
+				total += (path[i].pweight / zero_fraction) / ((depth - i) / static_cast<double>(depth + 1));
+			}
+		}
+		return total;
+	}
+
+	double data_count(const LgbmTree& tree, int node) {
+		return node >= 0 ? tree.internal_count[node] : tree.leaf_count[~node];
+	}
+
+	void tree_shap(const LgbmTree& tree, const double* x, double* phi, int node, int depth,
+		PathElement* parent_path, double parent_zero_fraction, double parent_one_fraction, int parent_feature) {
+		PathElement* path = parent_path + depth;
+		if (depth > 0) copy(parent_path, parent_path + depth, path);
+		extend_path(path, depth, parent_zero_fraction, parent_one_fraction, parent_feature);
+
+		if (node < 0) {
+			double leaf = tree.leaf_value[~node];
+			for (int i = 1; i <= depth; ++i) {
+				const double w = unwound_path_sum(path, depth, i);
+				phi[path[i].feature_index] += w * (path[i].one_fraction - path[i].zero_fraction) * leaf;
+			}
+			return;
+		}
+		const int feature = tree.split_feature[node];
+		const int hot = tree.next_node(node, x[feature]);
+		const int cold = hot == tree.left_child[node] ? tree.right_child[node] : tree.left_child[node];
+		const double w = data_count(tree, node);
+		const double hot_zero_fraction = data_count(tree, hot) / w;
+		const double cold_zero_fraction = data_count(tree, cold) / w;
+		double incoming_zero_fraction = 1.0;
+		double incoming_one_fraction = 1.0;
+
+		// Si la feature ya estaba en el camino se deshace su extensión anterior
+		int path_index = 0;
+		for (; path_index <= depth; ++path_index) {
+			if (path[path_index].feature_index == feature) break;
+		}
+		if (path_index != depth + 1) {
+			incoming_zero_fraction = path[path_index].zero_fraction;
+			incoming_one_fraction = path[path_index].one_fraction;
+			unwind_path(path, depth, path_index);
+			depth -= 1;
+		}
+		tree_shap(tree, x, phi, hot, depth + 1, path, hot_zero_fraction * incoming_zero_fraction,
+			incoming_one_fraction, feature);
+		tree_shap(tree, x, phi, cold, depth + 1, path, cold_zero_fraction * incoming_zero_fraction, 0.0, feature);
+	}
+
+	int tree_depth(const LgbmTree& tree, int node) {
+		if (node < 0 || tree.num_leaves == 1) return 0;
+		return 1 + max(tree_depth(tree, tree.left_child[node]), tree_depth(tree, tree.right_child[node]));
+	}
+
+	double expected_value(const LgbmTree& tree) {
+		if (tree.num_leaves == 1) return tree.leaf_value[0];
+		double total = tree.internal_count[0];
+		double value = 0.0;
+		for (int i = 0; i < tree.num_leaves; ++i) value += tree.leaf_count[i] / total * tree.leaf_value[i];
+		return value;
+	}
+
+	// ---- Interventional: Shapley exacto de f(x) frente a una fila de fondo z ----
+	// Una hoja se alcanza si la coalición incluye las features donde se siguió a x
+	// (on_x) y excluye aquellas donde se siguió a z (on_z). Con a = |on_x| y
+	// b = |on_z|: cada i de on_x suma v*(a-1)!b!/(a+b)! y cada i de on_z resta v*a!(b-1)!/(a+b)!.
+	struct InterventionalState {
+		const LgbmTree* tree;
+		const double* x;
+		const double* z;
+		double* phi;
+		const vector<double>* factorial;
+		vector<int> on_x;
+		vector<int> on_z;
+	};
+
+	void interventional(InterventionalState& s, int node) {
+		const LgbmTree& tree = *s.tree;
+		if (node < 0) {
+			size_t a = s.on_x.size(), b = s.on_z.size();
+			if (a + b == 0) return;
+			const vector<double>& fact = *s.factorial;
+			double v = tree.leaf_value[~node];
+			if (a > 0) {
+				double wx = v * fact[a - 1] * fact[b] / fact[a + b];
+				for (int f : s.on_x) s.phi[f] += wx;
+			}
+			if (b > 0) {
+				double wz = v * fact[a] * fact[b - 1] / fact[a + b];
+				for (int f : s.on_z) s.phi[f] -= wz;
+			}
+			return;
+		}
+		int feature = tree.split_feature[node];
+		int next_x = tree.next_node(node, s.x[feature]);
+		int next_z = tree.next_node(node, s.z[feature]);
+		if (find(s.on_x.begin(), s.on_x.end(), feature) != s.on_x.end()) {
+			interventional(s, next_x);
+		}
+		else if (find(s.on_z.begin(), s.on_z.end(), feature) != s.on_z.end()) {
+			interventional(s, next_z);
+		}
+		else if (next_x == next_z) {
+			interventional(s, next_x);
+		}
+		else {
+			s.on_x.push_back(feature);
+			interventional(s, next_x);
+			s.on_x.pop_back();
+			s.on_z.push_back(feature);
+			interventional(s, next_z);
+			s.on_z.pop_back();
+		}
+	}
+} // namespace
+
+ShapResult compute_shap(const LgbmModel& model, const DenseDataset& data, const ShapOptions& options) {
+	TraceSpan span("tree_shap", "modelo");
+	auto start = chrono::steady_clock::now();
+	ShapResult result;
+	result.num_classes = model.num_tree_per_iteration();
+	result.num_features = model.num_features();
+	result.rows = data.rows();
+	if (result.rows == 0 || data.num_features < result.num_features) {
+		result.rows = 0;
+		return result;
+	}
+	const vector<LgbmTree>& trees = model.trees();
+	const int k = result.num_classes;
+	const int nf = result.num_features;
+	const size_t stride = result.stride();
+	result.values.assign(result.rows * stride, 0.0f);
+
+	// Fondo: muestra equiespaciada del dataset de fondo
+	vector<const double*> background;
+	if (options.background && options.background->rows() > 0 && options.background->num_features >= nf) {
+		size_t total = options.background->rows();
+		size_t count = min(total, max<size_t>(1, options.max_background));
+		for (size_t i = 0; i < count; ++i) background.push_back(options.background->row(i * total / count));
+	}
+	result.background_rows = background.size();
+
+	int max_depth = 0;
+	for (const LgbmTree& tree : trees) max_depth = max(max_depth, tree_depth(tree, 0));
+	vector<double> factorial(2 * max_depth + 2, 1.0);
+	for (size_t i = 1; i < factorial.size(); ++i) factorial[i] = factorial[i - 1] * static_cast<double>(i);
+
+	// Valor esperado por clase: promedio de los nodos (path-dependent) o de f(z) sobre el fondo
+	vector<double> base(k, 0.0);
+	if (background.empty()) {
+		for (size_t t = 0; t < trees.size(); ++t) base[t % k] += expected_value(trees[t]);
+	}
+	else {
+		vector<double> raw(k);
+		for (const double* z : background) {
+			model.predict_raw(z, raw.data());
+			for (int c = 0; c < k; ++c) base[c] += raw[c] / background.size();
+		}
+	}
+
+	int threads = options.num_threads > 0 ? options.num_threads : static_cast<int>(thread::hardware_concurrency());
+	const size_t block = 16;
+	threads = static_cast<int>(min<size_t>(max(1, threads), (result.rows + block - 1) / block));
+	result.threads = threads;
+
+	atomic<size_t> next{ 0 };
+	auto worker = [&]() {
+		vector<double> phi(stride);
+		vector<PathElement> path_buffer(static_cast<size_t>(max_depth + 2) * (max_depth + 3) / 2);
+		vector<double> tree_phi(nf + 1);
+		InterventionalState state;
+		state.factorial = &factorial;
+		for (size_t begin = next.fetch_add(block); begin < result.rows; begin = next.fetch_add(block)) {
+			size_t end = min(result.rows, begin + block);
+			for (size_t i = begin; i < end; ++i) {
+				const double* x = data.row(i);
+				fill(phi.begin(), phi.end(), 0.0);
+				for (size_t t = 0; t < trees.size(); ++t) {
+					const LgbmTree& tree = trees[t];
+					if (tree.num_leaves == 1) continue;
+					double* out = phi.data() + (t % k) * (nf + 1);
+					if (background.empty()) {
+						tree_shap(tree, x, out, 0, 0, path_buffer.data(), 1.0, 1.0, -1);
+						continue;
+					}
+					fill(tree_phi.begin(), tree_phi.end(), 0.0);
+					state.tree = &tree;
+					state.x = x;
+					state.phi = tree_phi.data();
+					for (const double* z : background) {
+						state.z = z;
+						interventional(state, 0);
+					}
+					for (int f = 0; f < nf; ++f) out[f] += tree_phi[f] / background.size();
+				}
+				float* dest = result.values.data() + i * stride;
+				for (int c = 0; c < k; ++c) {
+					phi[c * (nf + 1) + nf] = base[c];
+					for (int f = 0; f <= nf; ++f) dest[c * (nf + 1) + f] = static_cast<float>(phi[c * (nf + 1) + f]);
+				}
+			}
+		}
+	};
+	vector<thread> pool;
+	for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+	worker();
+	for (auto& th : pool) th.join();
+	result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+vector<double> mean_abs_shap(const ShapResult& result) {
+	int nf = result.num_features;
+	vector<double> mean(static_cast<size_t>(result.num_classes) * nf, 0.0);
+	if (result.rows == 0) return mean;
+	for (size_t i = 0; i < result.rows; ++i) {
+		const float* row = result.values.data() + i * result.stride();
+		for (int c = 0; c < result.num_classes; ++c) {
+			for (int f = 0; f < nf; ++f) mean[c * nf + f] += fabs(row[c * (nf + 1) + f]);
+		}
+	}
+	for (double& v : mean) v /= result.rows;
+	return mean;
+}
+
+bool save_shap_binary(const fs::path& path, const ShapResult& result) {
+	ofstream file(path, ios::binary);
+	if (!file) return false;
+	uint32_t classes = static_cast<uint32_t>(result.num_classes);
+	uint32_t features = static_cast<uint32_t>(result.num_features);
+	uint64_t rows = result.rows;
+	file.write("SHP1", 4);
+	file.write(reinterpret_cast<const char*>(&classes), sizeof(classes));
+	file.write(reinterpret_cast<const char*>(&features), sizeof(features));
+	file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+	file.write(reinterpret_cast<const char*>(result.values.data()), static_cast<streamsize>(result.values.size() * sizeof(float)));
+	return static_cast<bool>(file);
+}
+
+bool save_shap_csv(const fs::path& path, const ShapResult& result, const vector<string>& feature_names) {
+	ofstream file(path);
+	if (!file) return false;
+	file << "fila,clase";
+	for (int f = 0; f < result.num_features; ++f) file << "," << feature_names[f];
+	file << ",valor_esperado\n";
+	for (size_t i = 0; i < result.rows; ++i) {
+		const float* row = result.values.data() + i * result.stride();
+		for (int c = 0; c < result.num_classes; ++c) {
+			file << i << "," << c;
+			for (int f = 0; f <= result.num_features; ++f) file << "," << row[c * (result.num_features + 1) + f];
+			file << "\n";
+		}
+	}
+	return static_cast<bool>(file);
+}
+
+bool save_shap_summary_csv(const fs::path& path, const ShapResult& result, const vector<string>& feature_names) {
+	ofstream file(path);
+	if (!file) return false;
+	int nf = result.num_features;
+	vector<double> mean = mean_abs_shap(result);
+	vector<double> total(nf, 0.0);
+	for (int c = 0; c < result.num_classes; ++c) {
+		for (int f = 0; f < nf; ++f) total[f] += mean[c * nf + f];
+	}
+	vector<int> order(nf);
+	iota(order.begin(), order.end(), 0);
+	stable_sort(order.begin(), order.end(), [&](int a, int b) { return total[a] > total[b]; });
+
+	file << "feature,nombre";
+	for (int c = 0; c < result.num_classes; ++c) file << ",media_abs_clase_" << c;
+	file << ",media_abs_total\n";
+	for (int f : order) {
+		file << f << "," << feature_names[f];
+		for (int c = 0; c < result.num_classes; ++c) file << "," << mean[c * nf + f];
+		file << "," << total[f] << "\n";
+	}
+	return static_cast<bool>(file);
+}
+
+double compare_with_pred_contrib(const ShapResult& result, const fs::path& contrib_file) {
+	int cols = 0;
+	vector<double> reference = read_probabilities(contrib_file.string(), cols);
+	if (cols != static_cast<int>(result.stride()) || reference.empty()) return -1.0;
+	size_t values = min(reference.size(), result.values.size());
+	double max_diff = 0.0;
+	for (size_t i = 0; i < values; ++i) max_diff = max(max_diff, fabs(reference[i] - static_cast<double>(result.values[i])));
+	return max_diff;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "lgbm_model.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Valores SHAP de un modelo LightGBM en proceso (puntaje crudo, como pred_contrib).
+//   path-dependent: TreeSHAP de Lundberg con las cuentas de datos de cada nodo
+//                   (leaf_count / internal_count); coincide con pred_contrib de LightGBM.
+//   interventional: con un dataset de fondo, Shapley exacto de f(x) frente a cada
+//                   fila de fondo z, promediado sobre el fondo.
+// Las filas se reparten entre hilos; cada hilo usa sus propios buffers.
+struct ShapOptions {
+	int num_threads = 0;                      // 0 = hardware_concurrency
+	const DenseDataset* background = nullptr; // != nullptr: modo interventional
+	size_t max_background = 100;              // filas de fondo (muestra equiespaciada)
+};
+
+// values: filas x clases x (features + 1), la última columna de cada clase es el
+// valor esperado (mismo orden que la salida de pred_contrib de LightGBM)
+struct ShapResult {
+	int num_classes = 0;
+	int num_features = 0;
+	size_t rows = 0;
+	size_t background_rows = 0;               // 0 = path-dependent
+	int threads = 0;
+	double seconds = 0.0;
+	std::vector<float> values;
+
+	size_t stride() const { return static_cast<size_t>(num_classes) * (num_features + 1); }
+	double rows_per_second() const { return seconds > 0.0 ? rows / seconds : 0.0; }
+};
+
+ShapResult compute_shap(const LgbmModel& model, const DenseDataset& data, const ShapOptions& options);
+
+// Media de |SHAP| por clase y feature (clases x features)
+std::vector<double> mean_abs_shap(const ShapResult& result);
+
+// "SHP1" | uint32 clases | uint32 features | uint64 filas | float32 valores[filas x clases x (features + 1)]
+bool save_shap_binary(const std::filesystem::path& path, const ShapResult& result);
+
+bool save_shap_csv(const std::filesystem::path& path, const ShapResult& result, const std::vector<std::string>& feature_names);
+
+// feature, nombre, media |SHAP| por clase y total (suma sobre clases), ordenado por total
+bool save_shap_summary_csv(const std::filesystem::path& path, const ShapResult& result,
+	const std::vector<std::string>& feature_names);
+
+// Máxima diferencia absoluta contra la salida de LightGBM con predict_contrib=true
+// (primeras filas de result). Devuelve -1 si el archivo no es comparable.
+double compare_with_pred_contrib(const ShapResult& result, const std::filesystem::path& contrib_file);
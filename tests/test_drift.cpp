@@ -0,0 +1,72 @@
+#include "test_models.hpp"
+#include "drift_monitor.hpp"
+
+#include <cmath>
+
+using namespace std;
+
+// PSI y KS sobre distribuciones sintéticas:
+//   igual      misma muestra uniforme en train y test       -> PSI = KS = 0
+//   corrida    uniforme [0, 1) contra [0.5, 1.5)            -> KS = 0.5, PSI alto
+//   faltantes  misma uniforme, 1 de cada 4 vacía en test    -> KS = 0, fracción 0.25
+
+namespace {
+	const size_t ROWS = 20000;
+
+	bool write_csv(const filesystem::path& path, bool shifted) {
+		ofstream out(path);
+		out << "igual,corrida,faltantes\n";
+		for (size_t i = 0; i < ROWS; ++i) {
+			// Grilla uniforme, permutada entre columnas para que no estén correlacionadas
+			double u = (i + 0.5) / ROWS;
+			double v = ((i * 7919) % ROWS + 0.5) / ROWS;
+			double w = ((i * 104729) % ROWS + 0.5) / ROWS;
+			out << u << "," << (shifted ? v + 0.5 : v) << ",";
+			if (!(shifted && i % 4 == 0)) out << w;
+			out << "\n";
+		}
+		return static_cast<bool>(out);
+	}
+} // namespace
+
+int main() {
+	TempFile train_file("drift_train.csv");
+	TempFile test_file("drift_test.csv");
+	check(write_csv(train_file.path, false) && write_csv(test_file.path, true), "escribir CSV");
+
+	DriftOptions options;
+	options.num_threads = 2;
+	options.chunk_bytes = 64 << 10;   // varios bloques por archivo
+	DatasetProfile train = profile_dataset(train_file.path, -1, true, -1, options);
+	DatasetProfile test = profile_dataset(test_file.path, -1, true, -1, options);
+	check(train.ok && test.ok, "perfilar ambos archivos");
+	check(train.rows == ROWS && test.rows == ROWS, "filas leídas");
+	if (!train.ok || !test.ok) return failures();
+
+	vector<FeatureDrift> drift = compare_profiles(train, test, options.psi_bins);
+	check(drift.size() == 3, "una fila de drift por feature");
+	if (drift.size() != 3) return failures();
+	const FeatureDrift* same = nullptr;
+	const FeatureDrift* shifted = nullptr;
+	const FeatureDrift* missing = nullptr;
+	for (const FeatureDrift& d : drift) {
+		if (d.name == "igual") same = &d;
+		else if (d.name == "corrida") shifted = &d;
+		else if (d.name == "faltantes") missing = &d;
+	}
+	check(same && shifted && missing, "nombres del header");
+	if (!same || !shifted || !missing) return failures();
+
+	check_near(same->psi, 0.0, 1e-9, "PSI igual");
+	check_near(same->ks, 0.0, 1e-9, "KS igual");
+
+	// Los sketches tienen 1% de error relativo: el KS puede correrse un bucket
+	check_near(shifted->ks, 0.5, 0.02, "KS corrida");
+	check(shifted->psi > 1.0, "PSI corrida muy por encima del umbral 0.25: " + to_string(shifted->psi));
+
+	check_near(missing->train_missing, 0.0, 1e-12, "faltantes en train");
+	check_near(missing->test_missing, 0.25, 1e-12, "faltantes en test");
+	check_near(missing->ks, 0.0, 0.02, "KS faltantes (sólo valores presentes)");
+	check(missing->psi > 0.0, "PSI cuenta el bin de faltantes: " + to_string(missing->psi));
+	return failures();
+}
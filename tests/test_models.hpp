@@ -0,0 +1,227 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Utilidades de las pruebas unitarias: modelos LightGBM escritos a mano en formato
+// texto (el mismo que produce save_model) y filas con faltantes, ceros y categorías.
+
+// Cuenta los fallos y los informa; main devuelve failures() como código de salida
+inline int& test_failures() {
+	static int failures = 0;
+	return failures;
+}
+
+inline void check(bool ok, const std::string& what) {
+	if (!ok) {
+		std::cerr << "[FALLA] " << what << std::endl;
+		test_failures()++;
+	}
+}
+
+inline void check_near(double actual, double expected, double tolerance, const std::string& what) {
+	std::ostringstream msg;
+	msg << std::setprecision(10) << what << ": " << actual << " (esperado " << expected << ")";
+	check(std::fabs(actual - expected) <= tolerance, msg.str());
+}
+
+inline int failures() {
+	if (test_failures() == 0) std::cout << "OK" << std::endl;
+	return test_failures() == 0 ? 0 : 1;
+}
+
+// Archivo temporal propio de la prueba (se borra al destruirse)
+struct TempFile {
+	std::filesystem::path path;
+	explicit TempFile(const std::string& name)
+		: path(std::filesystem::temp_directory_path() / (name + "_" + std::to_string(std::random_device{}()))) {}
+	~TempFile() {
+		std::error_code ec;
+		std::filesystem::remove(path, ec);
+	}
+};
+
+// Modelo de regresión de 2 features con resultados calculables a mano:
+//   árbol 0: f0 <= 0.5, faltante NaN a la izquierda   hojas 1 / 2     (cuentas 30 / 10)
+//   árbol 1: f0 <= 1.5, faltante cero a la derecha    hojas 10 / 20   (cuentas 20 / 20)
+//   árbol 2: f1 en {1, 3} (categórico, sin faltantes) hojas 100 / 200 (cuentas 10 / 30)
+inline std::string fixed_model_text() {
+	return "tree\nversion=v4\nnum_class=1\nnum_tree_per_iteration=1\nlabel_index=0\nmax_feature_idx=1\n"
+		"objective=regression\nfeature_names=f0 f1\n\n"
+		"Tree=0\nnum_leaves=2\nnum_cat=0\nsplit_feature=0\nthreshold=0.5\ndecision_type=10\n"
+		"left_child=-1\nright_child=-2\nleaf_value=1 2\nleaf_count=30 10\ninternal_value=1.25\ninternal_count=40\n\n"
+		"Tree=1\nnum_leaves=2\nnum_cat=0\nsplit_feature=0\nthreshold=1.5\ndecision_type=4\n"
+		"left_child=-1\nright_child=-2\nleaf_value=10 20\nleaf_count=20 20\ninternal_value=15\ninternal_count=40\n\n"
+		"Tree=2\nnum_leaves=2\nnum_cat=1\nsplit_feature=1\nthreshold=0\ndecision_type=1\n"
+		"left_child=-1\nright_child=-2\nleaf_value=100 200\nleaf_count=10 30\ninternal_value=175\ninternal_count=40\n"
+		"cat_boundaries=0 1\ncat_threshold=10\n\n"
+		"end of trees\n";
+}
+
+// Árbol aleatorio con cuentas consistentes (cada nodo interno suma las de sus hijos,
+// como exige TreeSHAP path-dependent). Las features 0..num_features-2 son numéricas
+// con los tres tipos de faltante; la última es categórica (1 o 2 palabras de bits).
+class RandomTreeWriter {
+public:
+	RandomTreeWriter(std::mt19937& rng, int num_features) : rng_(rng), num_features_(num_features) {}
+
+	// chain = true: cada nodo deja una hoja a la izquierda (profundidad leaves - 1)
+	std::string tree(int index, int leaves, bool chain) {
+		feature_.clear(); decision_type_.clear(); left_.clear(); right_.clear();
+		threshold_.clear(); internal_value_.clear(); internal_count_.clear(); leaf_value_.clear(); leaf_count_.clear();
+		cat_boundaries_.assign(1, 0);
+		cat_threshold_.clear();
+		double count = 0.0, value = 0.0;
+		if (leaves > 1) build(leaves, chain, count, value);
+		else add_leaf(count, value);
+
+		std::ostringstream out;
+		out << std::setprecision(17);
+		out << "Tree=" << index << "\nnum_leaves=" << leaves << "\nnum_cat=" << cat_boundaries_.size() - 1 << "\n";
+		if (leaves > 1) {
+			write(out, "split_feature", feature_);
+			write(out, "threshold", threshold_);
+			write(out, "decision_type", decision_type_);
+			write(out, "left_child", left_);
+			write(out, "right_child", right_);
+		}
+		write(out, "leaf_value", leaf_value_);
+		write(out, "leaf_count", leaf_count_);
+		if (leaves > 1) {
+			write(out, "internal_value", internal_value_);
+			write(out, "internal_count", internal_count_);
+		}
+		if (cat_boundaries_.size() > 1) {
+			write(out, "cat_boundaries", cat_boundaries_);
+			write(out, "cat_threshold", cat_threshold_);
+		}
+		out << "\n";
+		return out.str();
+	}
+
+	// Umbrales numéricos posibles (las filas de prueba los repiten exactos)
+	static const std::vector<double>& thresholds() {
+		static const std::vector<double> values = { -0.5, 0.0, 0.5, 1.5, 2.5 };
+		return values;
+	}
+
+private:
+	int add_leaf(double& count, double& value) {
+		value = std::uniform_real_distribution<double>(-1.0, 1.0)(rng_);
+		count = static_cast<double>(1 + rng_() % 20);
+		leaf_value_.push_back(value);
+		leaf_count_.push_back(count);
+		return ~static_cast<int>(leaf_value_.size() - 1);
+	}
+
+	int build(int leaves, bool chain, double& count, double& value) {
+		if (leaves == 1) return add_leaf(count, value);
+		int node = static_cast<int>(feature_.size());
+		int feature = static_cast<int>(rng_() % num_features_);
+		feature_.push_back(feature);
+		if (feature == num_features_ - 1) {
+			// Categórico: threshold = índice en cat_boundaries; NaN a la derecha o como categoría 0
+			decision_type_.push_back(1 | ((rng_() % 2) ? (2 << 2) : 0));
+			threshold_.push_back(static_cast<double>(cat_boundaries_.size() - 1));
+			int words = 1 + static_cast<int>(rng_() % 2);
+			for (int w = 0; w < words; ++w) cat_threshold_.push_back(static_cast<uint32_t>(rng_()));
+			cat_boundaries_.push_back(static_cast<int>(cat_threshold_.size()));
+		}
+		else {
+			int missing_type = static_cast<int>(rng_() % 3);
+			int default_left = static_cast<int>(rng_() % 2);
+			decision_type_.push_back((default_left ? 2 : 0) | (missing_type << 2));
+			threshold_.push_back(thresholds()[rng_() % thresholds().size()]);
+		}
+		left_.push_back(0);
+		right_.push_back(0);
+		internal_value_.push_back(0.0);
+		internal_count_.push_back(0.0);
+
+		int left_leaves = chain ? 1 : 1 + static_cast<int>(rng_() % (leaves - 1));
+		double left_count, left_value, right_count, right_value;
+		int left = build(left_leaves, chain, left_count, left_value);
+		int right = build(leaves - left_leaves, chain, right_count, right_value);
+		left_[node] = left;
+		right_[node] = right;
+		count = left_count + right_count;
+		value = (left_value * left_count + right_value * right_count) / count;
+		internal_count_[node] = count;
+		internal_value_[node] = value;
+		return node;
+	}
+
+	template <typename T>
+	static void write(std::ostringstream& out, const char* key, const std::vector<T>& values) {
+		out << key << "=";
+		for (size_t i = 0; i < values.size(); ++i) out << (i ? " " : "") << +values[i];
+		out << "\n";
+	}
+
+	std::mt19937& rng_;
+	int num_features_;
+	std::vector<int> feature_, decision_type_, left_, right_;
+	std::vector<double> threshold_, internal_value_, internal_count_, leaf_value_, leaf_count_;
+	std::vector<int> cat_boundaries_ = { 0 };
+	std::vector<uint32_t> cat_threshold_;
+};
+
+// Modelo multiclase aleatorio: iterations x num_class árboles de 2 a 16 hojas, más
+// una iteración con una cadena de 70 hojas (fuera del bitvector de 64), un árbol de
+// 64 hojas exactas y uno de una sola hoja
+inline std::string random_model_text(std::mt19937& rng, int num_class, int num_features, int iterations) {
+	std::ostringstream out;
+	out << "tree\nversion=v4\nnum_class=" << num_class << "\nnum_tree_per_iteration=" << num_class
+		<< "\nlabel_index=0\nmax_feature_idx=" << num_features - 1 << "\nobjective=multiclass num_class:" << num_class
+		<< "\nfeature_names=";
+	for (int f = 0; f < num_features; ++f) out << (f ? " " : "") << "f" << f;
+	out << "\n\n";
+	RandomTreeWriter writer(rng, num_features);
+	int index = 0;
+	for (int it = 0; it < iterations; ++it) {
+		for (int c = 0; c < num_class; ++c, ++index) out << writer.tree(index, 2 + static_cast<int>(rng() % 15), false);
+	}
+	for (int c = 0; c < num_class; ++c, ++index) {
+		int leaves = c == 0 ? 70 : (c == 1 ? 64 : 1);
+		out << writer.tree(index, leaves, c == 0);
+	}
+	out << "end of trees\n";
+	return out.str();
+}
+
+// Filas con NaN, ceros (también -0.0), valores iguales a los umbrales y, en la
+// última feature, categorías enteras de 0 a 63, negativas y no enteras
+inline std::vector<double> random_rows(std::mt19937& rng, size_t rows, int num_features) {
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	std::vector<double> values(rows * num_features);
+	for (size_t i = 0; i < rows; ++i) {
+		for (int f = 0; f < num_features; ++f) {
+			double& v = values[i * num_features + f];
+			unsigned pick = rng() % 10;
+			if (pick == 0) v = nan;
+			else if (pick == 1) v = (rng() % 2) ? 0.0 : -0.0;
+			else if (f == num_features - 1) {
+				if (pick == 2) v = -1.0;
+				else if (pick == 3) v = 1.7;
+				else v = static_cast<double>(rng() % 64);
+			}
+			else if (pick < 5) v = RandomTreeWriter::thresholds()[rng() % RandomTreeWriter::thresholds().size()];
+			else v = std::uniform_real_distribution<double>(-1.0, 3.0)(rng);
+		}
+	}
+	return values;
+}
+
+inline bool write_text(const std::filesystem::path& path, const std::string& text) {
+	std::ofstream out(path);
+	out << text;
+	return static_cast<bool>(out);
+}
@@ -0,0 +1,95 @@
+#include "test_models.hpp"
+#include "lgbm_model.hpp"
+#include "quickscorer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+// QuickScorer (kernel escalar y AVX2) contra el predictor por recorrido: primero un
+// modelo con resultados calculados a mano, después uno aleatorio con faltantes NaN y
+// cero, splits categóricos y un árbol de más de 64 hojas que va por recorrido.
+
+namespace {
+	const double NaN = numeric_limits<double>::quiet_NaN();
+
+	// Máxima diferencia entre QuickScorer y predict_raw fila a fila
+	double max_diff_vs_traversal(const LgbmModel& model, const QuickScorer& scorer, const vector<double>& rows) {
+		int nf = model.num_features();
+		int k = model.num_tree_per_iteration();
+		size_t count = rows.size() / nf;
+		vector<double> fast(count * k), slow(k);
+		scorer.predict_raw(rows.data(), count, nf, fast.data());
+		double diff = 0.0;
+		for (size_t i = 0; i < count; ++i) {
+			model.predict_raw(rows.data() + i * nf, slow.data());
+			for (int c = 0; c < k; ++c) diff = max(diff, fabs(fast[i * k + c] - slow[c]));
+		}
+		return diff;
+	}
+
+	void test_fixed_model() {
+		TempFile file("qs_fijo.txt");
+		LgbmModel model;
+		check(write_text(file.path, fixed_model_text()) && model.load(file.path), "cargar modelo fijo");
+		if (model.trees().empty()) return;
+
+		// f0, f1 -> puntaje esperado (árbol 0 + árbol 1 + árbol 2)
+		struct Case { double f0, f1, expected; };
+		const vector<Case> cases = {
+			{ 0.2, 1.0, 1 + 10 + 100 },   // todo a la izquierda
+			{ NaN, 3.0, 1 + 20 + 100 },   // NaN: izquierda en el árbol 0, cero faltante a la derecha en el 1
+			{ 0.0, 2.0, 1 + 20 + 200 },   // cero faltante a la derecha; categoría 2 fuera del conjunto
+			{ 2.0, NaN, 2 + 20 + 200 },   // categórico sin faltantes: NaN es la categoría 0
+			{ 1.0, -1.0, 2 + 10 + 200 },  // categoría negativa a la derecha
+			{ 0.5, 35.0, 1 + 10 + 200 },  // umbral exacto a la izquierda; categoría fuera de las palabras
+		};
+		vector<double> rows;
+		for (const Case& c : cases) {
+			rows.push_back(c.f0);
+			rows.push_back(c.f1);
+		}
+		for (bool avx2 : { false, true }) {
+			QuickScorer scorer(model, avx2);
+			vector<double> out(cases.size());
+			scorer.predict_raw(rows.data(), cases.size(), 2, out.data());
+			for (size_t i = 0; i < cases.size(); ++i) {
+				string name = string(avx2 ? "avx2" : "escalar") + " fila " + to_string(i);
+				check_near(out[i], cases[i].expected, 0.0, name);
+				double slow = 0.0;
+				model.predict_raw(rows.data() + i * 2, &slow);
+				check_near(slow, cases[i].expected, 0.0, "recorrido fila " + to_string(i));
+			}
+		}
+	}
+
+	void test_random_model() {
+		mt19937 rng(20240611);
+		const int num_class = 3, num_features = 4;
+		TempFile file("qs_aleatorio.txt");
+		LgbmModel model;
+		check(write_text(file.path, random_model_text(rng, num_class, num_features, 20)) && model.load(file.path),
+			"cargar modelo aleatorio");
+		if (model.trees().empty()) return;
+
+		// 203 filas: el kernel AVX2 procesa bloques de 4 y el resto fila a fila
+		vector<double> rows = random_rows(rng, 203, num_features);
+		QuickScorer scalar(model, false);
+		QuickScorer vectorized(model, true);
+		check(!scalar.vectorized(), "allow_avx2 = false usa el kernel escalar");
+		check(scalar.fallback_trees() == 1, "sólo el árbol de 70 hojas va por recorrido");
+		check(vectorized.fallback_trees() == 1, "sólo el árbol de 70 hojas va por recorrido (avx2)");
+		check_near(max_diff_vs_traversal(model, scalar, rows), 0.0, 0.0, "escalar vs recorrido");
+		check_near(max_diff_vs_traversal(model, vectorized, rows), 0.0, 0.0, "avx2 vs recorrido");
+		cout << "QuickScorer: " << model.trees().size() << " árboles, kernel "
+			<< (vectorized.vectorized() ? "AVX2" : "escalar (sin AVX2)") << endl;
+	}
+} // namespace
+
+int main() {
+	test_fixed_model();
+	test_random_model();
+	return failures();
+}
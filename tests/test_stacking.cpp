@@ -0,0 +1,82 @@
+#include "test_models.hpp"
+#include "stacking.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Meta-modelo de stacking (L-BFGS) sobre matrices OOF chicas:
+//   separable    cada fila da 0.6 a su clase: L-BFGS puede agrandar los pesos y
+//                llevar la pérdida cerca de 0, con todas las filas bien clasificadas
+//   dos grupos   filas con las mismas probabilidades y etiquetas mezcladas: sin L2
+//                el óptimo reproduce la frecuencia de cada grupo y la pérdida final
+//                es su entropía
+
+namespace {
+	void add_row(OofMatrix& oof, int label, const vector<float>& probs) {
+		oof.row_index.push_back(static_cast<int64_t>(oof.row_index.size()));
+		oof.labels.push_back(label);
+		oof.probs.insert(oof.probs.end(), probs.begin(), probs.end());
+	}
+
+	double entropy(double p) { return -(p * log(p) + (1.0 - p) * log(1.0 - p)); }
+
+	void test_separable() {
+		OofMatrix oof;
+		oof.num_classes = 3;
+		for (int i = 0; i < 300; ++i) {
+			int label = i % 3;
+			vector<float> probs(3, 0.2f);
+			probs[label] = 0.6f;
+			add_row(oof, label, probs);
+		}
+		StackingOptions options;
+		options.l2 = 1e-6;
+		options.num_threads = 2;
+		StackingFit fit = train_stacking_model(oof, options);
+		check_near(fit.initial_loss, -log(0.6f), 1e-6, "separable: pérdida inicial");
+		check(fit.final_loss < 1e-3, "separable: pérdida final cerca de 0: " + to_string(fit.final_loss));
+
+		vector<double> probs(oof.probs.begin(), oof.probs.end());
+		vector<double> calibrated = stacking_predict_proba(fit.model, probs);
+		check(calibrated.size() == probs.size(), "separable: tamaño de la predicción");
+		size_t hits = 0;
+		for (size_t i = 0; i + 3 <= calibrated.size(); i += 3) {
+			int pred = static_cast<int>(max_element(calibrated.begin() + i, calibrated.begin() + i + 3) - (calibrated.begin() + i));
+			if (pred == oof.labels[i / 3]) hits++;
+		}
+		check(hits == oof.rows(), "separable: todas las filas bien clasificadas");
+	}
+
+	void test_two_groups() {
+		// Grupo A: (0.9, 0.1) con 8 etiquetas 0 y 2 etiquetas 1
+		// Grupo B: (0.2, 0.8) con 1 etiqueta 0 y 9 etiquetas 1
+		OofMatrix oof;
+		oof.num_classes = 2;
+		for (int i = 0; i < 10; ++i) add_row(oof, i < 8 ? 0 : 1, { 0.9f, 0.1f });
+		for (int i = 0; i < 10; ++i) add_row(oof, i < 1 ? 0 : 1, { 0.2f, 0.8f });
+		StackingOptions options;
+		options.l2 = 0.0;
+		options.max_iterations = 500;
+		options.tolerance = 1e-12;
+		options.num_threads = 1;
+		StackingFit fit = train_stacking_model(oof, options);
+
+		double initial = -(8 * log(0.9f) + 2 * log(0.1f) + 1 * log(0.2f) + 9 * log(0.8f)) / 20.0;
+		check_near(fit.initial_loss, initial, 1e-6, "dos grupos: pérdida inicial");
+		check_near(fit.final_loss, (entropy(0.8) + entropy(0.1)) / 2.0, 1e-5, "dos grupos: pérdida final");
+
+		vector<double> calibrated = stacking_predict_proba(fit.model, { 0.9, 0.1, 0.2, 0.8 });
+		if (calibrated.size() == 4) {
+			check_near(calibrated[0], 0.8, 1e-3, "dos grupos: frecuencia del grupo A");
+			check_near(calibrated[2], 0.1, 1e-3, "dos grupos: frecuencia del grupo B");
+		}
+	}
+} // namespace
+
+int main() {
+	test_separable();
+	test_two_groups();
+	return failures();
+}
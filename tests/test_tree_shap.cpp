@@ -0,0 +1,102 @@
+#include "test_models.hpp"
+#include "lgbm_model.hpp"
+#include "tree_shap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// TreeSHAP: en el modelo fijo cada árbol usa una sola feature, así que su aporte
+// es f_t(x) - E[f_t] (path-dependent, E por cuentas de hojas) o f_t(x) - f_t(z)
+// (interventional contra una fila de fondo z). En el modelo aleatorio se verifica
+// la aditividad: suma de aportes + valor esperado == puntaje crudo.
+
+namespace {
+	const double TOLERANCE = 1e-4;   // los valores se guardan en float
+
+	DenseDataset make_dataset(int num_features, vector<double> values) {
+		DenseDataset data;
+		data.num_features = num_features;
+		data.values = move(values);
+		return data;
+	}
+
+	// Máxima diferencia |suma de aportes + valor esperado - puntaje crudo|
+	double max_additivity_error(const LgbmModel& model, const DenseDataset& data, const ShapResult& result) {
+		int k = model.num_tree_per_iteration();
+		int nf = model.num_features();
+		vector<double> raw(k);
+		double diff = 0.0;
+		for (size_t i = 0; i < data.rows(); ++i) {
+			model.predict_raw(data.row(i), raw.data());
+			for (int c = 0; c < k; ++c) {
+				const float* phi = result.values.data() + i * result.stride() + static_cast<size_t>(c) * (nf + 1);
+				double sum = 0.0;
+				for (int f = 0; f <= nf; ++f) sum += phi[f];
+				diff = max(diff, fabs(sum - raw[c]));
+			}
+		}
+		return diff;
+	}
+
+	void test_fixed_model() {
+		TempFile file("shap_fijo.txt");
+		LgbmModel model;
+		check(write_text(file.path, fixed_model_text()) && model.load(file.path), "cargar modelo fijo");
+		if (model.trees().empty()) return;
+
+		// x = (0.2, 1): hojas 1, 10 y 100; valores esperados 1.25, 15 y 175
+		DenseDataset data = make_dataset(2, { 0.2, 1.0 });
+		ShapOptions options;
+		options.num_threads = 1;
+		ShapResult path = compute_shap(model, data, options);
+		check(path.values.size() == 3, "path-dependent: 1 fila x 1 clase x (2 + 1)");
+		if (path.values.size() == 3) {
+			check_near(path.values[0], (1 - 1.25) + (10 - 15), TOLERANCE, "path-dependent f0");
+			check_near(path.values[1], 100 - 175, TOLERANCE, "path-dependent f1");
+			check_near(path.values[2], 1.25 + 15 + 175, TOLERANCE, "path-dependent valor esperado");
+		}
+
+		// Fondo z = (2, 2): hojas 2, 20 y 200
+		DenseDataset background = make_dataset(2, { 2.0, 2.0 });
+		options.background = &background;
+		ShapResult inter = compute_shap(model, data, options);
+		check(inter.background_rows == 1, "interventional: una fila de fondo");
+		if (inter.values.size() == 3) {
+			check_near(inter.values[0], (1 - 2) + (10 - 20), TOLERANCE, "interventional f0");
+			check_near(inter.values[1], 100 - 200, TOLERANCE, "interventional f1");
+			check_near(inter.values[2], 2 + 20 + 200, TOLERANCE, "interventional valor esperado");
+		}
+	}
+
+	void test_additivity() {
+		mt19937 rng(7);
+		const int num_class = 3, num_features = 4;
+		TempFile file("shap_aleatorio.txt");
+		LgbmModel model;
+		check(write_text(file.path, random_model_text(rng, num_class, num_features, 10)) && model.load(file.path),
+			"cargar modelo aleatorio");
+		if (model.trees().empty()) return;
+
+		DenseDataset data = make_dataset(num_features, random_rows(rng, 64, num_features));
+		DenseDataset background = make_dataset(num_features, random_rows(rng, 37, num_features));
+		ShapOptions options;
+		options.num_threads = 2;
+		ShapResult path = compute_shap(model, data, options);
+		check(path.rows == data.rows() && path.values.size() == data.rows() * path.stride(), "path-dependent: tamaño");
+		check_near(max_additivity_error(model, data, path), 0.0, TOLERANCE, "aditividad path-dependent");
+
+		options.background = &background;
+		ShapResult inter = compute_shap(model, data, options);
+		check(inter.background_rows == background.rows(), "interventional: usa todo el fondo");
+		check(inter.values.size() == data.rows() * inter.stride(), "interventional: tamaño");
+		check_near(max_additivity_error(model, data, inter), 0.0, TOLERANCE, "aditividad interventional");
+	}
+} // namespace
+
+int main() {
+	test_fixed_model();
+	test_additivity();
+	return failures();
+}